@@ -0,0 +1,532 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Benchmark/TwitchBenchmark.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "Chatters/TwitchChatterRegistry.h"
+#include "Emotes/TwitchEmoteCounter.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/MemoryBase.h"
+#include "LogTwitch.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Misc/StringBuilder.h"
+#include "Network/TwitchMockIrcServer.h"
+#include "Parsing/TwitchIrcMessage.h"
+#include "Runnables/TwitchMessageReceiver.h"
+#include "Subsystems/TwitchSubsystem.h"
+
+namespace
+{
+	/**
+	 * Counts the heap allocations made by one thread, everything else goes straight to the real allocator.
+	 * Installed as GMalloc only while a benchmark runs. It never frees anything itself, so blocks allocated
+	 * before or after it was installed are handled the same way.
+	 */
+	class FCountingMalloc final : public FMalloc
+	{
+	public:
+
+		void Install()
+		{
+			check(GMalloc != this);
+			Inner = GMalloc;
+			ThreadId = FPlatformTLS::GetCurrentThreadId();
+			NumAllocations = 0;
+			GMalloc = this;
+		}
+
+		void Uninstall()
+		{
+			check(GMalloc == this);
+			GMalloc = Inner;
+		}
+
+		// Allocations since the last call
+		int64 Take()
+		{
+			const int64 Count = NumAllocations;
+			NumAllocations = 0;
+			return Count;
+		}
+
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return Inner->Malloc(Count, Alignment);
+		}
+
+		virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			if (Count > 0)
+			{
+				CountAllocation();
+			}
+			return Inner->Realloc(Original, Count, Alignment);
+		}
+
+		virtual void Free(void* Original) override
+		{
+			Inner->Free(Original);
+		}
+
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override
+		{
+			return Inner->QuantizeSize(Count, Alignment);
+		}
+
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override
+		{
+			return Inner->GetAllocationSize(Original, SizeOut);
+		}
+
+		virtual void Trim(bool bTrimThreadCaches) override
+		{
+			Inner->Trim(bTrimThreadCaches);
+		}
+
+		virtual void SetupTLSCachesOnCurrentThread() override
+		{
+			Inner->SetupTLSCachesOnCurrentThread();
+		}
+
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override
+		{
+			Inner->ClearAndDisableTLSCachesOnCurrentThread();
+		}
+
+		virtual bool IsInternallyThreadSafe() const override
+		{
+			return Inner->IsInternallyThreadSafe();
+		}
+
+		virtual bool ValidateHeap() override
+		{
+			return Inner->ValidateHeap();
+		}
+
+		virtual const TCHAR* GetDescriptiveName() override
+		{
+			return Inner->GetDescriptiveName();
+		}
+
+	private:
+
+		void CountAllocation()
+		{
+			if (FPlatformTLS::GetCurrentThreadId() == ThreadId)
+			{
+				++NumAllocations;
+			}
+		}
+
+		FMalloc* Inner = nullptr;
+		uint32 ThreadId = 0;
+		int64 NumAllocations = 0;
+	};
+
+	// Lives forever, another thread may still be inside it right after it is uninstalled
+	FCountingMalloc& GetCountingMalloc()
+	{
+		static FCountingMalloc CountingMalloc;
+		return CountingMalloc;
+	}
+
+	enum class ECorpus : uint8
+	{
+		Tags,
+		Bits,
+		Unicode,
+		Commands
+	};
+
+	const TCHAR* const CorpusNames[] = { TEXT("tags"), TEXT("bits"), TEXT("unicode"), TEXT("commands") };
+
+	// Commands registered for the command heavy corpus
+	const TCHAR* const BenchmarkCommands[] = { TEXT("jump"), TEXT("left"), TEXT("right"), TEXT("vote"), TEXT("spawn") };
+
+	/**
+	* Generates the lines of a corpus, CRLF terminated, as they come out of the socket.
+	* Users, ids and timestamps change from line to line, so nothing is cached by accident.
+	*/
+	void MakeCorpus(const ECorpus Corpus, const int32 NumLines, const int32 Seed, TArray<uint8>& OutData)
+	{
+		FRandomStream Random(Seed);
+		TAnsiStringBuilder<1024> Line;
+
+		OutData.Reset();
+		for (int32 Index = 0; Index < NumLines; ++Index)
+		{
+			const int32 User = Random.RandHelper(5000);
+			const int64 SentTimestamp = 1700000000000ll + Index * 10ll;
+
+			Line.Reset();
+			switch (Corpus)
+			{
+			case ECorpus::Tags:
+				Line.Appendf("@badge-info=subscriber/11;badges=subscriber/6,premium/1,global_mod/1,turbo/1;client-nonce=8e3c4a0f1b2d4e6f8a9b0c1d2e3f4a5b;color=#0D4200;"
+					"display-name=User%d;emotes=25:0-4,12-16/1902:6-10;first-msg=0;flags=;id=b34ccfc7-4977-403a-%04x-%012x;mod=0;returning-chatter=0;room-id=1337;"
+					"subscriber=1;tmi-sent-ts=%lld;turbo=1;user-id=%d;user-type=global_mod :user%d!user%d@user%d.tmi.twitch.tv PRIVMSG #benchmark :Kappa Keepo Kappa what a play",
+					User, Index & 0xFFFF, Index, static_cast<long long>(SentTimestamp), 100000 + User, User, User, User);
+				break;
+			case ECorpus::Bits:
+				Line.Appendf("@badge-info=;badges=bits/1000;bits=%d;color=#1E90FF;display-name=User%d;emotes=;first-msg=0;flags=;id=0f9a1c2e-5b3d-4e7f-%04x-%012x;"
+					"mod=0;returning-chatter=0;room-id=1337;subscriber=0;tmi-sent-ts=%lld;turbo=0;user-id=%d;user-type= :user%d!user%d@user%d.tmi.twitch.tv PRIVMSG #benchmark :cheer%d Cheer100 have some bits",
+					100 + Index % 900, User, Index & 0xFFFF, Index, static_cast<long long>(SentTimestamp), 100000 + User, User, User, User, Index % 900);
+				break;
+			case ECorpus::Unicode:
+				// "こんにちは 🙂 Kappa ça va? Привет", Kappa is characters 8 to 12
+				Line.Appendf("@badge-info=;badges=;color=#8A2BE2;display-name=User%d;emotes=25:8-12;first-msg=0;flags=;id=7d3e9b1a-2c4f-4a6e-%04x-%012x;mod=0;"
+					"returning-chatter=0;room-id=1337;subscriber=0;tmi-sent-ts=%lld;turbo=0;user-id=%d;user-type= :user%d!user%d@user%d.tmi.twitch.tv PRIVMSG #benchmark :"
+					"\xE3\x81\x93\xE3\x82\x93\xE3\x81\xAB\xE3\x81\xA1\xE3\x81\xAF \xF0\x9F\x99\x82 Kappa \xC3\xA7" "a va? \xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82",
+					User, Index & 0xFFFF, Index, static_cast<long long>(SentTimestamp), 100000 + User, User, User, User);
+				break;
+			case ECorpus::Commands:
+			{
+				Line.Appendf("@badges=;color=;display-name=User%d;emotes=;id=3b8c2d1e-9f4a-4b6c-%04x-%012x;mod=0;room-id=1337;subscriber=0;tmi-sent-ts=%lld;user-id=%d;user-type= "
+					":user%d!user%d@user%d.tmi.twitch.tv PRIVMSG #benchmark :",
+					User, Index & 0xFFFF, Index, static_cast<long long>(SentTimestamp), 100000 + User, User, User, User);
+
+				// Mostly commands with and without options, some unknown ones and some plain chat
+				const int32 Option = 1 + Index % 4;
+				switch (Index % 6)
+				{
+				case 0: Line << "!jump!"; break;
+				case 1: Line.Appendf("!vote!#%d#!", Option); break;
+				case 2: Line.Appendf("!spawn!#zombie,%d#!", Option); break;
+				case 3: Line << "!dance!"; break;
+				case 4: Line << "gg !left! now"; break;
+				default: Line.Appendf("nice one %d", Option); break;
+				}
+				break;
+			}
+			}
+
+			OutData.Append(reinterpret_cast<const uint8*>(Line.GetData()), Line.Len());
+			OutData.Add('\r');
+			OutData.Add('\n');
+		}
+	}
+
+	double GetPercentile(const TArray<double>& Sorted, const double Percentile)
+	{
+		if (Sorted.Num() == 0)
+		{
+			return 0.0;
+		}
+		return Sorted[FMath::Min(static_cast<int32>(Percentile * Sorted.Num()), Sorted.Num() - 1)];
+	}
+
+	// "p50", "p99" and "max" of latencies in seconds, as microseconds
+	FString LatencyToJson(TArray<double>& Latencies)
+	{
+		Latencies.Sort();
+		return FString::Printf(TEXT("{\"p50\": %.1f, \"p99\": %.1f, \"max\": %.1f, \"samples\": %d}"),
+			GetPercentile(Latencies, 0.5) * 1e6, GetPercentile(Latencies, 0.99) * 1e6, (Latencies.Num() ? Latencies.Last() : 0.0) * 1e6, Latencies.Num());
+	}
+
+	FString PhaseToJson(const int32 NumLines, const double Seconds, const int64 NumAllocations)
+	{
+		return FString::Printf(TEXT("{\"seconds\": %.6f, \"linesPerSecond\": %.0f, \"allocationsPerLine\": %.3f}"),
+			Seconds, Seconds > 0.0 ? NumLines / Seconds : 0.0, NumLines > 0 ? static_cast<double>(NumAllocations) / NumLines : 0.0);
+	}
+
+	// The subsystem handling of a delivered message: emotes counted, commands dispatched the way the subsystem does
+	struct FBenchmarkHandler
+	{
+		// Registered without callbacks, only the dispatch is measured
+		TMap<FString, FOnCommandReceived> BoundEvents;
+		TMap<FString, FTwitchChannelCommands> ChannelBoundEvents;
+		TMap<FString, FString> CommandAliases;
+		FTwitchCommandDispatcher Dispatcher { BoundEvents, ChannelBoundEvents, CommandAliases };
+		FTwitchCommandCooldowns Cooldowns;
+		FTwitchEmoteCounter EmoteCounter;
+		TArray<FTwitchEmoteRange> EmoteRanges;
+		FTwitchChatMessage Delivered;
+		int32 NumCommands = 0;
+
+		FBenchmarkHandler()
+		{
+			for (const TCHAR* Command : BenchmarkCommands)
+			{
+				BoundEvents.Add(Command);
+			}
+		}
+
+		void Handle(const FTwitchReceivedMessage& Message)
+		{
+			Message.ToChatMessage(Delivered);
+			FTwitchChatterRegistry::Get().CopyLogin(Delivered.Chatter, Delivered.Username);
+
+			Delivered.Tags.GetEmotes(Delivered.Message, EmoteRanges);
+			for (const FTwitchEmoteRange& Emote : EmoteRanges)
+			{
+				EmoteCounter.Add(Emote.Id, FStringView(*Delivered.Message + Emote.Start, Emote.End - Emote.Start + 1));
+			}
+
+			if (Dispatcher.Dispatch(Delivered, TEXT("!"), TEXT("#"), false, Cooldowns))
+			{
+				++NumCommands;
+			}
+		}
+	};
+
+	FString RunCorpus(const ECorpus Corpus, const FTwitchBenchmarkSettings& Settings)
+	{
+		TArray<uint8> Data;
+		MakeCorpus(Corpus, Settings.NumLines, Settings.Seed, Data);
+
+		// Line views for the tokenizer, split ahead of time
+		TArray<FAnsiStringView> Lines;
+		Lines.Reserve(Settings.NumLines);
+		int32 LineStart = 0;
+		for (int32 Index = 0; Index < Data.Num(); ++Index)
+		{
+			if (Data[Index] == '\n')
+			{
+				Lines.Emplace(reinterpret_cast<const ANSICHAR*>(Data.GetData()) + LineStart, Index - 1 - LineStart);
+				LineStart = Index + 1;
+			}
+		}
+
+		TArray<double> Latencies;
+		Latencies.Reserve(Settings.NumLines);
+		TArray<FTwitchReceivedMessage> Received;
+		Received.Reserve(Settings.ReadSize);
+
+		FTwitchReceiverSettings ReceiverSettings;
+		ReceiverSettings.MaxQueuedMessages = FMath::Max(Settings.ReadSize, 1024);
+		FTwitchMessageReceiver Receiver;
+		Receiver.StartOffline(ReceiverSettings);
+		FBenchmarkHandler Handler;
+
+		const uint64 BaseMemory = FPlatformMemory::GetStats().UsedPhysical;
+		uint64 PeakMemory = BaseMemory;
+
+		FCountingMalloc& CountingMalloc = GetCountingMalloc();
+		CountingMalloc.Install();
+
+		// Tokenize only
+		uint64 Checksum = 0;
+		double StartTime = FPlatformTime::Seconds();
+		for (const FAnsiStringView& Line : Lines)
+		{
+			FTwitchIrcMessage IrcMessage;
+			if (FTwitchIrcMessage::Parse(Line, IrcMessage))
+			{
+				FTwitchIrcTagIterator Tags(IrcMessage.Tags);
+				FAnsiStringView Key;
+				FAnsiStringView Value;
+				while (Tags.Next(Key, Value))
+				{
+					Checksum += static_cast<uint64>(TwitchIrc::ClassifyTag(Key)) + Value.Len();
+				}
+				Checksum += IrcMessage.Trailing.Len();
+			}
+		}
+		const double TokenizeSeconds = FPlatformTime::Seconds() - StartTime;
+		const int64 TokenizeAllocations = CountingMalloc.Take();
+
+		// Receive and deliver, one read at a time
+		double ReceiveSeconds = 0.0;
+		double DeliverSeconds = 0.0;
+		int64 ReceiveAllocations = 0;
+		int64 DeliverAllocations = 0;
+		int32 NumDelivered = 0;
+		int32 NumReads = 0;
+		for (int32 Offset = 0; Offset < Data.Num(); Offset += Settings.ReadSize)
+		{
+			StartTime = FPlatformTime::Seconds();
+			Receiver.ProcessReceivedBytes(Data.GetData() + Offset, FMath::Min(Settings.ReadSize, Data.Num() - Offset));
+			Receiver.PullMessages(Received);
+			const double ReceivedTime = FPlatformTime::Seconds();
+			ReceiveSeconds += ReceivedTime - StartTime;
+			ReceiveAllocations += CountingMalloc.Take();
+
+			for (const FTwitchReceivedMessage& Message : Received)
+			{
+				Handler.Handle(Message);
+				Latencies.Add(FPlatformTime::Seconds() - Message.ReceiveTime);
+			}
+			DeliverSeconds += FPlatformTime::Seconds() - ReceivedTime;
+			DeliverAllocations += CountingMalloc.Take();
+
+			NumDelivered += Received.Num();
+			Received.Reset();
+
+			// Reading the memory stats is slow, once in a while is enough
+			if ((++NumReads & 63) == 0)
+			{
+				PeakMemory = FMath::Max(PeakMemory, FPlatformMemory::GetStats().UsedPhysical);
+			}
+		}
+
+		CountingMalloc.Uninstall();
+		PeakMemory = FMath::Max(PeakMemory, FPlatformMemory::GetStats().UsedPhysical);
+
+		return FString::Printf(TEXT("{\"name\": \"%s\", \"lines\": %d, \"bytes\": %d, \"delivered\": %d, \"commands\": %d, \"checksum\": %llu, ")
+			TEXT("\"tokenize\": %s, \"receive\": %s, \"deliver\": %s, \"latencyMicros\": %s, \"peakMemoryGrowthBytes\": %llu}"),
+			CorpusNames[static_cast<int32>(Corpus)], Lines.Num(), Data.Num(), NumDelivered, Handler.NumCommands, static_cast<unsigned long long>(Checksum),
+			*PhaseToJson(Lines.Num(), TokenizeSeconds, TokenizeAllocations),
+			*PhaseToJson(NumDelivered, ReceiveSeconds, ReceiveAllocations),
+			*PhaseToJson(NumDelivered, DeliverSeconds, DeliverAllocations),
+			*LatencyToJson(Latencies),
+			static_cast<unsigned long long>(PeakMemory - BaseMemory));
+	}
+
+#if WITH_TWITCHPLAY_MOCK_SERVER
+	FString RunEndToEnd(const FTwitchBenchmarkSettings& Settings)
+	{
+		FTwitchMockServerSettings ServerSettings;
+		ServerSettings.Port = 0;
+		ServerSettings.MessagesPerSecond = Settings.EndToEndRate;
+		ServerSettings.PingIntervalSeconds = 0.0f;
+		ServerSettings.Seed = Settings.Seed;
+
+		FTwitchMockIrcServer Server;
+		FString Error;
+		if (!Server.Start(ServerSettings, Error))
+		{
+			return FString::Printf(TEXT("{\"error\": \"%s\"}"), *Error.ReplaceCharWithEscapedChar());
+		}
+
+		FTwitchReceiverSettings ReceiverSettings;
+		ReceiverSettings.ServerHost = TEXT("127.0.0.1");
+		ReceiverSettings.ServerPort = Server.GetPort();
+		ReceiverSettings.bAutoReconnect = false;
+
+		FTwitchMessageReceiver Receiver;
+		Receiver.StartConnection(TEXT("oauth:benchmark"), TEXT("benchmark"), TEXT(""), 0.0f, ReceiverSettings);
+		TArray<FString> Channels;
+		for (int32 Index = 0; Index < FMath::Max(Settings.EndToEndChannels, 1); ++Index)
+		{
+			Channels.Add(FString::Printf(TEXT("benchmark_%d"), Index));
+		}
+		Receiver.JoinChannels(Channels);
+
+		TArray<double> Latencies;
+		TArray<double> ServerLatencies;
+		TArray<FTwitchReceivedMessage> Received;
+		FBenchmarkHandler Handler;
+		ETwitchConnectionMessageType ConnectionType;
+		FString ConnectionMessage;
+
+		// The clock starts with the first message, once the channels are joined
+		const double GiveUpTime = FPlatformTime::Seconds() + 10.0;
+		double StartTime = 0.0;
+		int32 NumDelivered = 0;
+		for (;;)
+		{
+			const double Now = FPlatformTime::Seconds();
+			if ((StartTime > 0.0 && Now - StartTime >= Settings.EndToEndSeconds) || (StartTime == 0.0 && Now > GiveUpTime))
+			{
+				break;
+			}
+
+			while (Receiver.PullConnectionMessage(ConnectionType, ConnectionMessage))
+			{
+			}
+
+			Receiver.PullMessages(Received);
+			if (Received.Num() > 0 && StartTime == 0.0)
+			{
+				StartTime = Now;
+			}
+
+			const int64 NowMilliseconds = static_cast<int64>((FDateTime::UtcNow() - FDateTime(1970, 1, 1)).GetTotalMilliseconds());
+			for (const FTwitchReceivedMessage& Message : Received)
+			{
+				Handler.Handle(Message);
+				Latencies.Add(FPlatformTime::Seconds() - Message.ReceiveTime);
+				ServerLatencies.Add((NowMilliseconds - Message.SentTimestamp) / 1000.0);
+			}
+			NumDelivered += Received.Num();
+			Received.Reset();
+
+			// Polled far more often than a game frame, so the latency is the one of the pipeline alone
+			FPlatformProcess::SleepNoStats(0.001f);
+		}
+
+		const double Seconds = StartTime > 0.0 ? FPlatformTime::Seconds() - StartTime : 0.0;
+		const int64 NumDropped = Receiver.GetNumDroppedMessages();
+		Receiver.StopConnection(true);
+		Server.Shutdown();
+
+		if (NumDelivered == 0)
+		{
+			return TEXT("{\"error\": \"No message received from the mock server\"}");
+		}
+
+		return FString::Printf(TEXT("{\"seconds\": %.3f, \"channels\": %d, \"ratePerChannel\": %.0f, \"delivered\": %d, \"dropped\": %lld, \"linesPerSecond\": %.0f, ")
+			TEXT("\"pollIntervalMicros\": 1000, \"latencyMicros\": %s, \"serverLatencyMicros\": %s}"),
+			Seconds, Channels.Num(), Settings.EndToEndRate, NumDelivered, static_cast<long long>(NumDropped), Seconds > 0.0 ? NumDelivered / Seconds : 0.0,
+			*LatencyToJson(Latencies), *LatencyToJson(ServerLatencies));
+	}
+#endif // WITH_TWITCHPLAY_MOCK_SERVER
+}
+
+FTwitchBenchmarkSettings FTwitchBenchmarkSettings::Parse(const TCHAR* Args)
+{
+	FTwitchBenchmarkSettings Settings;
+	FParse::Value(Args, TEXT("Lines="), Settings.NumLines);
+	FParse::Value(Args, TEXT("ReadSize="), Settings.ReadSize);
+	FParse::Value(Args, TEXT("E2ESeconds="), Settings.EndToEndSeconds);
+	FParse::Value(Args, TEXT("Rate="), Settings.EndToEndRate);
+	FParse::Value(Args, TEXT("Channels="), Settings.EndToEndChannels);
+	FParse::Value(Args, TEXT("Seed="), Settings.Seed);
+	Settings.NumLines = FMath::Max(Settings.NumLines, 1);
+	Settings.ReadSize = FMath::Max(Settings.ReadSize, 1);
+	return Settings;
+}
+
+FString TwitchBenchmark::Run(const FTwitchBenchmarkSettings& Settings)
+{
+	FString Json = FString::Printf(TEXT("{\n\"version\": 1,\n\"platform\": \"%s\",\n\"buildConfiguration\": \"%s\",\n\"readSize\": %d,\n\"corpora\": [\n"),
+		ANSI_TO_TCHAR(FPlatformProperties::IniPlatformName()), LexToString(FApp::GetBuildConfiguration()), Settings.ReadSize);
+
+	for (int32 Corpus = 0; Corpus < UE_ARRAY_COUNT(CorpusNames); ++Corpus)
+	{
+		Json += RunCorpus(static_cast<ECorpus>(Corpus), Settings);
+		Json += Corpus + 1 < UE_ARRAY_COUNT(CorpusNames) ? TEXT(",\n") : TEXT("\n");
+	}
+	Json += TEXT("],\n\"endToEnd\": ");
+
+#if WITH_TWITCHPLAY_MOCK_SERVER
+	Json += Settings.EndToEndSeconds > 0.0f ? RunEndToEnd(Settings) : TEXT("null");
+#else
+	Json += TEXT("null");
+#endif
+
+	Json += TEXT("\n}\n");
+	return Json;
+}
+
+static FAutoConsoleCommand BenchmarkCommand(
+	TEXT("TwitchPlay.Benchmark"),
+	TEXT("Runs the TwitchPlay receive path benchmarks and writes the results as JSON. Blocks until done.\n")
+	TEXT("Options: Lines= ReadSize= E2ESeconds= Rate= Channels= Seed= Output=<file, Saved/TwitchPlay/Benchmark.json by default>"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const FString JoinedArgs = FString::Join(Args, TEXT(" "));
+		const FTwitchBenchmarkSettings Settings = FTwitchBenchmarkSettings::Parse(*JoinedArgs);
+
+		FString Output = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("TwitchPlay"), TEXT("Benchmark.json"));
+		FParse::Value(*JoinedArgs, TEXT("Output="), Output);
+
+		const FString Json = TwitchBenchmark::Run(Settings);
+		if (FFileHelper::SaveStringToFile(Json, *Output))
+		{
+			FLogTwitchPlay::Infof(TEXT("TwitchPlay.Benchmark  Results written to %s"), *Output);
+		}
+		else
+		{
+			FLogTwitchPlay::Errorf(TEXT("TwitchPlay.Benchmark  Could not write %s"), *Output);
+		}
+		FLogTwitchPlay::Info(Json);
+	}));
+
+#endif // !UE_BUILD_SHIPPING
@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Chatters/TwitchChatterLibrary.h"
+
+#include "Chatters/TwitchChatterRegistry.h"
+
+bool UTwitchChatterLibrary::IsChatterValid(const FTwitchChatterHandle& Chatter)
+{
+	return FTwitchChatterRegistry::Get().IsValid(Chatter);
+}
+
+FString UTwitchChatterLibrary::GetChatterLogin(const FTwitchChatterHandle& Chatter)
+{
+	return FTwitchChatterRegistry::Get().GetLogin(Chatter);
+}
+
+FString UTwitchChatterLibrary::GetChatterDisplayName(const FTwitchChatterHandle& Chatter)
+{
+	return FTwitchChatterRegistry::Get().GetDisplayName(Chatter);
+}
+
+FColor UTwitchChatterLibrary::GetChatterColor(const FTwitchChatterHandle& Chatter)
+{
+	return FTwitchChatterRegistry::Get().GetColor(Chatter);
+}
+
+int64 UTwitchChatterLibrary::GetChatterUserId(const FTwitchChatterHandle& Chatter)
+{
+	return static_cast<int64>(FTwitchChatterRegistry::Get().GetUserId(Chatter));
+}
@@ -0,0 +1,171 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Chatters/TwitchChatterRegistry.h"
+
+#include "Hash/CityHash.h"
+#include "Parsing/TwitchUtf8.h"
+
+// Keys of chatters without user id. Twitch user ids never get that large
+static constexpr uint64 LoginKeyBit = 1ull << 63;
+
+FTwitchChatterRegistry::FTwitchChatterRegistry(const int32 InMaxChatters)
+	: MaxChatters(FMath::Max(InMaxChatters, 1))
+	, ClockHand(0)
+{
+}
+
+FTwitchChatterRegistry& FTwitchChatterRegistry::Get()
+{
+	static FTwitchChatterRegistry Registry;
+	return Registry;
+}
+
+FTwitchChatterHandle FTwitchChatterRegistry::Intern(const uint64 UserId, const FAnsiStringView& Login, const FAnsiStringView& DisplayName, const FColor& Color)
+{
+	const uint64 Key = UserId != 0 ? UserId : (CityHash64(Login.GetData(), Login.Len()) | LoginKeyBit);
+	const uint64 NamesHash = CityHash64WithSeed(Login.GetData(), Login.Len(), CityHash64(DisplayName.GetData(), DisplayName.Len()));
+
+	// Known chatter, nothing changed
+	{
+		FReadScopeLock ReadLock(Lock);
+		if (const int32* Index = Indices.Find(Key))
+		{
+			const FChatter& Chatter = Chatters[*Index];
+			if (Chatter.NamesHash == NamesHash && Chatter.Color == Color)
+			{
+				FPlatformAtomics::AtomicStore_Relaxed(&RecentlySeen[*Index], static_cast<int8>(1));
+				return FTwitchChatterHandle {*Index, Chatter.Generation};
+			}
+		}
+	}
+
+	// Decode before taking the write lock, the other threads keep going meanwhile
+	FString LoginString = TwitchUtf8::ToString(Login);
+	FString DisplayNameString = TwitchUtf8::ToString(DisplayName);
+
+	FWriteScopeLock WriteLock(Lock);
+
+	int32 Index;
+	if (const int32* Existing = Indices.Find(Key))
+	{
+		// Same chatter with new names or color, handles stay valid
+		Index = *Existing;
+	}
+	else
+	{
+		if (Chatters.Num() < MaxChatters)
+		{
+			Index = Chatters.AddDefaulted();
+			RecentlySeen.Add(0);
+		}
+		else
+		{
+			Index = Evict();
+			Indices.Remove(Chatters[Index].Key);
+		}
+		++Chatters[Index].Generation;
+		Indices.Add(Key, Index);
+	}
+
+	FChatter& Chatter = Chatters[Index];
+	Chatter.Key = Key;
+	Chatter.UserId = UserId;
+	Chatter.NamesHash = NamesHash;
+	Chatter.Login = MoveTemp(LoginString);
+	Chatter.DisplayName = MoveTemp(DisplayNameString);
+	Chatter.Color = Color;
+	RecentlySeen[Index] = 1;
+
+	return FTwitchChatterHandle {Index, Chatter.Generation};
+}
+
+FTwitchChatterHandle FTwitchChatterRegistry::Find(const uint64 UserId) const
+{
+	FReadScopeLock ReadLock(Lock);
+	if (const int32* Index = Indices.Find(UserId))
+	{
+		return FTwitchChatterHandle {*Index, Chatters[*Index].Generation};
+	}
+	return FTwitchChatterHandle();
+}
+
+bool FTwitchChatterRegistry::IsValid(const FTwitchChatterHandle& Chatter) const
+{
+	FReadScopeLock ReadLock(Lock);
+	return Resolve(Chatter) != nullptr;
+}
+
+FString FTwitchChatterRegistry::GetLogin(const FTwitchChatterHandle& Chatter) const
+{
+	FReadScopeLock ReadLock(Lock);
+	const FChatter* Resolved = Resolve(Chatter);
+	return Resolved != nullptr ? Resolved->Login : FString();
+}
+
+void FTwitchChatterRegistry::CopyLogin(const FTwitchChatterHandle& Chatter, FString& OutLogin) const
+{
+	OutLogin.Reset();
+
+	FReadScopeLock ReadLock(Lock);
+	if (const FChatter* Resolved = Resolve(Chatter))
+	{
+		OutLogin += Resolved->Login;
+	}
+}
+
+FString FTwitchChatterRegistry::GetDisplayName(const FTwitchChatterHandle& Chatter) const
+{
+	FReadScopeLock ReadLock(Lock);
+	const FChatter* Resolved = Resolve(Chatter);
+	if (Resolved == nullptr)
+	{
+		return FString();
+	}
+	return Resolved->DisplayName.IsEmpty() ? Resolved->Login : Resolved->DisplayName;
+}
+
+FColor FTwitchChatterRegistry::GetColor(const FTwitchChatterHandle& Chatter) const
+{
+	FReadScopeLock ReadLock(Lock);
+	const FChatter* Resolved = Resolve(Chatter);
+	return Resolved != nullptr ? Resolved->Color : FColor::White;
+}
+
+uint64 FTwitchChatterRegistry::GetUserId(const FTwitchChatterHandle& Chatter) const
+{
+	FReadScopeLock ReadLock(Lock);
+	const FChatter* Resolved = Resolve(Chatter);
+	return Resolved != nullptr ? Resolved->UserId : 0;
+}
+
+int32 FTwitchChatterRegistry::Num() const
+{
+	FReadScopeLock ReadLock(Lock);
+	return Chatters.Num();
+}
+
+const FTwitchChatterRegistry::FChatter* FTwitchChatterRegistry::Resolve(const FTwitchChatterHandle& Chatter) const
+{
+	if (!Chatters.IsValidIndex(Chatter.Index) || Chatters[Chatter.Index].Generation != Chatter.Generation)
+	{
+		return nullptr;
+	}
+	return &Chatters[Chatter.Index];
+}
+
+int32 FTwitchChatterRegistry::Evict()
+{
+	// Second chance: chatters seen since the hand last passed are skipped once. Ends within two turns
+	for (;;)
+	{
+		const int32 Index = ClockHand;
+		ClockHand = (ClockHand + 1) % Chatters.Num();
+
+		if (RecentlySeen[Index] == 0)
+		{
+			return Index;
+		}
+		RecentlySeen[Index] = 0;
+	}
+}
@@ -0,0 +1,268 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Data/TwitchCooldownFilter.h"
+
+FTwitchCooldownFilter::FTwitchCooldownFilter(const int32 InMaxEntries)
+	: FreeHead(INDEX_NONE)
+	, NumEntries(0)
+	, CurrentTick(0)
+	, StartTime(0)
+	, GlobalReadyTime(0)
+{
+	Entries.SetNumZeroed(FMath::Max(InMaxEntries, 1));
+	Table.SetNum(FMath::RoundUpToPowerOfTwo(Entries.Num() * 2));
+	WheelHeads.SetNum(WheelLevels * WheelSlots);
+	Reset(0);
+}
+
+void FTwitchCooldownFilter::Reset(const int32 InNumCommands)
+{
+	for (int32 EntryIndex = 0; EntryIndex < Entries.Num(); ++EntryIndex)
+	{
+		Entries[EntryIndex].Next = EntryIndex + 1 < Entries.Num() ? EntryIndex + 1 : INDEX_NONE;
+	}
+	FreeHead = 0;
+	NumEntries = 0;
+
+	for (int32& Slot : Table)
+	{
+		Slot = INDEX_NONE;
+	}
+	for (int32& Head : WheelHeads)
+	{
+		Head = INDEX_NONE;
+	}
+
+	StartTime = FPlatformTime::Seconds();
+	CurrentTick = 0;
+
+	CommandReadyTimes.Reset();
+	CommandReadyTimes.SetNumZeroed(InNumCommands);
+	GlobalReadyTime = 0;
+}
+
+void FTwitchCooldownFilter::SetNumCommands(const int32 InNumCommands)
+{
+	// New commands are ready right away
+	if (InNumCommands > CommandReadyTimes.Num())
+	{
+		CommandReadyTimes.SetNumZeroed(InNumCommands);
+	}
+}
+
+bool FTwitchCooldownFilter::TryPass(const uint64 UserId, const int32 CommandIndex, const FTwitchCommandCooldowns& Cooldowns, const double Now)
+{
+	if (Now < GlobalReadyTime)
+	{
+		return false;
+	}
+
+	const bool bHasCommand = CommandReadyTimes.IsValidIndex(CommandIndex);
+	if (bHasCommand && Now < CommandReadyTimes[CommandIndex])
+	{
+		return false;
+	}
+
+	const bool bUserCooldown = UserId != 0 && Cooldowns.UserCooldownSeconds > 0.0f;
+	const uint64 Key = (UserId << 16) ^ static_cast<uint16>(CommandIndex);
+	int32 Slot = INDEX_NONE;
+	if (bUserCooldown)
+	{
+		const uint32 NowTick = ToTick(Now);
+		Advance(NowTick);
+
+		Slot = FindSlot(Key);
+		if (Table[Slot] != INDEX_NONE && Entries[Table[Slot]].ExpireTick > NowTick)
+		{
+			return false;
+		}
+	}
+
+	// The command goes through, start its cooldowns
+	GlobalReadyTime = Now + Cooldowns.GlobalCooldownSeconds;
+	if (bHasCommand)
+	{
+		CommandReadyTimes[CommandIndex] = Now + Cooldowns.CommandCooldownSeconds;
+	}
+
+	// An entry still in the table here has expired within the current tick, it is dropped on the next one
+	if (bUserCooldown && Table[Slot] == INDEX_NONE && FreeHead != INDEX_NONE)
+	{
+		const int32 EntryIndex = FreeHead;
+		FEntry& Entry = Entries[EntryIndex];
+		FreeHead = Entry.Next;
+
+		Entry.Key = Key;
+		Entry.ExpireTick = ToTick(Now + Cooldowns.UserCooldownSeconds);
+		Table[Slot] = EntryIndex;
+		++NumEntries;
+		Schedule(EntryIndex);
+	}
+
+	return true;
+}
+
+uint32 FTwitchCooldownFilter::ToTick(const double Now) const
+{
+	return static_cast<uint32>(FMath::CeilToDouble(FMath::Max(Now - StartTime, 0.0) * TicksPerSecond));
+}
+
+void FTwitchCooldownFilter::Advance(const uint32 NowTick)
+{
+	if (NumEntries == 0)
+	{
+		CurrentTick = FMath::Max(CurrentTick, NowTick);
+		return;
+	}
+
+	// After a long stall, going over every entry once is cheaper than going over every tick
+	if (NowTick - CurrentTick > WheelSlots * WheelSlots)
+	{
+		for (int32& Head : WheelHeads)
+		{
+			Head = INDEX_NONE;
+		}
+
+		CurrentTick = NowTick;
+		for (int32 Slot = 0; Slot < Table.Num(); ++Slot)
+		{
+			const int32 EntryIndex = Table[Slot];
+			if (EntryIndex != INDEX_NONE && Entries[EntryIndex].ExpireTick > NowTick)
+			{
+				Schedule(EntryIndex);
+			}
+		}
+
+		// Expiring moves entries around in the table, so collect them first
+		TArray<int32> Expired;
+		for (const int32 EntryIndex : Table)
+		{
+			if (EntryIndex != INDEX_NONE && Entries[EntryIndex].ExpireTick <= NowTick)
+			{
+				Expired.Add(EntryIndex);
+			}
+		}
+		for (const int32 EntryIndex : Expired)
+		{
+			Expire(EntryIndex);
+		}
+		return;
+	}
+
+	while (CurrentTick < NowTick)
+	{
+		++CurrentTick;
+
+		// Entering a new turn of a level brings its next slot down
+		if ((CurrentTick & WheelSlotMask) == 0)
+		{
+			if (((CurrentTick >> WheelBits) & WheelSlotMask) == 0)
+			{
+				Cascade(2, (CurrentTick >> (2 * WheelBits)) & WheelSlotMask);
+			}
+			Cascade(1, (CurrentTick >> WheelBits) & WheelSlotMask);
+		}
+
+		int32& Head = WheelHeads[CurrentTick & WheelSlotMask];
+		int32 EntryIndex = Head;
+		Head = INDEX_NONE;
+		while (EntryIndex != INDEX_NONE)
+		{
+			const int32 Next = Entries[EntryIndex].Next;
+			Expire(EntryIndex);
+			EntryIndex = Next;
+		}
+	}
+}
+
+void FTwitchCooldownFilter::Schedule(const int32 EntryIndex)
+{
+	FEntry& Entry = Entries[EntryIndex];
+
+	// Past expiries go to the next tick
+	const uint32 ExpireTick = FMath::Max(Entry.ExpireTick, CurrentTick + 1);
+	const uint32 Delta = ExpireTick - CurrentTick;
+
+	int32 Level = 0;
+	uint32 Slot = ExpireTick & WheelSlotMask;
+	if (Delta >= WheelSlots * WheelSlots)
+	{
+		// Cooldowns longer than the wheel (46 hours) come back around and are scheduled again
+		Level = 2;
+		Slot = (FMath::Min<uint32>(ExpireTick, CurrentTick + (1u << (3 * WheelBits)) - 1) >> (2 * WheelBits)) & WheelSlotMask;
+	}
+	else if (Delta >= WheelSlots)
+	{
+		Level = 1;
+		Slot = (ExpireTick >> WheelBits) & WheelSlotMask;
+	}
+
+	int32& Head = WheelHeads[Level * WheelSlots + Slot];
+	Entry.Next = Head;
+	Head = EntryIndex;
+}
+
+void FTwitchCooldownFilter::Cascade(const int32 Level, const uint32 Slot)
+{
+	int32& Head = WheelHeads[Level * WheelSlots + Slot];
+	int32 EntryIndex = Head;
+	Head = INDEX_NONE;
+	while (EntryIndex != INDEX_NONE)
+	{
+		const int32 Next = Entries[EntryIndex].Next;
+		Schedule(EntryIndex);
+		EntryIndex = Next;
+	}
+}
+
+void FTwitchCooldownFilter::Expire(const int32 EntryIndex)
+{
+	FEntry& Entry = Entries[EntryIndex];
+
+	// Backward shift deletion: later entries of the probe sequence move up, so no tombstones are needed
+	const uint32 Mask = Table.Num() - 1;
+	uint32 Hole = FindSlot(Entry.Key);
+	uint32 Slot = Hole;
+	for (;;)
+	{
+		Slot = (Slot + 1) & Mask;
+		const int32 Moving = Table[Slot];
+		if (Moving == INDEX_NONE)
+		{
+			break;
+		}
+
+		// The entry can fill the hole if its home slot is not between the hole and where it is now
+		const uint32 Home = GetHomeSlot(Entries[Moving].Key);
+		if (((Slot - Home) & Mask) >= ((Slot - Hole) & Mask))
+		{
+			Table[Hole] = Moving;
+			Hole = Slot;
+		}
+	}
+	Table[Hole] = INDEX_NONE;
+
+	Entry.Next = FreeHead;
+	FreeHead = EntryIndex;
+	--NumEntries;
+}
+
+int32 FTwitchCooldownFilter::FindSlot(const uint64 Key) const
+{
+	const uint32 Mask = Table.Num() - 1;
+	uint32 Slot = GetHomeSlot(Key);
+	while (Table[Slot] != INDEX_NONE && Entries[Table[Slot]].Key != Key)
+	{
+		Slot = (Slot + 1) & Mask;
+	}
+	return static_cast<int32>(Slot);
+}
+
+uint32 FTwitchCooldownFilter::GetHomeSlot(uint64 Key) const
+{
+	Key ^= Key >> 33;
+	Key *= 0xff51afd7ed558ccdull;
+	Key ^= Key >> 33;
+	return static_cast<uint32>(Key) & (Table.Num() - 1);
+}
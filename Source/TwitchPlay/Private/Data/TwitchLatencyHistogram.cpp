@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Data/TwitchLatencyHistogram.h"
+
+FTwitchLatencyHistogram::FTwitchLatencyHistogram()
+	: Count(0)
+	, Max(0)
+{
+	Buckets.SetNumZeroed(NumBuckets);
+}
+
+void FTwitchLatencyHistogram::Record(int64 Microseconds)
+{
+	Microseconds = FMath::Clamp<int64>(Microseconds, 0, MaxMicroseconds);
+	++Buckets[GetBucket(Microseconds)];
+	++Count;
+	Max = FMath::Max(Max, Microseconds);
+}
+
+int64 FTwitchLatencyHistogram::GetPercentile(const double Percentile) const
+{
+	if (Count == 0)
+	{
+		return 0;
+	}
+
+	// The value of the Rank-th smallest recorded value, 1 based
+	const int64 Rank = FMath::Clamp<int64>(static_cast<int64>(FMath::CeilToDouble(Percentile * Count)), 1, Count);
+	int64 Seen = 0;
+	for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket)
+	{
+		Seen += Buckets[Bucket];
+		if (Seen >= Rank)
+		{
+			return FMath::Min(GetBucketMax(Bucket), Max);
+		}
+	}
+	return Max;
+}
+
+void FTwitchLatencyHistogram::GetPercentiles(FTwitchLatencyPercentiles& OutPercentiles) const
+{
+	OutPercentiles.P50 = GetPercentile(0.5) / 1000.0f;
+	OutPercentiles.P95 = GetPercentile(0.95) / 1000.0f;
+	OutPercentiles.P99 = GetPercentile(0.99) / 1000.0f;
+	OutPercentiles.Max = Max / 1000.0f;
+	OutPercentiles.Count = Count;
+}
+
+void FTwitchLatencyHistogram::Reset()
+{
+	FMemory::Memzero(Buckets.GetData(), Buckets.Num() * sizeof(int64));
+	Count = 0;
+	Max = 0;
+}
+
+int32 FTwitchLatencyHistogram::GetBucket(const int64 Microseconds)
+{
+	if (Microseconds < SubBucketCount)
+	{
+		return static_cast<int32>(Microseconds);
+	}
+
+	// The top SubBucketBits bits of the value, below its leading one, pick the sub bucket
+	const int32 Exponent = static_cast<int32>(FMath::FloorLog2_64(static_cast<uint64>(Microseconds)));
+	const int32 SubBucket = static_cast<int32>(Microseconds >> (Exponent - SubBucketBits)) & (SubBucketCount - 1);
+	return (Exponent - SubBucketBits + 1) * SubBucketCount + SubBucket;
+}
+
+int64 FTwitchLatencyHistogram::GetBucketMax(const int32 Bucket)
+{
+	if (Bucket < SubBucketCount)
+	{
+		return Bucket;
+	}
+
+	const int32 Shift = Bucket / SubBucketCount - 1;
+	const int64 Lowest = static_cast<int64>(SubBucketCount + Bucket % SubBucketCount) << Shift;
+	return Lowest + (int64(1) << Shift) - 1;
+}
@@ -0,0 +1,22 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Data/TwitchReceiveBatch.h"
+
+#include "Parsing/TwitchUtf8.h"
+
+void FTwitchReceivedMessage::ToChatMessage(FTwitchChatMessage& OutMessage) const
+{
+	OutMessage.Chatter = Chatter;
+	TwitchUtf8::Decode(GetText(), OutMessage.Message);
+	TwitchUtf8::Decode(GetChannel(), OutMessage.Channel);
+	OutMessage.bIsSubbed = bIsSubbed;
+	OutMessage.bBits = bBits;
+	OutMessage.Bits = Bits;
+	OutMessage.UserColor = UserColor;
+	OutMessage.SentTimestamp = SentTimestamp;
+	OutMessage.UserId = UserId;
+	OutMessage.IdHash = IdHash;
+	OutMessage.BadgeMask = BadgeMask;
+	OutMessage.Tags.Reset(Slab, Tags);
+}
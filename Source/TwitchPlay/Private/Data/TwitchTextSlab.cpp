@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Data/TwitchTextSlab.h"
+
+FTwitchTextSlab::FTwitchTextSlab()
+	: RefCount(0)
+{
+}
+
+void FTwitchTextSlab::Release() const
+{
+	if (RefCount.fetch_sub(1, std::memory_order_acq_rel) != 1)
+	{
+		return;
+	}
+
+	// Last reference. The pool may go away along with this reference, so take it out first
+	FTwitchTextSlab* MutableThis = const_cast<FTwitchTextSlab*>(this);
+	const TSharedPtr<FTwitchTextSlabPool, ESPMode::ThreadSafe> OwnerPool = MoveTemp(MutableThis->Pool);
+	if (OwnerPool.IsValid())
+	{
+		OwnerPool->Recycle(MutableThis);
+	}
+	else
+	{
+		delete this;
+	}
+}
+
+FTwitchTextSpan FTwitchTextSlab::Append(const FAnsiStringView& InText)
+{
+	const FTwitchTextSpan Span {Text.Num(), InText.Len()};
+	Text.Append(InText.GetData(), InText.Len());
+	return Span;
+}
+
+FTwitchTextSlabPool::~FTwitchTextSlabPool()
+{
+	for (const FTwitchTextSlab* Slab : FreeSlabs)
+	{
+		delete Slab;
+	}
+}
+
+TRefCountPtr<FTwitchTextSlab> FTwitchTextSlabPool::Acquire()
+{
+	FTwitchTextSlab* Slab = nullptr;
+	{
+		FScopeLock ScopeLock(&Lock);
+		if (FreeSlabs.Num() > 0)
+		{
+			Slab = FreeSlabs.Pop(false);
+		}
+	}
+
+	if (Slab == nullptr)
+	{
+		Slab = new FTwitchTextSlab();
+	}
+
+	Slab->Pool = AsShared();
+	return TRefCountPtr<FTwitchTextSlab>(Slab);
+}
+
+void FTwitchTextSlabPool::Recycle(FTwitchTextSlab* Slab)
+{
+	if (Slab->Text.Max() <= MaxKeptSlabBytes)
+	{
+		Slab->Text.Reset();
+
+		FScopeLock ScopeLock(&Lock);
+		if (FreeSlabs.Num() < MaxFreeSlabs)
+		{
+			FreeSlabs.Add(Slab);
+			return;
+		}
+	}
+
+	delete Slab;
+}
@@ -0,0 +1,200 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Emotes/TwitchEmoteCounter.h"
+
+#include "Hash/CityHash.h"
+#include "Parsing/TwitchUtf8.h"
+
+FTwitchEmoteCounter::FTwitchEmoteCounter(const int32 InCapacity)
+	: Capacity(FMath::Max(InCapacity, 1))
+	, FreeBuckets(INDEX_NONE)
+	, MinBucket(INDEX_NONE)
+	, MaxBucket(INDEX_NONE)
+	, Total(0)
+{
+	Reset();
+}
+
+void FTwitchEmoteCounter::Add(const FAnsiStringView& EmoteId, const FStringView& Name)
+{
+	++Total;
+
+	const uint64 Key = CityHash64(EmoteId.GetData(), EmoteId.Len());
+	if (const int32* Found = Indices.Find(Key))
+	{
+		Increment(*Found);
+		return;
+	}
+
+	int32 Index;
+	if (Counters.Num() < Capacity)
+	{
+		Index = Counters.AddDefaulted();
+		const int32 Bucket = (MinBucket != INDEX_NONE && Buckets[MinBucket].Count == 1) ? MinBucket : InsertBucket(1, INDEX_NONE);
+		LinkCounter(Index, Bucket);
+	}
+	else
+	{
+		// The least counted emote makes room, its count carries over as the error of the new one
+		Index = Buckets[MinBucket].First;
+		Indices.Remove(Counters[Index].Key);
+		Counters[Index].Error = Buckets[MinBucket].Count;
+		Increment(Index);
+	}
+
+	FCounter& Counter = Counters[Index];
+	Counter.Key = Key;
+	TwitchUtf8::Decode(EmoteId, Counter.EmoteId);
+	Counter.Name = FString(Name.Len(), Name.GetData());
+	Indices.Add(Key, Index);
+}
+
+void FTwitchEmoteCounter::GetTop(const int32 Count, TArray<FTwitchEmoteCount>& OutTop) const
+{
+	OutTop.Reset();
+	for (int32 Bucket = MaxBucket; Bucket != INDEX_NONE && OutTop.Num() < Count; Bucket = Buckets[Bucket].Lower)
+	{
+		for (int32 Index = Buckets[Bucket].First; Index != INDEX_NONE && OutTop.Num() < Count; Index = Counters[Index].Next)
+		{
+			const FCounter& Counter = Counters[Index];
+			FTwitchEmoteCount& Top = OutTop.AddDefaulted_GetRef();
+			Top.EmoteId = Counter.EmoteId;
+			Top.Name = Counter.Name;
+			Top.Count = Buckets[Bucket].Count;
+			Top.MaxError = Counter.Error;
+		}
+	}
+}
+
+void FTwitchEmoteCounter::Reset()
+{
+	Counters.Reset();
+	Counters.Reserve(Capacity);
+	Indices.Reset();
+
+	// A new bucket can be needed before the one it replaces is released
+	Buckets.SetNum(Capacity + 1);
+	for (int32 Bucket = 0; Bucket < Buckets.Num(); ++Bucket)
+	{
+		Buckets[Bucket] = FBucket();
+		Buckets[Bucket].Higher = Bucket + 1 < Buckets.Num() ? Bucket + 1 : INDEX_NONE;
+	}
+	FreeBuckets = 0;
+	MinBucket = INDEX_NONE;
+	MaxBucket = INDEX_NONE;
+
+	Total = 0;
+}
+
+void FTwitchEmoteCounter::Increment(const int32 CounterIndex)
+{
+	const int32 Bucket = Counters[CounterIndex].Bucket;
+	const int64 NewCount = Buckets[Bucket].Count + 1;
+
+	int32 Target = Buckets[Bucket].Higher;
+	if (Target == INDEX_NONE || Buckets[Target].Count != NewCount)
+	{
+		Target = InsertBucket(NewCount, Bucket);
+	}
+
+	UnlinkCounter(CounterIndex);
+	LinkCounter(CounterIndex, Target);
+}
+
+void FTwitchEmoteCounter::LinkCounter(const int32 CounterIndex, const int32 BucketIndex)
+{
+	FCounter& Counter = Counters[CounterIndex];
+	FBucket& Bucket = Buckets[BucketIndex];
+
+	Counter.Bucket = BucketIndex;
+	Counter.Prev = INDEX_NONE;
+	Counter.Next = Bucket.First;
+	if (Bucket.First != INDEX_NONE)
+	{
+		Counters[Bucket.First].Prev = CounterIndex;
+	}
+	Bucket.First = CounterIndex;
+}
+
+void FTwitchEmoteCounter::UnlinkCounter(const int32 CounterIndex)
+{
+	FCounter& Counter = Counters[CounterIndex];
+	const int32 BucketIndex = Counter.Bucket;
+	FBucket& Bucket = Buckets[BucketIndex];
+
+	if (Counter.Prev != INDEX_NONE)
+	{
+		Counters[Counter.Prev].Next = Counter.Next;
+	}
+	else
+	{
+		Bucket.First = Counter.Next;
+	}
+	if (Counter.Next != INDEX_NONE)
+	{
+		Counters[Counter.Next].Prev = Counter.Prev;
+	}
+	Counter.Bucket = INDEX_NONE;
+	Counter.Prev = INDEX_NONE;
+	Counter.Next = INDEX_NONE;
+
+	if (Bucket.First != INDEX_NONE)
+	{
+		return;
+	}
+
+	// Empty bucket, back to the free list
+	if (Bucket.Lower != INDEX_NONE)
+	{
+		Buckets[Bucket.Lower].Higher = Bucket.Higher;
+	}
+	else
+	{
+		MinBucket = Bucket.Higher;
+	}
+	if (Bucket.Higher != INDEX_NONE)
+	{
+		Buckets[Bucket.Higher].Lower = Bucket.Lower;
+	}
+	else
+	{
+		MaxBucket = Bucket.Lower;
+	}
+
+	Bucket = FBucket();
+	Bucket.Higher = FreeBuckets;
+	FreeBuckets = BucketIndex;
+}
+
+int32 FTwitchEmoteCounter::InsertBucket(const int64 Count, const int32 Lower)
+{
+	const int32 BucketIndex = FreeBuckets;
+	check(BucketIndex != INDEX_NONE);
+	FBucket& Bucket = Buckets[BucketIndex];
+	FreeBuckets = Bucket.Higher;
+
+	Bucket.Count = Count;
+	Bucket.First = INDEX_NONE;
+	Bucket.Lower = Lower;
+	Bucket.Higher = Lower != INDEX_NONE ? Buckets[Lower].Higher : MinBucket;
+
+	if (Lower != INDEX_NONE)
+	{
+		Buckets[Lower].Higher = BucketIndex;
+	}
+	else
+	{
+		MinBucket = BucketIndex;
+	}
+	if (Bucket.Higher != INDEX_NONE)
+	{
+		Buckets[Bucket.Higher].Lower = BucketIndex;
+	}
+	else
+	{
+		MaxBucket = BucketIndex;
+	}
+
+	return BucketIndex;
+}
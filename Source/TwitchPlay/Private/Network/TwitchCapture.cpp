@@ -0,0 +1,169 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Network/TwitchCapture.h"
+
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+
+FTwitchCaptureWriter::FTwitchCaptureWriter()
+	: StartSeconds(0.0)
+	, NumBytes(0)
+{
+}
+
+FTwitchCaptureWriter::~FTwitchCaptureWriter()
+{
+	Close();
+}
+
+bool FTwitchCaptureWriter::Open(const FString& Filename)
+{
+	Close();
+
+	File.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*Filename));
+	if (!File.IsValid())
+	{
+		return false;
+	}
+
+	StartSeconds = FPlatformTime::Seconds();
+	NumBytes = 0;
+
+	const int64 StartUnixMicros = (FDateTime::UtcNow() - FDateTime(1970, 1, 1)).GetTicks() / ETimespan::TicksPerMicrosecond;
+
+	Buffer.Reset(FlushSize + TwitchCapture::RecordHeaderSize);
+	Buffer.Append(reinterpret_cast<const uint8*>(TwitchCapture::Magic), sizeof(TwitchCapture::Magic));
+	Buffer.Append(reinterpret_cast<const uint8*>(&TwitchCapture::Version), sizeof(uint16));
+	Buffer.Append(reinterpret_cast<const uint8*>(&StartUnixMicros), sizeof(int64));
+	return true;
+}
+
+void FTwitchCaptureWriter::Write(const uint8* Data, const int32 Size)
+{
+	if (!File.IsValid() || Size <= 0)
+	{
+		return;
+	}
+
+	const int64 TimeMicros = static_cast<int64>((FPlatformTime::Seconds() - StartSeconds) * 1000000.0);
+	const uint32 RecordSize = static_cast<uint32>(Size);
+	Buffer.Append(reinterpret_cast<const uint8*>(&TimeMicros), sizeof(int64));
+	Buffer.Append(reinterpret_cast<const uint8*>(&RecordSize), sizeof(uint32));
+	Buffer.Append(Data, Size);
+	NumBytes += Size;
+
+	if (Buffer.Num() >= FlushSize)
+	{
+		Flush();
+	}
+}
+
+void FTwitchCaptureWriter::Close()
+{
+	if (File.IsValid())
+	{
+		Flush();
+		File->Flush();
+		File.Reset();
+	}
+}
+
+void FTwitchCaptureWriter::Flush()
+{
+	if (Buffer.Num() > 0)
+	{
+		File->Write(Buffer.GetData(), Buffer.Num());
+		Buffer.Reset();
+	}
+}
+
+FTwitchCaptureReader::FTwitchCaptureReader()
+	: Data(nullptr)
+	, Size(0)
+	, ReadPos(0)
+	, StartUnixMicros(0)
+{
+}
+
+FTwitchCaptureReader::~FTwitchCaptureReader()
+{
+	// The region must go before the file it maps
+	MappedRegion.Reset();
+	MappedFile.Reset();
+}
+
+bool FTwitchCaptureReader::Open(const FString& Filename, FString& OutError)
+{
+	MappedRegion.Reset();
+	MappedFile.Reset();
+	Loaded.Empty();
+	Data = nullptr;
+	Size = 0;
+
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+	if (MappedFile.IsValid() && MappedFile->GetFileSize() > 0)
+	{
+		MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize(), true));
+	}
+
+	if (MappedRegion.IsValid())
+	{
+		Data = MappedRegion->GetMappedPtr();
+		Size = MappedRegion->GetMappedSize();
+	}
+	else
+	{
+		MappedFile.Reset();
+		if (!FFileHelper::LoadFileToArray(Loaded, *Filename, FILEREAD_Silent))
+		{
+			OutError = FString::Printf(TEXT("Could not read capture file %s"), *Filename);
+			return false;
+		}
+		Data = Loaded.GetData();
+		Size = Loaded.Num();
+	}
+
+	uint16 FileVersion = 0;
+	if (Size < TwitchCapture::HeaderSize || FMemory::Memcmp(Data, TwitchCapture::Magic, sizeof(TwitchCapture::Magic)) != 0)
+	{
+		OutError = FString::Printf(TEXT("%s is not a capture file"), *Filename);
+		return false;
+	}
+
+	FMemory::Memcpy(&FileVersion, Data + sizeof(TwitchCapture::Magic), sizeof(uint16));
+	if (FileVersion != TwitchCapture::Version)
+	{
+		OutError = FString::Printf(TEXT("Unsupported capture version %d in %s"), FileVersion, *Filename);
+		return false;
+	}
+
+	FMemory::Memcpy(&StartUnixMicros, Data + sizeof(TwitchCapture::Magic) + sizeof(uint16), sizeof(int64));
+	Rewind();
+	return true;
+}
+
+bool FTwitchCaptureReader::Next(int64& OutTimeMicros, const uint8*& OutData, int32& OutSize)
+{
+	if (ReadPos + TwitchCapture::RecordHeaderSize > Size)
+	{
+		return false;
+	}
+
+	// Records are packed, read the header fields without assuming alignment
+	uint32 RecordSize;
+	FMemory::Memcpy(&OutTimeMicros, Data + ReadPos, sizeof(int64));
+	FMemory::Memcpy(&RecordSize, Data + ReadPos + sizeof(int64), sizeof(uint32));
+
+	const int64 RecordStart = ReadPos + TwitchCapture::RecordHeaderSize;
+	if (RecordSize > static_cast<uint32>(MAX_int32) || RecordStart + RecordSize > Size)
+	{
+		return false;
+	}
+
+	OutData = Data + RecordStart;
+	OutSize = static_cast<int32>(RecordSize);
+	ReadPos = RecordStart + RecordSize;
+	return true;
+}
@@ -0,0 +1,470 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Network/TwitchConnectionPool.h"
+
+#include "Hash/CityHash.h"
+#include "LogTwitch.h"
+#include "Misc/Paths.h"
+
+// Weight of the newest sample in the smoothed shard lag
+static constexpr double LagSmoothing = 0.1;
+
+FTwitchConnectionPool::FTwitchConnectionPool()
+	: RecentIdHead(0)
+	, NextRebalanceTime(0)
+{
+}
+
+FTwitchConnectionPool::~FTwitchConnectionPool()
+{
+	// The receivers stop their threads when destroyed
+	Shards.Empty();
+}
+
+void FTwitchConnectionPool::StartConnection(const FString& oAuth, const FString& username, const FString& channel, const float timeBetweenMessages, const int32 numConnections, const FTwitchReceiverSettings& settings)
+{
+	checkf(Shards.Num() == 0, TEXT("FTwitchConnectionPool::StartConnection called more than once?"));
+	OAuth = oAuth;
+	Username = username.ToLower();
+
+	const int32 NumShards = FMath::Max(numConnections, 1);
+	FTwitchReceiverSettings ShardSettings = settings;
+	ShardSettings.RateLimits.NumConnections = NumShards;
+
+	Shards.SetNum(NumShards);
+	for (FShard& Shard : Shards)
+	{
+		Shard.Receiver = MakeUnique<FTwitchMessageReceiver>();
+		Shard.Receiver->StartConnection(OAuth, Username, TEXT(""), timeBetweenMessages, ShardSettings);
+	}
+
+	NextRebalanceTime = FPlatformTime::Seconds() + RebalanceIntervalSeconds;
+
+	if (!channel.IsEmpty())
+	{
+		JoinChannels({channel});
+	}
+}
+
+void FTwitchConnectionPool::StartReplay(const FString& filename, const float speed, const FTwitchReceiverSettings& settings)
+{
+	checkf(Shards.Num() == 0, TEXT("FTwitchConnectionPool::StartReplay called more than once?"));
+
+	Shards.SetNum(1);
+	Shards[0].Receiver = MakeUnique<FTwitchMessageReceiver>();
+	Shards[0].Receiver->StartReplay(filename, speed, settings);
+
+	// A single shard has nothing to rebalance
+	NextRebalanceTime = MAX_dbl;
+}
+
+bool FTwitchConnectionPool::StartCapture(const FString& filename)
+{
+	bool bStarted = true;
+	for (int32 ShardIndex = 0; ShardIndex < Shards.Num(); ++ShardIndex)
+	{
+		FString ShardFilename = filename;
+		if (Shards.Num() > 1)
+		{
+			const FString ShardName = FString::Printf(TEXT("%s_%d%s"), *FPaths::GetBaseFilename(filename), ShardIndex, *FPaths::GetExtension(filename, true));
+			ShardFilename = FPaths::Combine(FPaths::GetPath(filename), ShardName);
+		}
+
+		if (!Shards[ShardIndex].Receiver->StartCapture(ShardFilename))
+		{
+			FLogTwitchPlay::Errorf(TEXT("FTwitchConnectionPool::StartCapture  Could not create %s"), *ShardFilename);
+			bStarted = false;
+		}
+	}
+	return bStarted && Shards.Num() > 0;
+}
+
+void FTwitchConnectionPool::StopCapture()
+{
+	for (FShard& Shard : Shards)
+	{
+		Shard.Receiver->StopCapture();
+	}
+}
+
+bool FTwitchConnectionPool::IsCapturing() const
+{
+	for (const FShard& Shard : Shards)
+	{
+		if (Shard.Receiver->IsCapturing())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void FTwitchConnectionPool::StopConnection(bool bWaitTillComplete)
+{
+	for (FShard& Shard : Shards)
+	{
+		Shard.Receiver->StopConnection(bWaitTillComplete);
+	}
+}
+
+void FTwitchConnectionPool::PullMessages(TArray<FTwitchReceivedMessage>& OutMessages)
+{
+	if (Shards.Num() == 1)
+	{
+		Shards[0].Receiver->PullMessages(OutMessages);
+		return;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	const int64 NowMilliseconds = static_cast<int64>((FDateTime::UtcNow() - FDateTime(1970, 1, 1)).GetTotalMilliseconds());
+
+	for (FShard& Shard : Shards)
+	{
+		Shard.Receiver->PullMessages(Shard.Messages);
+
+		for (const FTwitchReceivedMessage& Message : Shard.Messages)
+		{
+			if (Message.SentTimestamp > 0)
+			{
+				const double Lag = (NowMilliseconds - Message.SentTimestamp) / 1000.0;
+				Shard.LagSeconds += (Lag - Shard.LagSeconds) * LagSmoothing;
+			}
+			++Shard.ChannelMessageCounts.FindOrAdd(Message.ChannelHash);
+		}
+	}
+
+	// Each shard is already in server time order, merge them by always taking the oldest head
+	TArray<int32, TInlineAllocator<16>> Heads;
+	Heads.SetNumZeroed(Shards.Num());
+	for (;;)
+	{
+		int32 Oldest = INDEX_NONE;
+		for (int32 ShardIndex = 0; ShardIndex < Shards.Num(); ++ShardIndex)
+		{
+			const TArray<FTwitchReceivedMessage>& Messages = Shards[ShardIndex].Messages;
+			if (Heads[ShardIndex] < Messages.Num()
+				&& (Oldest == INDEX_NONE || Messages[Heads[ShardIndex]].SentTimestamp < Shards[Oldest].Messages[Heads[Oldest]].SentTimestamp))
+			{
+				Oldest = ShardIndex;
+			}
+		}
+
+		if (Oldest == INDEX_NONE)
+		{
+			break;
+		}
+
+		FTwitchReceivedMessage& Message = Shards[Oldest].Messages[Heads[Oldest]++];
+		if (Message.IdHash != 0 && IsDuplicate(Message.IdHash))
+		{
+			continue;
+		}
+		OutMessages.Add(MoveTemp(Message));
+	}
+
+	// Dropped duplicates release their slabs now rather than next frame
+	for (FShard& Shard : Shards)
+	{
+		Shard.Messages.Reset();
+	}
+
+	FinishHandOvers(Now);
+	if (Now >= NextRebalanceTime)
+	{
+		Rebalance(Now);
+	}
+}
+
+bool FTwitchConnectionPool::SendMessage(const ETwitchSendMessageType type, const FString& message, const FString& channel, const ETwitchMessagePriority priority) const
+{
+	if (Shards.Num() == 0)
+	{
+		return false;
+	}
+
+	int32 ShardIndex = 0;
+	FString TargetChannel = channel;
+	if (type == ETwitchSendMessageType::CHAT_MESSAGE)
+	{
+		// Same form as the joined channel names, the line is built from it
+		TargetChannel = FTwitchMessageReceiver::NormalizeChannel(channel);
+		if (TargetChannel.IsEmpty() && Channels.Num() > 0)
+		{
+			TargetChannel = Channels[0];
+		}
+
+		// Channels we did not join (user channels for instance) go through the first shard
+		if (const int32* ChannelShard = ChannelShards.Find(TargetChannel))
+		{
+			ShardIndex = *ChannelShard;
+		}
+	}
+
+	return Shards[ShardIndex].Receiver->SendMessage(type, message, TargetChannel, priority);
+}
+
+bool FTwitchConnectionPool::PullConnectionMessage(ETwitchConnectionMessageType& OutStatus, FString& OutMessage) const
+{
+	for (const FShard& Shard : Shards)
+	{
+		if (Shard.Receiver->PullConnectionMessage(OutStatus, OutMessage))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void FTwitchConnectionPool::JoinChannels(const TArray<FString>& channels)
+{
+	if (Shards.Num() == 0)
+	{
+		return;
+	}
+
+	// Grouped per shard, so each shard can batch its JOINs
+	TArray<TArray<FString>> ShardChannels;
+	ShardChannels.SetNum(Shards.Num());
+
+	for (const FString& channel : channels)
+	{
+		const FString ChannelName = FTwitchMessageReceiver::NormalizeChannel(channel);
+		if (ChannelName.IsEmpty() || ChannelShards.Contains(ChannelName))
+		{
+			continue;
+		}
+
+		const int32 ShardIndex = FindLeastLoadedShard();
+		++Shards[ShardIndex].NumChannels;
+		ChannelShards.Add(ChannelName, ShardIndex);
+		Channels.Add(ChannelName);
+		ShardChannels[ShardIndex].Add(ChannelName);
+	}
+
+	for (int32 ShardIndex = 0; ShardIndex < Shards.Num(); ++ShardIndex)
+	{
+		if (ShardChannels[ShardIndex].Num() > 0)
+		{
+			Shards[ShardIndex].Receiver->JoinChannels(ShardChannels[ShardIndex]);
+		}
+	}
+}
+
+void FTwitchConnectionPool::LeaveChannels(const TArray<FString>& channels)
+{
+	for (const FString& channel : channels)
+	{
+		const FString ChannelName = FTwitchMessageReceiver::NormalizeChannel(channel);
+
+		int32 ShardIndex;
+		if (!ChannelShards.RemoveAndCopyValue(ChannelName, ShardIndex))
+		{
+			continue;
+		}
+
+		--Shards[ShardIndex].NumChannels;
+		Channels.Remove(ChannelName);
+		Shards[ShardIndex].Receiver->LeaveChannels({ChannelName});
+
+		// Also leave it on the shard it was moving away from
+		for (int32 Index = HandOvers.Num() - 1; Index >= 0; --Index)
+		{
+			if (HandOvers[Index].Channel == ChannelName)
+			{
+				Shards[HandOvers[Index].FromShard].Receiver->LeaveChannels({ChannelName});
+				HandOvers.RemoveAtSwap(Index);
+			}
+		}
+	}
+}
+
+void FTwitchConnectionPool::SetPoll(const TSharedPtr<FTwitchPoll, ESPMode::ThreadSafe>& InPoll)
+{
+	for (FShard& Shard : Shards)
+	{
+		Shard.Receiver->SetPoll(InPoll);
+	}
+}
+
+bool FTwitchConnectionPool::IsConnected() const
+{
+	if (Shards.Num() == 0)
+	{
+		return false;
+	}
+
+	for (const FShard& Shard : Shards)
+	{
+		if (!Shard.Receiver->IsConnected())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int64 FTwitchConnectionPool::GetNumDroppedMessages() const
+{
+	int64 NumDropped = 0;
+	for (const FShard& Shard : Shards)
+	{
+		NumDropped += Shard.Receiver->GetNumDroppedMessages();
+	}
+	return NumDropped;
+}
+
+int32 FTwitchConnectionPool::GetReceiveQueueDepth() const
+{
+	int32 QueueDepth = 0;
+	for (const FShard& Shard : Shards)
+	{
+		QueueDepth += Shard.Receiver->GetReceiveQueueDepth();
+	}
+	return QueueDepth;
+}
+
+double FTwitchConnectionPool::GetLastRecoverySeconds() const
+{
+	double RecoverySeconds = 0.0;
+	for (const FShard& Shard : Shards)
+	{
+		RecoverySeconds = FMath::Max(RecoverySeconds, Shard.Receiver->GetLastRecoverySeconds());
+	}
+	return RecoverySeconds;
+}
+
+FTwitchPipelineStats FTwitchConnectionPool::GetPipelineStats() const
+{
+	FTwitchPipelineStats Stats;
+	for (const FShard& Shard : Shards)
+	{
+		Shard.Receiver->AddPipelineStats(Stats);
+	}
+	Stats.UpdateAverages();
+	return Stats;
+}
+
+void FTwitchConnectionPool::GetConnectionInfo(FString& OutOAuth, FString& OutUsername, FString& OutChannel) const
+{
+	OutOAuth = OAuth;
+	OutUsername = Username;
+	OutChannel = Channels.Num() > 0 ? Channels[0] : FString();
+}
+
+int32 FTwitchConnectionPool::FindLeastLoadedShard() const
+{
+	int32 LeastLoaded = 0;
+	for (int32 ShardIndex = 1; ShardIndex < Shards.Num(); ++ShardIndex)
+	{
+		if (Shards[ShardIndex].NumChannels < Shards[LeastLoaded].NumChannels)
+		{
+			LeastLoaded = ShardIndex;
+		}
+	}
+	return LeastLoaded;
+}
+
+void FTwitchConnectionPool::Rebalance(const double Now)
+{
+	NextRebalanceTime = Now + RebalanceIntervalSeconds;
+
+	int32 Slowest = 0;
+	int32 Fastest = 0;
+	for (int32 ShardIndex = 1; ShardIndex < Shards.Num(); ++ShardIndex)
+	{
+		if (Shards[ShardIndex].LagSeconds > Shards[Slowest].LagSeconds)
+		{
+			Slowest = ShardIndex;
+		}
+		if (Shards[ShardIndex].LagSeconds < Shards[Fastest].LagSeconds)
+		{
+			Fastest = ShardIndex;
+		}
+	}
+
+	FShard& SlowShard = Shards[Slowest];
+	if (Slowest != Fastest && SlowShard.NumChannels > 1 && SlowShard.LagSeconds - Shards[Fastest].LagSeconds > RebalanceLagThresholdSeconds)
+	{
+		// The busiest channel still owned by the slow shard
+		FString Busiest;
+		int32 BusiestCount = 0;
+		for (const TPair<FString, int32>& ChannelShard : ChannelShards)
+		{
+			if (ChannelShard.Value != Slowest)
+			{
+				continue;
+			}
+
+			const FTCHARToUTF8 Utf8Channel(*ChannelShard.Key);
+			const int32* Count = SlowShard.ChannelMessageCounts.Find(CityHash64(Utf8Channel.Get(), Utf8Channel.Length()));
+			if (Count != nullptr && *Count > BusiestCount)
+			{
+				Busiest = ChannelShard.Key;
+				BusiestCount = *Count;
+			}
+		}
+
+		if (!Busiest.IsEmpty())
+		{
+			FLogTwitchPlay::Infof(TEXT("FTwitchConnectionPool::Rebalance  Moving #%s from connection %d (%.2fs behind) to connection %d"),
+				*Busiest, Slowest, SlowShard.LagSeconds, Fastest);
+
+			ChannelShards[Busiest] = Fastest;
+			--SlowShard.NumChannels;
+			++Shards[Fastest].NumChannels;
+			Shards[Fastest].Receiver->JoinChannels({Busiest});
+			HandOvers.Add(FHandOver {Busiest, Slowest, Now + HandOverSeconds});
+		}
+	}
+
+	for (FShard& Shard : Shards)
+	{
+		Shard.ChannelMessageCounts.Reset();
+	}
+}
+
+void FTwitchConnectionPool::FinishHandOvers(const double Now)
+{
+	for (int32 Index = HandOvers.Num() - 1; Index >= 0; --Index)
+	{
+		const FHandOver& HandOver = HandOvers[Index];
+		if (HandOver.LeaveTime > Now)
+		{
+			continue;
+		}
+
+		// Unless the channel moved back in the meantime
+		const int32* Owner = ChannelShards.Find(HandOver.Channel);
+		if (Owner == nullptr || *Owner != HandOver.FromShard)
+		{
+			Shards[HandOver.FromShard].Receiver->LeaveChannels({HandOver.Channel});
+		}
+		HandOvers.RemoveAtSwap(Index);
+	}
+}
+
+bool FTwitchConnectionPool::IsDuplicate(const uint64 IdHash)
+{
+	bool bAlreadySeen = false;
+	RecentIds.Add(IdHash, &bAlreadySeen);
+	if (bAlreadySeen)
+	{
+		return true;
+	}
+
+	if (RecentIdOrder.Num() < MaxRecentIds)
+	{
+		RecentIdOrder.Add(IdHash);
+	}
+	else
+	{
+		RecentIds.Remove(RecentIdOrder[RecentIdHead]);
+		RecentIdOrder[RecentIdHead] = IdHash;
+		RecentIdHead = (RecentIdHead + 1) % MaxRecentIds;
+	}
+
+	return false;
+}
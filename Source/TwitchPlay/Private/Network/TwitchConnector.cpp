@@ -0,0 +1,228 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Network/TwitchConnector.h"
+
+#include "AddressInfoTypes.h"
+#include "HAL/Event.h"
+#include "IPAddress.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+namespace
+{
+	// Shared with the resolving task, which may answer after we gave up waiting for it
+	struct FTwitchResolveRequest
+	{
+		FTwitchResolveRequest()
+			: DoneEvent(FPlatformProcess::GetSynchEventFromPool(true))
+		{
+		}
+
+		~FTwitchResolveRequest()
+		{
+			FPlatformProcess::ReturnSynchEventToPool(DoneEvent);
+		}
+
+		FEvent* DoneEvent;
+
+		// Written by the resolving task before it triggers DoneEvent
+		TArray<TSharedRef<FInternetAddr>> Addresses;
+	};
+}
+
+FTwitchConnector::FTwitchConnector(const FString& InHost, const int32 InPort, const float InTimeoutSeconds, const float InAttemptDelaySeconds)
+	: SocketSubsystem(ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM))
+	, Host(InHost)
+	, Port(InPort)
+	, TimeoutSeconds(FMath::Max(InTimeoutSeconds, 0.1f))
+	, AttemptDelaySeconds(FMath::Max(InAttemptDelaySeconds, 0.0f))
+{
+}
+
+FTwitchConnector::~FTwitchConnector()
+{
+	while (Attempts.Num() > 0)
+	{
+		CloseAttempt(Attempts.Num() - 1);
+	}
+}
+
+FSocket* FTwitchConnector::Connect(FEvent* WakeEvent, TFunctionRef<bool()> ShouldStop, FString& OutError)
+{
+	const double Deadline = FPlatformTime::Seconds() + TimeoutSeconds;
+
+	TArray<TSharedRef<FInternetAddr>> Addresses;
+	if (!Resolve(Deadline, ShouldStop, Addresses, OutError))
+	{
+		return nullptr;
+	}
+
+	int32 NextAddress = 0;
+	double NextAttemptTime = 0.0;
+	FSocket* ConnectedSocket = nullptr;
+	while (ConnectedSocket == nullptr)
+	{
+		if (ShouldStop())
+		{
+			OutError = TEXT("Stopped");
+			break;
+		}
+
+		const double Now = FPlatformTime::Seconds();
+		if (Now >= Deadline)
+		{
+			OutError = FString::Printf(TEXT("Connection to %s:%d timed out after %.1f seconds"), *Host, Port, TimeoutSeconds);
+			break;
+		}
+
+		// The next address gets its attempt once the last one had its head start, or right away if the others failed already
+		if (NextAddress < Addresses.Num() && (Now >= NextAttemptTime || Attempts.Num() == 0))
+		{
+			NextAttemptTime = StartAttempt(Addresses[NextAddress++]) ? Now + AttemptDelaySeconds : Now;
+		}
+
+		// Oldest first, if two attempts are done at once the preferred address wins
+		for (int32 Index = 0; Index < Attempts.Num();)
+		{
+			const ESocketConnectionState State = Attempts[Index]->GetConnectionState();
+			if (State == ESocketConnectionState::SCS_Connected)
+			{
+				ConnectedSocket = Attempts[Index];
+				Attempts.RemoveAt(Index);
+				break;
+			}
+
+			if (State == ESocketConnectionState::SCS_ConnectionError)
+			{
+				CloseAttempt(Index);
+				continue;
+			}
+
+			++Index;
+		}
+
+		if (ConnectedSocket == nullptr)
+		{
+			if (Attempts.Num() == 0 && NextAddress >= Addresses.Num())
+			{
+				OutError = FString::Printf(TEXT("Connection to %s:%d failed!"), *Host, Port);
+				break;
+			}
+
+			// A stop request wakes us up
+			WakeEvent->Wait(PollMilliseconds);
+		}
+	}
+
+	// The attempts that lost the race
+	while (Attempts.Num() > 0)
+	{
+		CloseAttempt(Attempts.Num() - 1);
+	}
+
+	return ConnectedSocket;
+}
+
+bool FTwitchConnector::Resolve(const double Deadline, TFunctionRef<bool()> ShouldStop, TArray<TSharedRef<FInternetAddr>>& OutAddresses, FString& OutError)
+{
+	TSharedRef<FTwitchResolveRequest, ESPMode::ThreadSafe> Request = MakeShared<FTwitchResolveRequest, ESPMode::ThreadSafe>();
+	SocketSubsystem->GetAddressInfoAsync([Request](FAddressInfoResult Result)
+	{
+		for (const FAddressInfoResultData& Data : Result.Results)
+		{
+			Request->Addresses.Add(Data.Address);
+		}
+		Request->DoneEvent->Trigger();
+	}, *Host, nullptr, EAddressInfoFlags::OnlyUsableAddresses, NAME_None, SOCKTYPE_Streaming);
+
+	// A slow resolver costs at most the timeout, and never delays a stop request
+	while (!Request->DoneEvent->Wait(PollMilliseconds))
+	{
+		if (ShouldStop())
+		{
+			OutError = TEXT("Stopped");
+			return false;
+		}
+
+		if (FPlatformTime::Seconds() >= Deadline)
+		{
+			OutError = FString::Printf(TEXT("Could not resolve %s in %.1f seconds"), *Host, TimeoutSeconds);
+			return false;
+		}
+	}
+
+	if (Request->Addresses.Num() == 0)
+	{
+		OutError = TEXT("Could not resolve hostname!");
+		return false;
+	}
+
+	// The two address families alternate, starting with the one the resolver prefers, so a broken one costs a single attempt delay
+	const FName PreferredFamily = Request->Addresses[0]->GetProtocolType();
+	TArray<TSharedRef<FInternetAddr>> Preferred;
+	TArray<TSharedRef<FInternetAddr>> Others;
+	for (const TSharedRef<FInternetAddr>& ResolvedAddress : Request->Addresses)
+	{
+		TSharedRef<FInternetAddr> Address = ResolvedAddress->Clone();
+		Address->SetPort(Port);
+		(Address->GetProtocolType() == PreferredFamily ? Preferred : Others).Add(Address);
+	}
+
+	OutAddresses.Reset(Request->Addresses.Num());
+	for (int32 Index = 0; Index < FMath::Max(Preferred.Num(), Others.Num()); ++Index)
+	{
+		if (Preferred.IsValidIndex(Index))
+		{
+			OutAddresses.Add(Preferred[Index]);
+		}
+		if (Others.IsValidIndex(Index))
+		{
+			OutAddresses.Add(Others[Index]);
+		}
+	}
+	return true;
+}
+
+bool FTwitchConnector::StartAttempt(const TSharedRef<FInternetAddr>& Address)
+{
+	FSocket* Socket = SocketSubsystem->CreateSocket(NAME_Stream, TEXT("TwitchPlay Socket"), Address->GetProtocolType());
+
+	// Socket creation might fail on certain subsystems, or for a family the machine has no route for
+	if (Socket == nullptr)
+	{
+		return false;
+	}
+
+	// Setting underlying connection parameters
+	int32 SizeOut;
+	Socket->SetReceiveBufferSize(2 * 1024 * 1024, SizeOut);
+	Socket->SetReuseAddr(true);
+
+	// The connection goes on in the background. Once connected, writes take what fits in the socket buffer instead of waiting for room
+	bool bStarted = Socket->SetNonBlocking(true);
+	if (bStarted && !Socket->Connect(*Address))
+	{
+		// Depending on the platform, a connection still in progress is reported as a failure
+		const ESocketErrors Error = SocketSubsystem->GetLastErrorCode();
+		bStarted = Error == SE_EINPROGRESS || Error == SE_EWOULDBLOCK;
+	}
+
+	if (!bStarted)
+	{
+		Socket->Close();
+		SocketSubsystem->DestroySocket(Socket);
+		return false;
+	}
+
+	Attempts.Add(Socket);
+	return true;
+}
+
+void FTwitchConnector::CloseAttempt(const int32 Index)
+{
+	FSocket* Socket = Attempts[Index];
+	Attempts.RemoveAt(Index);
+	Socket->Close();
+	SocketSubsystem->DestroySocket(Socket);
+}
@@ -0,0 +1,744 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Network/TwitchMockIrcServer.h"
+
+#if WITH_TWITCHPLAY_MOCK_SERVER
+
+#include "HAL/IConsoleManager.h"
+#include "HAL/RunnableThread.h"
+#include "LogTwitch.h"
+#include "Misc/Parse.h"
+#include "Misc/StringBuilder.h"
+#include "Parsing/TwitchIrcMessage.h"
+#include "Parsing/TwitchUtf8.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+namespace
+{
+	// Words the chat messages are made of. Some are not ASCII, and one is out of the BMP, to exercise the emote offsets
+	const ANSICHAR* const ChatWords[] = {
+		"hello", "gg", "lol", "pog", "nice", "wow", "1", "2", "left", "right", "what", "is", "this", "game",
+		"jump", "go", "no", "yes", "LUL", "d\xC3\xADa", "\xF0\x9F\x99\x82", "caf\xC3\xA9"
+	};
+
+	const ANSICHAR* const ChatCommands[] = {
+		"!jump!", "!left!", "!right!", "!vote!#1#!", "!spawn!#zombie,3#!"
+	};
+
+	struct FMockEmote
+	{
+		const ANSICHAR* Id;
+		const ANSICHAR* Name;
+	};
+
+	const FMockEmote ChatEmotes[] = {
+		{ "25", "Kappa" },
+		{ "1902", "Keepo" },
+		{ "305954156", "PogChamp" },
+		{ "emotesv2_dcd06b30a5c24f6eb871e8f5edbd44f7", "DinoDance" }
+	};
+
+	constexpr int32 NumChatEmotes = UE_ARRAY_COUNT(ChatEmotes);
+
+	// Characters as the server counts them in the emotes tag
+	int32 CountCodePoints(const FAnsiStringView& Text)
+	{
+		int32 NumCodePoints = 0;
+		for (const ANSICHAR Char : Text)
+		{
+			NumCodePoints += (static_cast<uint8>(Char) & 0xC0) != 0x80;
+		}
+		return NumCodePoints;
+	}
+
+	FAnsiStringView ToView(const TArray<ANSICHAR>& Text)
+	{
+		return FAnsiStringView(Text.GetData(), Text.Num());
+	}
+
+	int64 GetUnixMilliseconds()
+	{
+		return static_cast<int64>((FDateTime::UtcNow() - FDateTime(1970, 1, 1)).GetTotalMilliseconds());
+	}
+}
+
+FTwitchMockServerSettings FTwitchMockServerSettings::Parse(const TCHAR* Args)
+{
+	FTwitchMockServerSettings Settings;
+	FParse::Value(Args, TEXT("Port="), Settings.Port);
+	FParse::Value(Args, TEXT("Rate="), Settings.MessagesPerSecond);
+	FParse::Value(Args, TEXT("Chatters="), Settings.NumChatters);
+	FParse::Value(Args, TEXT("Emotes="), Settings.EmoteChance);
+	FParse::Value(Args, TEXT("Commands="), Settings.CommandChance);
+	FParse::Value(Args, TEXT("Ping="), Settings.PingIntervalSeconds);
+	FParse::Value(Args, TEXT("Fragment="), Settings.FragmentChance);
+	FParse::Value(Args, TEXT("BytesPerSecond="), Settings.MaxBytesPerSecond);
+	FParse::Value(Args, TEXT("Burst="), Settings.BurstSize);
+	FParse::Value(Args, TEXT("BurstInterval="), Settings.BurstIntervalSeconds);
+	FParse::Value(Args, TEXT("HalfOpenAfter="), Settings.HalfOpenAfterSeconds);
+	FParse::Value(Args, TEXT("ReconnectAfter="), Settings.ReconnectAfterSeconds);
+	FParse::Bool(Args, TEXT("RejectAuth="), Settings.bRejectAuth);
+	FParse::Value(Args, TEXT("Seed="), Settings.Seed);
+	return Settings;
+}
+
+FTwitchMockIrcServer::FTwitchMockIrcServer()
+	: Listener(nullptr)
+	, Thread(nullptr)
+	, NextMessageId(1)
+	, Port(0)
+	, bStopping(false)
+	, PendingBurst(0)
+	, bReconnectRequested(false)
+	, bHalfOpenRequested(false)
+	, NumClients(0)
+	, NumMessagesSent(0)
+	, NumBytesSent(0)
+	, NumMessagesReceived(0)
+{
+}
+
+FTwitchMockIrcServer::~FTwitchMockIrcServer()
+{
+	Shutdown();
+}
+
+bool FTwitchMockIrcServer::Start(const FTwitchMockServerSettings& InSettings, FString& OutError)
+{
+	checkf(!Thread, TEXT("FTwitchMockIrcServer::Start called more than once?"));
+	Settings = InSettings;
+	Random.Initialize(Settings.Seed);
+
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	TSharedRef<FInternetAddr> Address = SocketSubsystem->CreateInternetAddr();
+	Address->SetLoopbackAddress();
+	Address->SetPort(Settings.Port);
+
+	Listener = SocketSubsystem->CreateSocket(NAME_Stream, TEXT("TwitchPlay Mock Server"), false);
+	if (Listener == nullptr)
+	{
+		OutError = TEXT("Could not create socket!");
+		return false;
+	}
+
+	Listener->SetReuseAddr(true);
+	Listener->SetNonBlocking(true);
+	if (!Listener->Bind(*Address) || !Listener->Listen(16))
+	{
+		SocketSubsystem->DestroySocket(Listener);
+		Listener = nullptr;
+		OutError = FString::Printf(TEXT("Could not listen on port %d"), Settings.Port);
+		return false;
+	}
+
+	Port = Listener->GetPortNo();
+	Thread = FRunnableThread::Create(this, TEXT("FTwitchMockIrcServer"));
+	return true;
+}
+
+void FTwitchMockIrcServer::Shutdown()
+{
+	if (Thread != nullptr)
+	{
+		Stop();
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	if (Listener != nullptr)
+	{
+		Listener->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Listener);
+		Listener = nullptr;
+	}
+}
+
+void FTwitchMockIrcServer::Stop()
+{
+	bStopping = true;
+}
+
+void FTwitchMockIrcServer::TriggerBurst(const int32 NumMessages)
+{
+	PendingBurst += FMath::Max(NumMessages, 0);
+}
+
+void FTwitchMockIrcServer::TriggerReconnect()
+{
+	bReconnectRequested = true;
+}
+
+void FTwitchMockIrcServer::TriggerHalfOpen()
+{
+	bHalfOpenRequested = true;
+}
+
+uint32 FTwitchMockIrcServer::Run()
+{
+	while (!bStopping)
+	{
+		const double Now = FPlatformTime::Seconds();
+		AcceptClients(Now);
+
+		const int32 Burst = PendingBurst.exchange(0);
+		const bool bReconnectAll = bReconnectRequested.exchange(false);
+		const bool bHalfOpenAll = bHalfOpenRequested.exchange(false);
+		for (const TUniquePtr<FClient>& Client : Clients)
+		{
+			Client->MessageBudget += Burst;
+			if (bReconnectAll && Client->bLoggedIn && !Client->bReconnectSent)
+			{
+				AppendLine(*Client, ":tmi.twitch.tv RECONNECT");
+				Client->bReconnectSent = true;
+				Client->bCloseWhenSent = true;
+			}
+			Client->bHalfOpen |= bHalfOpenAll;
+		}
+
+		for (int32 Index = Clients.Num() - 1; Index >= 0; --Index)
+		{
+			FClient& Client = *Clients[Index];
+
+			bool bOpen = ReadClient(Client, Now);
+			if (bOpen)
+			{
+				UpdateClient(Client, Now);
+				bOpen = FlushClient(Client, Now);
+			}
+
+			if (!bOpen)
+			{
+				CloseClient(Client);
+				Clients.RemoveAtSwap(Index);
+			}
+		}
+
+		// The budgets keep the rates, whatever the time between two passes
+		FPlatformProcess::SleepNoStats(0.001f);
+	}
+
+	for (const TUniquePtr<FClient>& Client : Clients)
+	{
+		CloseClient(*Client);
+	}
+	Clients.Empty();
+
+	return 0;
+}
+
+void FTwitchMockIrcServer::AcceptClients(const double Now)
+{
+	bool bHasPending = false;
+	while (Listener->HasPendingConnection(bHasPending) && bHasPending)
+	{
+		FSocket* Socket = Listener->Accept(TEXT("TwitchPlay Mock Client"));
+		if (Socket == nullptr)
+		{
+			break;
+		}
+
+		// No delay, so a fragmented write really goes out as several packets
+		Socket->SetNonBlocking(true);
+		Socket->SetNoDelay(true);
+
+		TUniquePtr<FClient> Client = MakeUnique<FClient>();
+		Client->Socket = Socket;
+		Client->LastUpdateTime = Now;
+		Clients.Add(MoveTemp(Client));
+		++NumClients;
+	}
+}
+
+bool FTwitchMockIrcServer::ReadClient(FClient& Client, const double Now)
+{
+	for (;;)
+	{
+		int32 FreeSpace;
+		uint8* Buffer = Client.Framer.GetWriteBuffer(FreeSpace);
+
+		// Nothing to read is not an error on a non blocking socket, a closed connection is
+		int32 BytesRead = 0;
+		if (!Client.Socket->Recv(Buffer, FreeSpace, BytesRead))
+		{
+			return false;
+		}
+		if (BytesRead <= 0)
+		{
+			return true;
+		}
+		Client.Framer.CommitWrite(BytesRead);
+
+		FAnsiStringView Line;
+		while (Client.Framer.PopLine(Line))
+		{
+			// A half open connection still reads, to notice when the client gives up, but never answers
+			if (!Client.bHalfOpen)
+			{
+				HandleLine(Client, Line, Now);
+			}
+		}
+	}
+}
+
+void FTwitchMockIrcServer::HandleLine(FClient& Client, const FAnsiStringView& Line, const double Now)
+{
+	FTwitchIrcMessage Message;
+	if (!FTwitchIrcMessage::Parse(Line, Message))
+	{
+		return;
+	}
+
+	TAnsiStringBuilder<512> Reply;
+
+	if (Message.IsCommand("NICK"))
+	{
+		const FAnsiStringView Nick = Message.GetFirstParam();
+		Client.Nick.Reset();
+		Client.Nick.Append(Nick.GetData(), Nick.Len());
+
+		if (Settings.bRejectAuth)
+		{
+			AppendLine(Client, ":tmi.twitch.tv NOTICE * :Login authentication failed");
+			Client.bCloseWhenSent = true;
+			return;
+		}
+
+		// Numeric reply and its text
+		static const ANSICHAR* const WelcomeLines[][2] = {
+			{ "001", "Welcome, GLHF!" },
+			{ "002", "Your host is tmi.twitch.tv" },
+			{ "003", "This server is rather new" },
+			{ "004", "-" },
+			{ "375", "-" },
+			{ "372", "You are in a maze of twisty passages, all alike." },
+			{ "376", ">" }
+		};
+		for (const ANSICHAR* const* WelcomeLine : WelcomeLines)
+		{
+			Reply.Reset();
+			Reply << ":tmi.twitch.tv " << WelcomeLine[0] << ' ' << Nick << " :" << WelcomeLine[1];
+			AppendLine(Client, Reply.ToView());
+		}
+
+		Client.bLoggedIn = true;
+		Client.LoginTime = Now;
+		Client.NextPingTime = Now + Settings.PingIntervalSeconds;
+		Client.NextBurstTime = Now + Settings.BurstIntervalSeconds;
+		return;
+	}
+
+	// PASS is accepted as is, anything else waits for the login
+	if (!Client.bLoggedIn)
+	{
+		return;
+	}
+
+	const FAnsiStringView Nick = ToView(Client.Nick);
+
+	if (Message.IsCommand("PING"))
+	{
+		Reply.Appendf(":tmi.twitch.tv PONG tmi.twitch.tv :%.*s", Message.Trailing.Len(), Message.Trailing.GetData());
+		AppendLine(Client, Reply.ToView());
+	}
+	else if (Message.IsCommand("CAP"))
+	{
+		Reply.Appendf(":tmi.twitch.tv CAP * ACK :%.*s", Message.Trailing.Len(), Message.Trailing.GetData());
+		AppendLine(Client, Reply.ToView());
+	}
+	else if (Message.IsCommand("JOIN") || Message.IsCommand("PART"))
+	{
+		const bool bJoin = Message.IsCommand("JOIN");
+
+		// "#a,#b,#c"
+		FAnsiStringView ChannelList = Message.GetFirstParam();
+		while (!ChannelList.IsEmpty())
+		{
+			int32 Comma;
+			if (!ChannelList.FindChar(',', Comma))
+			{
+				Comma = ChannelList.Len();
+			}
+			FAnsiStringView Channel = ChannelList.Left(Comma);
+			ChannelList.RightChopInline(Comma + 1);
+			Channel.RemovePrefix(Channel.StartsWith('#') ? 1 : 0);
+			if (Channel.IsEmpty())
+			{
+				continue;
+			}
+
+			const int32 Existing = Client.Channels.IndexOfByPredicate([&Channel](const TPair<FString, int32>& JoinedChannel)
+			{
+				return JoinedChannel.Key.Equals(TwitchUtf8::ToString(Channel));
+			});
+
+			Reply.Reset();
+			Reply.Appendf(":%.*s!%.*s@%.*s.tmi.twitch.tv %s #%.*s", Nick.Len(), Nick.GetData(), Nick.Len(), Nick.GetData(), Nick.Len(), Nick.GetData(),
+				bJoin ? "JOIN" : "PART", Channel.Len(), Channel.GetData());
+			AppendLine(Client, Reply.ToView());
+
+			if (!bJoin)
+			{
+				if (Existing != INDEX_NONE)
+				{
+					Client.Channels.RemoveAtSwap(Existing);
+				}
+				continue;
+			}
+
+			const int32 Joined = Existing != INDEX_NONE ? Existing : Client.Channels.Emplace(TwitchUtf8::ToString(Channel), 1000 + Random.RandHelper(1000000));
+
+			Reply.Reset();
+			Reply.Appendf("@badge-info=;badges=;color=;display-name=%.*s;emote-sets=0;mod=0;subscriber=0;user-type= :tmi.twitch.tv USERSTATE #%.*s",
+				Nick.Len(), Nick.GetData(), Channel.Len(), Channel.GetData());
+			AppendLine(Client, Reply.ToView());
+
+			Reply.Reset();
+			Reply.Appendf("@emote-only=0;followers-only=-1;r9k=0;room-id=%d;slow=0;subs-only=0 :tmi.twitch.tv ROOMSTATE #%.*s",
+				Client.Channels[Joined].Value, Channel.Len(), Channel.GetData());
+			AppendLine(Client, Reply.ToView());
+		}
+	}
+	else if (Message.IsCommand("PRIVMSG"))
+	{
+		++NumMessagesReceived;
+
+		// Twitch does not echo our own messages, only our user state in the channel
+		const FAnsiStringView Channel = Message.GetFirstParam();
+		Reply.Appendf("@badge-info=;badges=;color=;display-name=%.*s;emote-sets=0;mod=0;subscriber=0;user-type= :tmi.twitch.tv USERSTATE %.*s",
+			Nick.Len(), Nick.GetData(), Channel.Len(), Channel.GetData());
+		AppendLine(Client, Reply.ToView());
+	}
+}
+
+void FTwitchMockIrcServer::UpdateClient(FClient& Client, const double Now)
+{
+	const double Elapsed = Now - Client.LastUpdateTime;
+	Client.LastUpdateTime = Now;
+
+	// At most a second worth of bytes saved up
+	if (Settings.MaxBytesPerSecond > 0)
+	{
+		Client.ByteBudget = FMath::Min(Client.ByteBudget + Elapsed * Settings.MaxBytesPerSecond, static_cast<double>(Settings.MaxBytesPerSecond));
+	}
+
+	if (!Client.bLoggedIn || Client.bHalfOpen || Client.bReconnectSent)
+	{
+		return;
+	}
+
+	const double ConnectedSeconds = Now - Client.LoginTime;
+	if (Settings.HalfOpenAfterSeconds > 0.0f && ConnectedSeconds >= Settings.HalfOpenAfterSeconds)
+	{
+		Client.bHalfOpen = true;
+		return;
+	}
+
+	if (Settings.ReconnectAfterSeconds > 0.0f && ConnectedSeconds >= Settings.ReconnectAfterSeconds)
+	{
+		AppendLine(Client, ":tmi.twitch.tv RECONNECT");
+		Client.bReconnectSent = true;
+		Client.bCloseWhenSent = true;
+		return;
+	}
+
+	if (Settings.PingIntervalSeconds > 0.0f && Now >= Client.NextPingTime)
+	{
+		AppendLine(Client, "PING :tmi.twitch.tv");
+		Client.NextPingTime = Now + Settings.PingIntervalSeconds;
+	}
+
+	Client.MessageBudget += Elapsed * Settings.MessagesPerSecond * Client.Channels.Num();
+	if (Settings.BurstSize > 0 && Now >= Client.NextBurstTime)
+	{
+		Client.MessageBudget += Settings.BurstSize;
+		Client.NextBurstTime = Now + Settings.BurstIntervalSeconds;
+	}
+
+	if (Client.Channels.Num() == 0)
+	{
+		Client.MessageBudget = 0.0;
+		return;
+	}
+
+	while (Client.MessageBudget >= 1.0 && Client.Pending.Num() - Client.PendingOffset < MaxPendingBytes)
+	{
+		AppendChatMessage(Client);
+		Client.MessageBudget -= 1.0;
+	}
+
+	// A client that does not keep up misses the messages it could not take
+	Client.MessageBudget = FMath::Min(Client.MessageBudget, 1.0);
+}
+
+bool FTwitchMockIrcServer::FlushClient(FClient& Client, const double Now)
+{
+	if (Client.bHalfOpen)
+	{
+		return true;
+	}
+
+	int32 NumBytes = Client.Pending.Num() - Client.PendingOffset;
+	if (NumBytes == 0)
+	{
+		return !Client.bCloseWhenSent;
+	}
+
+	if (Settings.MaxBytesPerSecond > 0)
+	{
+		NumBytes = FMath::Min(NumBytes, static_cast<int32>(Client.ByteBudget));
+		if (NumBytes <= 0)
+		{
+			return true;
+		}
+	}
+
+	// Cut anywhere, even in the middle of a UTF-8 character. The rest goes out on the next pass
+	if (Settings.FragmentChance > 0.0f && NumBytes > 1 && Random.FRand() < Settings.FragmentChance)
+	{
+		NumBytes = 1 + Random.RandHelper(NumBytes - 1);
+	}
+
+	int32 BytesSent = 0;
+	if (!Client.Socket->Send(Client.Pending.GetData() + Client.PendingOffset, NumBytes, BytesSent))
+	{
+		if (ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->GetLastErrorCode() != SE_EWOULDBLOCK)
+		{
+			return false;
+		}
+		BytesSent = 0;
+	}
+
+	Client.PendingOffset += BytesSent;
+	Client.ByteBudget -= BytesSent;
+	NumBytesSent += BytesSent;
+
+	if (Client.PendingOffset == Client.Pending.Num())
+	{
+		Client.Pending.Reset();
+		Client.PendingOffset = 0;
+		return !Client.bCloseWhenSent;
+	}
+
+	if (Client.PendingOffset >= 64 * 1024)
+	{
+		Client.Pending.RemoveAt(0, Client.PendingOffset, false);
+		Client.PendingOffset = 0;
+	}
+	return true;
+}
+
+void FTwitchMockIrcServer::AppendChatMessage(FClient& Client)
+{
+	const TPair<FString, int32>& Channel = Client.Channels[Random.RandHelper(Client.Channels.Num())];
+	const FTCHARToUTF8 ChannelName(*Channel.Key);
+
+	// The same chatter always has the same badges and color
+	const int32 Chatter = Random.RandHelper(FMath::Max(Settings.NumChatters, 1));
+	const int64 UserId = 100000000 + Chatter;
+	const bool bSubscriber = Chatter % 5 == 0;
+	const bool bModerator = Chatter % 97 == 0;
+	const bool bVip = Chatter % 89 == 0;
+	const bool bPrime = Chatter % 3 == 0;
+	const uint32 Color = static_cast<uint32>(Chatter) * 2654435761u & 0xFFFFFF;
+
+	// Text, with the emote positions in characters
+	TAnsiStringBuilder<256> Text;
+	TArray<TPair<int32, int32>, TInlineAllocator<8>> EmoteRanges[NumChatEmotes];
+	if (Random.FRand() < Settings.CommandChance)
+	{
+		Text << ChatCommands[Random.RandHelper(UE_ARRAY_COUNT(ChatCommands))];
+	}
+	else
+	{
+		int32 NumCodePoints = 0;
+		const int32 NumWords = 1 + Random.RandHelper(8);
+		for (int32 WordIndex = 0; WordIndex < NumWords; ++WordIndex)
+		{
+			if (WordIndex > 0)
+			{
+				Text << ' ';
+				++NumCodePoints;
+			}
+
+			if (Random.FRand() < Settings.EmoteChance)
+			{
+				const int32 Emote = Random.RandHelper(NumChatEmotes);
+				const FAnsiStringView Name(ChatEmotes[Emote].Name);
+				EmoteRanges[Emote].Emplace(NumCodePoints, NumCodePoints + Name.Len() - 1);
+				Text << Name;
+				NumCodePoints += Name.Len();
+			}
+			else
+			{
+				const FAnsiStringView Word(ChatWords[Random.RandHelper(UE_ARRAY_COUNT(ChatWords))]);
+				Text << Word;
+				NumCodePoints += CountCodePoints(Word);
+			}
+		}
+	}
+
+	// "25:0-4,12-16/1902:6-10"
+	TAnsiStringBuilder<128> Emotes;
+	for (int32 Emote = 0; Emote < NumChatEmotes; ++Emote)
+	{
+		for (int32 RangeIndex = 0; RangeIndex < EmoteRanges[Emote].Num(); ++RangeIndex)
+		{
+			if (RangeIndex == 0)
+			{
+				if (Emotes.Len() > 0)
+				{
+					Emotes << '/';
+				}
+				Emotes << ChatEmotes[Emote].Id << ':';
+			}
+			else
+			{
+				Emotes << ',';
+			}
+			Emotes.Appendf("%d-%d", EmoteRanges[Emote][RangeIndex].Key, EmoteRanges[Emote][RangeIndex].Value);
+		}
+	}
+
+	TAnsiStringBuilder<96> Badges;
+	auto AddBadge = [&Badges](const bool bHasBadge, const ANSICHAR* Badge)
+	{
+		if (bHasBadge)
+		{
+			Badges << (Badges.Len() > 0 ? "," : "") << Badge;
+		}
+	};
+	AddBadge(bModerator, "moderator/1");
+	AddBadge(bVip, "vip/1");
+	AddBadge(bSubscriber, "subscriber/12");
+	AddBadge(bPrime, "premium/1");
+
+	TAnsiStringBuilder<1024> Line;
+	Line.Appendf("@badge-info=%s;badges=%s;color=#%06X;display-name=User%d;emotes=%.*s;first-msg=%d;flags=;id=%08x-%04x-4%03x-8%03x-%012llx;mod=%d;"
+		"returning-chatter=0;room-id=%d;subscriber=%d;tmi-sent-ts=%lld;turbo=0;user-id=%lld;user-type=%s",
+		bSubscriber ? "subscriber/12" : "", *Badges,
+		Color, Chatter, Emotes.Len(), Emotes.GetData(), Random.FRand() < 0.01f ? 1 : 0,
+		static_cast<uint32>(NextMessageId >> 32), static_cast<uint32>(Chatter & 0xFFFF), static_cast<uint32>(Random.RandHelper(0x1000)), static_cast<uint32>(Random.RandHelper(0x1000)),
+		static_cast<unsigned long long>(NextMessageId & 0xFFFFFFFFFFFFull), bModerator ? 1 : 0,
+		Channel.Value, bSubscriber ? 1 : 0, static_cast<long long>(GetUnixMilliseconds()), static_cast<long long>(UserId), bModerator ? "mod" : "");
+	Line.Appendf(" :user%d!user%d@user%d.tmi.twitch.tv PRIVMSG #%.*s :", Chatter, Chatter, Chatter, ChannelName.Length(), ChannelName.Get());
+	Line << Text.ToView();
+	++NextMessageId;
+
+	AppendLine(Client, Line.ToView());
+	++NumMessagesSent;
+}
+
+void FTwitchMockIrcServer::AppendLine(FClient& Client, const FAnsiStringView& Line)
+{
+	Client.Pending.Append(reinterpret_cast<const uint8*>(Line.GetData()), Line.Len());
+	Client.Pending.Add('\r');
+	Client.Pending.Add('\n');
+}
+
+void FTwitchMockIrcServer::CloseClient(FClient& Client)
+{
+	if (Client.Socket != nullptr)
+	{
+		Client.Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Client.Socket);
+		Client.Socket = nullptr;
+		--NumClients;
+	}
+}
+
+/////////////////// Console commands
+
+namespace TwitchMockServer
+{
+	static TUniquePtr<FTwitchMockIrcServer> ConsoleServer;
+
+	static void StartServer(const TArray<FString>& Args)
+	{
+		ShutdownConsoleServer();
+
+		const FTwitchMockServerSettings Settings = FTwitchMockServerSettings::Parse(*FString::Join(Args, TEXT(" ")));
+		TUniquePtr<FTwitchMockIrcServer> Server = MakeUnique<FTwitchMockIrcServer>();
+		FString Error;
+		if (!Server->Start(Settings, Error))
+		{
+			FLogTwitchPlay::Errorf(TEXT("TwitchPlay.MockServer.Start  %s"), *Error);
+			return;
+		}
+
+		FLogTwitchPlay::Infof(TEXT("TwitchPlay.MockServer.Start  Listening on 127.0.0.1:%d, %.1f messages per second per channel"), Server->GetPort(), Settings.MessagesPerSecond);
+		ConsoleServer = MoveTemp(Server);
+	}
+
+	static void PrintStats()
+	{
+		if (!ConsoleServer.IsValid())
+		{
+			FLogTwitchPlay::Info(TEXT("TwitchPlay.MockServer.Stats  Not running"));
+			return;
+		}
+
+		FLogTwitchPlay::Infof(TEXT("TwitchPlay.MockServer.Stats  Port %d, %d clients, %lld messages and %lld bytes sent, %lld messages received"),
+			ConsoleServer->GetPort(), ConsoleServer->GetNumClients(), ConsoleServer->GetNumMessagesSent(), ConsoleServer->GetNumBytesSent(), ConsoleServer->GetNumMessagesReceived());
+	}
+
+	static void Burst(const TArray<FString>& Args)
+	{
+		if (ConsoleServer.IsValid())
+		{
+			ConsoleServer->TriggerBurst(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1000);
+		}
+	}
+
+	static FAutoConsoleCommand StartCommand(
+		TEXT("TwitchPlay.MockServer.Start"),
+		TEXT("Starts the loopback mock Twitch IRC server, replacing the running one. Connect to it with ServerHost 127.0.0.1.\n")
+		TEXT("Options: Port= Rate= Chatters= Emotes= Commands= Ping= Fragment= BytesPerSecond= Burst= BurstInterval= HalfOpenAfter= ReconnectAfter= RejectAuth= Seed="),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&StartServer));
+
+	static FAutoConsoleCommand StopCommand(
+		TEXT("TwitchPlay.MockServer.Stop"),
+		TEXT("Stops the mock Twitch IRC server"),
+		FConsoleCommandDelegate::CreateStatic(&ShutdownConsoleServer));
+
+	static FAutoConsoleCommand StatsCommand(
+		TEXT("TwitchPlay.MockServer.Stats"),
+		TEXT("Logs the mock Twitch IRC server traffic"),
+		FConsoleCommandDelegate::CreateStatic(&PrintStats));
+
+	static FAutoConsoleCommand BurstCommand(
+		TEXT("TwitchPlay.MockServer.Burst"),
+		TEXT("Sends extra chat messages to every client at once. Argument: number of messages, 1000 by default"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&Burst));
+
+	static FAutoConsoleCommand ReconnectCommand(
+		TEXT("TwitchPlay.MockServer.Reconnect"),
+		TEXT("Sends RECONNECT to every client and closes their connections"),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			if (ConsoleServer.IsValid())
+			{
+				ConsoleServer->TriggerReconnect();
+			}
+		}));
+
+	static FAutoConsoleCommand HalfOpenCommand(
+		TEXT("TwitchPlay.MockServer.HalfOpen"),
+		TEXT("Makes every client connection go silent without closing it"),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			if (ConsoleServer.IsValid())
+			{
+				ConsoleServer->TriggerHalfOpen();
+			}
+		}));
+
+	void ShutdownConsoleServer()
+	{
+		ConsoleServer.Reset();
+	}
+}
+
+#endif // WITH_TWITCHPLAY_MOCK_SERVER
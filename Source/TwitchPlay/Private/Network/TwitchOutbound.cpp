@@ -0,0 +1,191 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Network/TwitchOutbound.h"
+
+#include "Hash/CityHash.h"
+
+int32 TwitchOutbound::FindSplit(const FAnsiStringView& Text, const int32 MaxBytes)
+{
+	if (Text.Len() <= MaxBytes)
+	{
+		return Text.Len();
+	}
+
+	// Never cut inside a multi byte sequence, continuation bytes are 10xxxxxx
+	int32 Cut = MaxBytes;
+	while (Cut > 0 && (static_cast<uint8>(Text[Cut]) & 0xC0) == 0x80)
+	{
+		--Cut;
+	}
+
+	// A word cut in half reads badly, cut at the last space unless it leaves a tiny chunk
+	for (int32 Index = Cut; Index > MaxBytes / 2; --Index)
+	{
+		if (Text[Index] == ' ')
+		{
+			return Index;
+		}
+	}
+
+	return Cut > 0 ? Cut : MaxBytes;
+}
+
+int32 TwitchOutbound::FindRepeatedCommand(const FAnsiStringView& Text)
+{
+	if (!IsCommand(Text))
+	{
+		return 0;
+	}
+
+	int32 NameEnd = 1;
+	while (NameEnd < Text.Len() && Text[NameEnd] != ' ')
+	{
+		++NameEnd;
+	}
+	if (NameEnd == Text.Len())
+	{
+		return 0;
+	}
+
+	const FAnsiStringView Name = Text.Mid(1, NameEnd - 1);
+	if (Name.Equals("me", ESearchCase::IgnoreCase))
+	{
+		return NameEnd + 1;
+	}
+
+	if (!Name.Equals("w", ESearchCase::IgnoreCase))
+	{
+		return 0;
+	}
+
+	// "/w <user> ", the user name is the first word
+	int32 UserStart = NameEnd;
+	while (UserStart < Text.Len() && Text[UserStart] == ' ')
+	{
+		++UserStart;
+	}
+
+	int32 UserEnd = UserStart;
+	while (UserEnd < Text.Len() && Text[UserEnd] != ' ')
+	{
+		++UserEnd;
+	}
+	return UserEnd > UserStart && UserEnd < Text.Len() ? UserEnd + 1 : 0;
+}
+
+bool TwitchOutbound::SplitChatMessage(const FAnsiStringView& Text, const int32 MaxBytes, FChatChunks& OutChunks)
+{
+	OutChunks.Reset();
+	if (Text.Len() <= MaxBytes)
+	{
+		OutChunks.Add({FAnsiStringView(), Text});
+		return true;
+	}
+
+	// Twitch runs a command on its whole message only, its arguments past the first chunk would go out as chat
+	const int32 CommandLength = FindRepeatedCommand(Text);
+	if ((CommandLength == 0 && IsCommand(Text)) || CommandLength > MaxBytes / 2)
+	{
+		return false;
+	}
+
+	const FAnsiStringView Command = Text.Left(CommandLength);
+	const FAnsiStringView Escape(CommandEscape, UE_ARRAY_COUNT(CommandEscape) - 1);
+	FAnsiStringView Remaining = Text.RightChop(CommandLength);
+	while (Remaining.Len() > 0)
+	{
+		// Behind a repeated command the text is an argument, a chunk on its own would be run
+		const FAnsiStringView Prefix = CommandLength == 0 && IsCommand(Remaining) ? Escape : Command;
+		const int32 ChunkLength = FindSplit(Remaining, MaxBytes - Prefix.Len());
+		OutChunks.Add({Prefix, Remaining.Left(ChunkLength)});
+
+		// The space the message was split at is not sent
+		Remaining.RightChopInline(ChunkLength);
+		while (Remaining.Len() > 0 && Remaining[0] == ' ')
+		{
+			Remaining.RightChopInline(1);
+		}
+	}
+	return true;
+}
+
+void TwitchOutbound::AppendLine(const FString& Line, TArray<uint8>& OutBuffer)
+{
+	const FTCHARToUTF8 Utf8(*Line, Line.Len());
+	OutBuffer.Append(reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length());
+	OutBuffer.Add('\r');
+	OutBuffer.Add('\n');
+}
+
+void TwitchOutbound::AppendChatLine(const FAnsiStringView& Channel, const FChatChunk& Chunk, TArray<uint8>& OutBuffer)
+{
+	static const ANSICHAR Command[] = "PRIVMSG #";
+	static const ANSICHAR Separator[] = " :";
+	static constexpr int32 CommandLength = UE_ARRAY_COUNT(Command) - 1;
+	static constexpr int32 SeparatorLength = UE_ARRAY_COUNT(Separator) - 1;
+
+	OutBuffer.Reserve(OutBuffer.Num() + CommandLength + Channel.Len() + SeparatorLength + Chunk.Prefix.Len() + Chunk.Text.Len() + 2);
+	OutBuffer.Append(reinterpret_cast<const uint8*>(Command), CommandLength);
+	OutBuffer.Append(reinterpret_cast<const uint8*>(Channel.GetData()), Channel.Len());
+	OutBuffer.Append(reinterpret_cast<const uint8*>(Separator), SeparatorLength);
+	OutBuffer.Append(reinterpret_cast<const uint8*>(Chunk.Prefix.GetData()), Chunk.Prefix.Len());
+	OutBuffer.Append(reinterpret_cast<const uint8*>(Chunk.Text.GetData()), Chunk.Text.Len());
+	OutBuffer.Add('\r');
+	OutBuffer.Add('\n');
+}
+
+TArray<uint8> FTwitchSendBufferPool::Acquire()
+{
+	FScopeLock ScopeLock(&Lock);
+	return FreeBuffers.Num() > 0 ? FreeBuffers.Pop(false) : TArray<uint8>();
+}
+
+void FTwitchSendBufferPool::Release(TArray<uint8>&& Buffer)
+{
+	if (Buffer.Max() == 0 || Buffer.Max() > MaxPooledCapacity)
+	{
+		return;
+	}
+
+	Buffer.Reset();
+	FScopeLock ScopeLock(&Lock);
+	if (FreeBuffers.Num() < MaxPooled)
+	{
+		FreeBuffers.Add(MoveTemp(Buffer));
+	}
+}
+
+FTwitchDuplicateFilter::FTwitchDuplicateFilter()
+	: NextPruneTime(0.0)
+{
+}
+
+bool FTwitchDuplicateFilter::IsDuplicate(const TArray<uint8>& Line, const double Now) const
+{
+	const double* LastTime = LastSeen.Find(CityHash64(reinterpret_cast<const char*>(Line.GetData()), Line.Num()));
+	return LastTime != nullptr && Now - *LastTime < TwitchOutbound::DuplicateWindowSeconds;
+}
+
+void FTwitchDuplicateFilter::Record(const TArray<uint8>& Line, const double Now)
+{
+	if (Now >= NextPruneTime)
+	{
+		for (auto It = LastSeen.CreateIterator(); It; ++It)
+		{
+			if (Now - It.Value() >= TwitchOutbound::DuplicateWindowSeconds)
+			{
+				It.RemoveCurrent();
+			}
+		}
+		NextPruneTime = Now + TwitchOutbound::DuplicateWindowSeconds;
+	}
+
+	LastSeen.Add(CityHash64(reinterpret_cast<const char*>(Line.GetData()), Line.Num()), Now);
+}
+
+void FTwitchDuplicateFilter::Reset()
+{
+	LastSeen.Reset();
+	NextPruneTime = 0.0;
+}
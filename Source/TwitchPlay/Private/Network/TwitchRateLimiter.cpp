@@ -0,0 +1,242 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Network/TwitchRateLimiter.h"
+
+#include "Runnables/TwitchMessageReceiver.h"
+
+// Twitch counts joins over 10 seconds
+static constexpr double JoinWindowSeconds = 10.0;
+
+// Keeps a batched JOIN line well within the 512 bytes IRC line limit
+static constexpr int32 MaxJoinListLength = 480;
+
+FTwitchTokenBucket::FTwitchTokenBucket(const int32 InCapacity, const double InWindowSeconds)
+	: Head(0)
+	, Count(0)
+	, WindowSeconds(InWindowSeconds)
+{
+	SpendTimes.SetNumZeroed(FMath::Max(InCapacity, 1));
+}
+
+void FTwitchTokenBucket::SetCapacity(const int32 NewCapacity)
+{
+	const int32 Capacity = FMath::Max(NewCapacity, 1);
+	if (Capacity == SpendTimes.Num())
+	{
+		return;
+	}
+
+	// Keep the most recent sends, they are the ones still holding tokens
+	const int32 Kept = FMath::Min(Count, Capacity);
+	TArray<double> NewSpendTimes;
+	NewSpendTimes.SetNumZeroed(Capacity);
+	for (int32 Index = 0; Index < Kept; ++Index)
+	{
+		NewSpendTimes[Index] = SpendTimes[(Head + Count - Kept + Index) % SpendTimes.Num()];
+	}
+
+	SpendTimes = MoveTemp(NewSpendTimes);
+	Head = 0;
+	Count = Kept;
+}
+
+bool FTwitchTokenBucket::TryConsume(const double Now)
+{
+	Refill(Now);
+	if (Count == SpendTimes.Num())
+	{
+		return false;
+	}
+
+	SpendTimes[(Head + Count) % SpendTimes.Num()] = Now;
+	++Count;
+	return true;
+}
+
+double FTwitchTokenBucket::GetTimeUntilAvailable(const double Now) const
+{
+	if (Count < SpendTimes.Num())
+	{
+		return 0.0;
+	}
+
+	return FMath::Max(SpendTimes[Head] + WindowSeconds - Now, 0.0);
+}
+
+int32 FTwitchTokenBucket::GetAvailable(const double Now) const
+{
+	int32 Expired = 0;
+	while (Expired < Count && SpendTimes[(Head + Expired) % SpendTimes.Num()] + WindowSeconds <= Now)
+	{
+		++Expired;
+	}
+	return SpendTimes.Num() - Count + Expired;
+}
+
+void FTwitchTokenBucket::Refill(const double Now)
+{
+	while (Count > 0 && SpendTimes[Head] + WindowSeconds <= Now)
+	{
+		Head = (Head + 1) % SpendTimes.Num();
+		--Count;
+	}
+}
+
+FTwitchSendScheduler::FTwitchSendScheduler()
+	: LastChannel(INDEX_NONE)
+	, JoinBucket(20, JoinWindowSeconds)
+	, MinTimeBetweenMessages(0)
+	, NextMessageTime(0)
+	, NumPending(0)
+{
+	Configure(FTwitchRateLimits(), 0.0);
+}
+
+void FTwitchSendScheduler::Configure(const FTwitchRateLimits& InLimits, const double InMinTimeBetweenMessages)
+{
+	Limits = InLimits;
+	MinTimeBetweenMessages = FMath::Max(InMinTimeBetweenMessages, 0.0);
+
+	AccountBucket = FTwitchTokenBucket(Limits.GetAccountMessagesPerWindow(), Limits.WindowSeconds);
+	JoinBucket = FTwitchTokenBucket(Limits.GetJoinsPerWindow(), JoinWindowSeconds);
+
+	for (const FString& Channel : Limits.PrivilegedChannels)
+	{
+		SetChannelPrivileged(Channel, true);
+	}
+}
+
+void FTwitchSendScheduler::Push(FTwitchSendMessage&& Message, const FString& Channel)
+{
+	FChannelState& State = FindOrAddChannel(Channel);
+	State.Pending[static_cast<int32>(Message.Priority)].Enqueue(MoveTemp(Message));
+	++NumPending;
+}
+
+void FTwitchSendScheduler::PushJoin(const FString& Channel)
+{
+	if (!PendingJoins.Contains(Channel))
+	{
+		PendingJoins.Add(Channel);
+		++NumPending;
+	}
+}
+
+bool FTwitchSendScheduler::CancelJoin(const FString& Channel)
+{
+	const int32 NumRemoved = PendingJoins.Remove(Channel);
+	NumPending -= NumRemoved;
+	return NumRemoved > 0;
+}
+
+bool FTwitchSendScheduler::Pop(const double Now, FTwitchSendMessage& OutMessage, double& OutWaitSeconds)
+{
+	if (NumPending == 0)
+	{
+		return false;
+	}
+
+	double WaitSeconds = MAX_dbl;
+
+	// Joins have their own limit and don't hold back chat messages. Each channel in a batch counts as one join
+	if (PendingJoins.Num() > 0)
+	{
+		const int32 NumAvailable = FMath::Min(JoinBucket.GetAvailable(Now), PendingJoins.Num());
+		if (NumAvailable > 0)
+		{
+			OutMessage = FTwitchSendMessage {ETwitchSendMessageType::JOIN_MESSAGE, TEXT(""), TEXT("")};
+
+			int32 NumJoined = 0;
+			while (NumJoined < NumAvailable)
+			{
+				const FString& Channel = PendingJoins[NumJoined];
+				if (NumJoined > 0 && OutMessage.Message.Len() + Channel.Len() + 2 > MaxJoinListLength)
+				{
+					break;
+				}
+
+				if (NumJoined > 0)
+				{
+					OutMessage.Message += TEXT(',');
+				}
+				OutMessage.Message += TEXT('#');
+				OutMessage.Message += Channel;
+
+				JoinBucket.TryConsume(Now);
+				++NumJoined;
+			}
+
+			PendingJoins.RemoveAt(0, NumJoined, false);
+			NumPending -= NumJoined;
+			return true;
+		}
+		WaitSeconds = JoinBucket.GetTimeUntilAvailable(Now);
+	}
+
+	const double AccountWait = FMath::Max(AccountBucket.GetTimeUntilAvailable(Now), NextMessageTime - Now);
+	const int32 NumChannels = Channels.Num();
+
+	for (int32 Priority = 0; Priority < NumPriorities; ++Priority)
+	{
+		// Take turns, starting with the channel after the one that sent last
+		for (int32 Turn = 1; Turn <= NumChannels; ++Turn)
+		{
+			const int32 ChannelIndex = (LastChannel + Turn + NumChannels) % NumChannels;
+			FChannelState& State = *Channels[ChannelIndex];
+			if (State.Pending[Priority].IsEmpty())
+			{
+				continue;
+			}
+
+			const double ChannelWait = FMath::Max(State.Bucket.GetTimeUntilAvailable(Now), AccountWait);
+			if (ChannelWait > 0.0)
+			{
+				WaitSeconds = FMath::Min(WaitSeconds, ChannelWait);
+				continue;
+			}
+
+			State.Bucket.TryConsume(Now);
+			AccountBucket.TryConsume(Now);
+			State.Pending[Priority].Dequeue(OutMessage);
+			--NumPending;
+			LastChannel = ChannelIndex;
+			NextMessageTime = Now + MinTimeBetweenMessages;
+			return true;
+		}
+	}
+
+	OutWaitSeconds = WaitSeconds;
+	return false;
+}
+
+void FTwitchSendScheduler::SetChannelPrivileged(const FString& Channel, const bool bPrivileged)
+{
+	FChannelState& State = FindOrAddChannel(Channel);
+	if (State.bPrivileged != bPrivileged)
+	{
+		State.bPrivileged = bPrivileged;
+		State.Bucket.SetCapacity(bPrivileged ? Limits.PrivilegedMessagesPerWindow : Limits.MessagesPerWindow);
+	}
+}
+
+bool FTwitchSendScheduler::IsChannelPrivileged(const FString& Channel) const
+{
+	const int32* Index = ChannelIndices.Find(Channel);
+	return Index != nullptr && Channels[*Index]->bPrivileged;
+}
+
+FTwitchSendScheduler::FChannelState& FTwitchSendScheduler::FindOrAddChannel(const FString& Channel)
+{
+	// Configured names may still carry a # or spaces, the receiver pushes them normalized
+	const FString Key = FTwitchMessageReceiver::NormalizeChannel(Channel);
+	if (const int32* Index = ChannelIndices.Find(Key))
+	{
+		return *Channels[*Index];
+	}
+
+	TUniquePtr<FChannelState> State = MakeUnique<FChannelState>();
+	State->Bucket = FTwitchTokenBucket(Limits.MessagesPerWindow, Limits.WindowSeconds);
+	ChannelIndices.Add(Key, Channels.Num());
+	return *Channels.Add_GetRef(MoveTemp(State));
+}
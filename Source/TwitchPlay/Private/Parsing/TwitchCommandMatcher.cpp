@@ -0,0 +1,119 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Parsing/TwitchCommandMatcher.h"
+
+FTwitchCommandMatcher::FTwitchCommandMatcher()
+	: bCaseSensitive(true)
+{
+	Nodes.Add(FNode {TEXT('\0'), INDEX_NONE, INDEX_NONE, INDEX_NONE});
+}
+
+void FTwitchCommandMatcher::Build(const TArray<FString>& Names, const TArray<int32>& CommandIndices, const FString& InDelimiter, const bool bInCaseSensitive)
+{
+	check(Names.Num() == CommandIndices.Num());
+
+	Delimiter = InDelimiter;
+	bCaseSensitive = bInCaseSensitive;
+
+	Nodes.Reset();
+	Nodes.Add(FNode {TEXT('\0'), INDEX_NONE, INDEX_NONE, INDEX_NONE});
+
+	for (int32 NameIndex = 0; NameIndex < Names.Num(); ++NameIndex)
+	{
+		const FString& Name = Names[NameIndex];
+
+		// A command containing the delimiter could never be found
+		if (Name.IsEmpty() || Delimiter.IsEmpty() || Name.Contains(Delimiter, ESearchCase::CaseSensitive))
+		{
+			continue;
+		}
+
+		int32 Node = 0;
+		for (const TCHAR NameChar : Name)
+		{
+			const TCHAR Char = Fold(NameChar);
+			int32 Child = FindChild(Node, Char);
+			if (Child == INDEX_NONE)
+			{
+				Child = Nodes.Add(FNode {Char, INDEX_NONE, Nodes[Node].FirstChild, INDEX_NONE});
+				Nodes[Node].FirstChild = Child;
+			}
+			Node = Child;
+		}
+
+		// The first name wins, as with case folded duplicates
+		if (Nodes[Node].CommandIndex == INDEX_NONE)
+		{
+			Nodes[Node].CommandIndex = CommandIndices[NameIndex];
+		}
+	}
+
+	Nodes.Shrink();
+}
+
+int32 FTwitchCommandMatcher::Match(const FStringView& Message) const
+{
+	if (IsEmpty())
+	{
+		return INDEX_NONE;
+	}
+
+	// Opening delimiter
+	const int32 Length = Message.Len();
+	int32 Position = 0;
+	while (Position < Length && !IsDelimiterAt(Message, Position))
+	{
+		++Position;
+	}
+	Position += Delimiter.Len();
+
+	int32 Node = 0;
+	while (Position < Length)
+	{
+		if (Nodes[Node].CommandIndex != INDEX_NONE && IsDelimiterAt(Message, Position))
+		{
+			return Nodes[Node].CommandIndex;
+		}
+
+		Node = FindChild(Node, Fold(Message[Position]));
+		if (Node == INDEX_NONE)
+		{
+			return INDEX_NONE;
+		}
+		++Position;
+	}
+
+	// No closing delimiter
+	return INDEX_NONE;
+}
+
+int32 FTwitchCommandMatcher::FindChild(const int32 Node, const TCHAR Char) const
+{
+	for (int32 Child = Nodes[Node].FirstChild; Child != INDEX_NONE; Child = Nodes[Child].NextSibling)
+	{
+		if (Nodes[Child].Char == Char)
+		{
+			return Child;
+		}
+	}
+	return INDEX_NONE;
+}
+
+bool FTwitchCommandMatcher::IsDelimiterAt(const FStringView& Message, const int32 Position) const
+{
+	const int32 DelimiterLength = Delimiter.Len();
+	if (Position + DelimiterLength > Message.Len())
+	{
+		return false;
+	}
+
+	for (int32 Index = 0; Index < DelimiterLength; ++Index)
+	{
+		if (Message[Position + Index] != Delimiter[Index])
+		{
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,424 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Parsing/TwitchIrcMessage.h"
+#include "Parsing/TwitchUtf8.h"
+#include "TwitchSimd.h"
+
+namespace
+{
+	FORCEINLINE int32 FindChar(const FAnsiStringView& View, const int32 Start, const ANSICHAR Char)
+	{
+		const int32 Found = TwitchSimd::FindByte(reinterpret_cast<const uint8*>(View.GetData()) + Start, View.Len() - Start, static_cast<uint8>(Char));
+		return Found == INDEX_NONE ? INDEX_NONE : Start + Found;
+	}
+
+	FORCEINLINE int32 SkipSpaces(const FAnsiStringView& View, int32 Position)
+	{
+		while (Position < View.Len() && View[Position] == ' ')
+		{
+			++Position;
+		}
+		return Position;
+	}
+
+	// Returns the end of the word starting at Position (the next space or the end of the view)
+	FORCEINLINE int32 FindWordEnd(const FAnsiStringView& View, const int32 Position)
+	{
+		const int32 Found = FindChar(View, Position, ' ');
+		return Found == INDEX_NONE ? View.Len() : Found;
+	}
+
+	FORCEINLINE bool KeyEquals(const FAnsiStringView& Key, const ANSICHAR* Name)
+	{
+		// The length was already matched by the caller
+		return FMemory::Memcmp(Key.GetData(), Name, Key.Len()) == 0;
+	}
+
+	FORCEINLINE int32 HexDigit(const ANSICHAR Char)
+	{
+		if (Char >= '0' && Char <= '9')
+		{
+			return Char - '0';
+		}
+		if (Char >= 'a' && Char <= 'f')
+		{
+			return Char - 'a' + 10;
+		}
+		if (Char >= 'A' && Char <= 'F')
+		{
+			return Char - 'A' + 10;
+		}
+		return INDEX_NONE;
+	}
+
+	struct FBadgeName
+	{
+		const ANSICHAR* Name;
+		int32 Len;
+		ETwitchBadge Badge;
+	};
+
+	// Badge names as they appear in the badges tag
+	constexpr FBadgeName BadgeNames[] =
+	{
+		{"broadcaster", 11, ETwitchBadge::BROADCASTER},
+		{"moderator", 9, ETwitchBadge::MODERATOR},
+		{"vip", 3, ETwitchBadge::VIP},
+		{"subscriber", 10, ETwitchBadge::SUBSCRIBER},
+		{"founder", 7, ETwitchBadge::FOUNDER},
+		{"premium", 7, ETwitchBadge::PREMIUM},
+		{"turbo", 5, ETwitchBadge::TURBO},
+		{"partner", 7, ETwitchBadge::PARTNER},
+		{"staff", 5, ETwitchBadge::STAFF},
+		{"admin", 5, ETwitchBadge::ADMIN},
+		{"global_mod", 10, ETwitchBadge::GLOBAL_MOD},
+		{"bits", 4, ETwitchBadge::BITS},
+		{"bits-leader", 11, ETwitchBadge::BITS_LEADER},
+		{"sub-gifter", 10, ETwitchBadge::SUB_GIFTER},
+		{"sub-gift-leader", 15, ETwitchBadge::SUB_GIFT_LEADER},
+		{"artist-badge", 12, ETwitchBadge::ARTIST},
+		{"no_audio", 8, ETwitchBadge::NO_AUDIO},
+		{"no_video", 8, ETwitchBadge::NO_VIDEO},
+	};
+	static_assert(UE_ARRAY_COUNT(BadgeNames) == static_cast<int32>(ETwitchBadge::MAX), "Every badge needs a name");
+	static_assert(static_cast<int32>(ETwitchBadge::MAX) <= 32, "Badges must fit in the 32 bits mask");
+}
+
+bool FTwitchIrcMessage::Parse(const FAnsiStringView& Line, FTwitchIrcMessage& OutMessage)
+{
+	OutMessage = FTwitchIrcMessage();
+
+	int32 Position = 0;
+
+	// Tags: "@key=value;key=value "
+	if (Position < Line.Len() && Line[Position] == '@')
+	{
+		const int32 End = FindWordEnd(Line, Position + 1);
+		OutMessage.Tags = Line.Mid(Position + 1, End - Position - 1);
+		Position = SkipSpaces(Line, End);
+	}
+
+	// Prefix: ":nick!user@host "
+	if (Position < Line.Len() && Line[Position] == ':')
+	{
+		const int32 End = FindWordEnd(Line, Position + 1);
+		OutMessage.Prefix = Line.Mid(Position + 1, End - Position - 1);
+		Position = SkipSpaces(Line, End);
+	}
+
+	// Command
+	const int32 CommandEnd = FindWordEnd(Line, Position);
+	OutMessage.Command = Line.Mid(Position, CommandEnd - Position);
+	if (OutMessage.Command.IsEmpty())
+	{
+		return false;
+	}
+	Position = SkipSpaces(Line, CommandEnd);
+
+	// Middle params up to " :", then the trailing param
+	const int32 ParamsStart = Position;
+	int32 ParamsEnd = Position;
+	while (Position < Line.Len())
+	{
+		if (Line[Position] == ':')
+		{
+			OutMessage.Trailing = Line.Mid(Position + 1);
+			break;
+		}
+
+		ParamsEnd = FindWordEnd(Line, Position);
+		Position = SkipSpaces(Line, ParamsEnd);
+	}
+	OutMessage.Params = Line.Mid(ParamsStart, ParamsEnd - ParamsStart);
+
+	return true;
+}
+
+FAnsiStringView FTwitchIrcMessage::GetNick() const
+{
+	const int32 Found = FindChar(Prefix, 0, '!');
+	return Found == INDEX_NONE ? Prefix : Prefix.Left(Found);
+}
+
+FAnsiStringView FTwitchIrcMessage::GetFirstParam() const
+{
+	return Params.Left(FindWordEnd(Params, 0));
+}
+
+bool FTwitchIrcTagIterator::Next(FAnsiStringView& OutKey, FAnsiStringView& OutValue)
+{
+	while (Position < Tags.Len())
+	{
+		const int32 Start = Position;
+		int32 End = FindChar(Tags, Start, ';');
+		if (End == INDEX_NONE)
+		{
+			End = Tags.Len();
+		}
+		Position = End + 1;
+
+		if (End == Start)
+		{
+			continue;
+		}
+
+		const FAnsiStringView Tag = Tags.Mid(Start, End - Start);
+		const int32 Equals = FindChar(Tag, 0, '=');
+		if (Equals == INDEX_NONE)
+		{
+			OutKey = Tag;
+			OutValue = FAnsiStringView();
+		}
+		else
+		{
+			OutKey = Tag.Left(Equals);
+			OutValue = Tag.Mid(Equals + 1);
+		}
+		return true;
+	}
+
+	return false;
+}
+
+ETwitchIrcTag TwitchIrc::ClassifyTag(const FAnsiStringView& Key)
+{
+	switch (Key.Len())
+	{
+	case 2:
+		return KeyEquals(Key, "id") ? ETwitchIrcTag::Id : ETwitchIrcTag::Unknown;
+	case 3:
+		if (KeyEquals(Key, "mod"))
+		{
+			return ETwitchIrcTag::Mod;
+		}
+		return KeyEquals(Key, "vip") ? ETwitchIrcTag::Vip : ETwitchIrcTag::Unknown;
+	case 4:
+		return KeyEquals(Key, "bits") ? ETwitchIrcTag::Bits : ETwitchIrcTag::Unknown;
+	case 5:
+		switch (Key[0])
+		{
+		case 'c': return KeyEquals(Key, "color") ? ETwitchIrcTag::Color : ETwitchIrcTag::Unknown;
+		case 'f': return KeyEquals(Key, "flags") ? ETwitchIrcTag::Flags : ETwitchIrcTag::Unknown;
+		case 't': return KeyEquals(Key, "turbo") ? ETwitchIrcTag::Turbo : ETwitchIrcTag::Unknown;
+		default: return ETwitchIrcTag::Unknown;
+		}
+	case 6:
+		if (KeyEquals(Key, "badges"))
+		{
+			return ETwitchIrcTag::Badges;
+		}
+		return KeyEquals(Key, "emotes") ? ETwitchIrcTag::Emotes : ETwitchIrcTag::Unknown;
+	case 7:
+		if (KeyEquals(Key, "user-id"))
+		{
+			return ETwitchIrcTag::UserId;
+		}
+		return KeyEquals(Key, "room-id") ? ETwitchIrcTag::RoomId : ETwitchIrcTag::Unknown;
+	case 9:
+		if (KeyEquals(Key, "user-type"))
+		{
+			return ETwitchIrcTag::UserType;
+		}
+		return KeyEquals(Key, "first-msg") ? ETwitchIrcTag::FirstMsg : ETwitchIrcTag::Unknown;
+	case 10:
+		if (KeyEquals(Key, "badge-info"))
+		{
+			return ETwitchIrcTag::BadgeInfo;
+		}
+		return KeyEquals(Key, "subscriber") ? ETwitchIrcTag::Subscriber : ETwitchIrcTag::Unknown;
+	case 11:
+		return KeyEquals(Key, "tmi-sent-ts") ? ETwitchIrcTag::TmiSentTs : ETwitchIrcTag::Unknown;
+	case 12:
+		if (KeyEquals(Key, "display-name"))
+		{
+			return ETwitchIrcTag::DisplayName;
+		}
+		return KeyEquals(Key, "client-nonce") ? ETwitchIrcTag::ClientNonce : ETwitchIrcTag::Unknown;
+	case 17:
+		return KeyEquals(Key, "returning-chatter") ? ETwitchIrcTag::ReturningChatter : ETwitchIrcTag::Unknown;
+	case 19:
+		return KeyEquals(Key, "reply-parent-msg-id") ? ETwitchIrcTag::ReplyParentMsgId : ETwitchIrcTag::Unknown;
+	case 20:
+		return KeyEquals(Key, "reply-parent-user-id") ? ETwitchIrcTag::ReplyParentUserId : ETwitchIrcTag::Unknown;
+	case 21:
+		return KeyEquals(Key, "reply-parent-msg-body") ? ETwitchIrcTag::ReplyParentMsgBody : ETwitchIrcTag::Unknown;
+	case 23:
+		return KeyEquals(Key, "reply-parent-user-login") ? ETwitchIrcTag::ReplyParentUserLogin : ETwitchIrcTag::Unknown;
+	case 25:
+		return KeyEquals(Key, "reply-parent-display-name") ? ETwitchIrcTag::ReplyParentDisplayName : ETwitchIrcTag::Unknown;
+	case 26:
+		return KeyEquals(Key, "reply-thread-parent-msg-id") ? ETwitchIrcTag::ReplyThreadParentMsgId : ETwitchIrcTag::Unknown;
+	case 30:
+		return KeyEquals(Key, "reply-thread-parent-user-login") ? ETwitchIrcTag::ReplyThreadParentUserLogin : ETwitchIrcTag::Unknown;
+	default:
+		return ETwitchIrcTag::Unknown;
+	}
+}
+
+bool TwitchIrc::ParseUInt64(const FAnsiStringView& Value, uint64& OutValue)
+{
+	if (Value.IsEmpty() || Value.Len() > 20)
+	{
+		return false;
+	}
+
+	uint64 Result = 0;
+	for (const ANSICHAR Char : Value)
+	{
+		if (Char < '0' || Char > '9')
+		{
+			return false;
+		}
+		const uint64 Digit = static_cast<uint64>(Char - '0');
+
+		// 20 digits can go past MAX_uint64, those values do not fit
+		if (Result > (MAX_uint64 - Digit) / 10)
+		{
+			return false;
+		}
+		Result = Result * 10 + Digit;
+	}
+
+	OutValue = Result;
+	return true;
+}
+
+bool TwitchIrc::ParseColor(const FAnsiStringView& Value, FColor& OutColor)
+{
+	if (Value.Len() != 7 || Value[0] != '#')
+	{
+		return false;
+	}
+
+	int32 Channels[3];
+	for (int32 Index = 0; Index < 3; ++Index)
+	{
+		const int32 High = HexDigit(Value[1 + Index * 2]);
+		const int32 Low = HexDigit(Value[2 + Index * 2]);
+		if (High == INDEX_NONE || Low == INDEX_NONE)
+		{
+			return false;
+		}
+		Channels[Index] = High * 16 + Low;
+	}
+
+	OutColor = FColor(Channels[0], Channels[1], Channels[2]);
+	return true;
+}
+
+void TwitchIrc::ParseBadges(const FAnsiStringView& Value, FTwitchBadgeSet& OutBadges)
+{
+	int32 Start = 0;
+	while (Start < Value.Len())
+	{
+		int32 End = FindChar(Value, Start, ',');
+		if (End == INDEX_NONE)
+		{
+			End = Value.Len();
+		}
+
+		const FAnsiStringView Badge = Value.Mid(Start, End - Start);
+		Start = End + 1;
+
+		const int32 Slash = FindChar(Badge, 0, '/');
+		const FAnsiStringView Name = Slash == INDEX_NONE ? Badge : Badge.Left(Slash);
+		for (const FBadgeName& BadgeName : BadgeNames)
+		{
+			if (BadgeName.Len == Name.Len() && KeyEquals(Name, BadgeName.Name))
+			{
+				uint64 Version = 0;
+				if (Slash != INDEX_NONE)
+				{
+					ParseUInt64(Badge.Mid(Slash + 1), Version);
+				}
+
+				OutBadges.Mask |= FTwitchBadgeSet::GetBit(BadgeName.Badge);
+				OutBadges.Versions[static_cast<int32>(BadgeName.Badge)] = static_cast<uint32>(FMath::Min<uint64>(Version, MAX_uint32));
+				break;
+			}
+		}
+	}
+}
+
+void TwitchIrc::ParseEmotes(const FAnsiStringView& Value, TArray<FTwitchEmoteRange>& OutRanges)
+{
+	// "id:start-end,start-end/id:start-end"
+	int32 Start = 0;
+	while (Start < Value.Len())
+	{
+		int32 End = FindChar(Value, Start, '/');
+		if (End == INDEX_NONE)
+		{
+			End = Value.Len();
+		}
+
+		const FAnsiStringView Emote = Value.Mid(Start, End - Start);
+		Start = End + 1;
+
+		const int32 Colon = FindChar(Emote, 0, ':');
+		if (Colon <= 0)
+		{
+			continue;
+		}
+		const FAnsiStringView Id = Emote.Left(Colon);
+
+		int32 RangeStart = Colon + 1;
+		while (RangeStart < Emote.Len())
+		{
+			int32 RangeEnd = FindChar(Emote, RangeStart, ',');
+			if (RangeEnd == INDEX_NONE)
+			{
+				RangeEnd = Emote.Len();
+			}
+
+			const FAnsiStringView Range = Emote.Mid(RangeStart, RangeEnd - RangeStart);
+			RangeStart = RangeEnd + 1;
+
+			const int32 Dash = FindChar(Range, 0, '-');
+			uint64 First;
+			uint64 Last;
+			if (Dash != INDEX_NONE && ParseUInt64(Range.Left(Dash), First) && ParseUInt64(Range.Mid(Dash + 1), Last)
+				&& First <= Last && Last < MAX_int32)
+			{
+				OutRanges.Add(FTwitchEmoteRange {Id, static_cast<int32>(First), static_cast<int32>(Last)});
+			}
+		}
+	}
+}
+
+void TwitchIrc::UnescapeTagValue(const FAnsiStringView& Value, FString& OutValue)
+{
+	if (FindChar(Value, 0, '\\') == INDEX_NONE)
+	{
+		TwitchUtf8::Decode(Value, OutValue);
+		return;
+	}
+
+	TArray<ANSICHAR, TInlineAllocator<512>> Unescaped;
+	Unescaped.Reserve(Value.Len());
+	for (int32 Index = 0; Index < Value.Len(); ++Index)
+	{
+		ANSICHAR Char = Value[Index];
+		if (Char == '\\')
+		{
+			// A trailing backslash is dropped
+			if (++Index == Value.Len())
+			{
+				break;
+			}
+
+			switch (Value[Index])
+			{
+			case 's': Char = ' '; break;
+			case ':': Char = ';'; break;
+			case 'r': Char = '\r'; break;
+			case 'n': Char = '\n'; break;
+			default: Char = Value[Index]; break;
+			}
+		}
+		Unescaped.Add(Char);
+	}
+
+	TwitchUtf8::Decode(FAnsiStringView(Unescaped.GetData(), Unescaped.Num()), OutValue);
+}
@@ -0,0 +1,107 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Parsing/TwitchLineFramer.h"
+#include "TwitchSimd.h"
+
+FTwitchLineFramer::FTwitchLineFramer(const int32 InCapacity, const int32 InMaxLineLength)
+	: ReadPos(0)
+	, ScanPos(0)
+	, WritePos(0)
+	, MaxLineLength(InMaxLineLength)
+	, bDiscarding(false)
+	, NumOversizedLines(0)
+{
+	checkf(InCapacity > InMaxLineLength + 1, TEXT("FTwitchLineFramer capacity must be larger than the maximum line length and its CR"));
+	Buffer.SetNumUninitialized(InCapacity);
+}
+
+uint8* FTwitchLineFramer::GetWriteBuffer(int32& OutSize)
+{
+	if (ReadPos == WritePos)
+	{
+		ReadPos = ScanPos = WritePos = 0;
+	}
+	else if (ReadPos > 0)
+	{
+		// Carry the incomplete line over to the front, it is never longer than MaxLineLength
+		const int32 Pending = WritePos - ReadPos;
+		FMemory::Memmove(Buffer.GetData(), Buffer.GetData() + ReadPos, Pending);
+		ScanPos -= ReadPos;
+		WritePos = Pending;
+		ReadPos = 0;
+	}
+
+	OutSize = Buffer.Num() - WritePos;
+	return Buffer.GetData() + WritePos;
+}
+
+void FTwitchLineFramer::CommitWrite(const int32 NumBytes)
+{
+	check(NumBytes >= 0 && WritePos + NumBytes <= Buffer.Num());
+	WritePos += NumBytes;
+}
+
+bool FTwitchLineFramer::PopLine(FAnsiStringView& OutLine)
+{
+	const uint8* Data = Buffer.GetData();
+
+	while (ScanPos < WritePos)
+	{
+		const int32 Found = TwitchSimd::FindByte(Data + ScanPos, WritePos - ScanPos, '\n');
+		if (Found == INDEX_NONE)
+		{
+			ScanPos = WritePos;
+			break;
+		}
+
+		const int32 LineStart = ReadPos;
+		const int32 LineFeed = ScanPos + Found;
+		ReadPos = ScanPos = LineFeed + 1;
+
+		if (bDiscarding)
+		{
+			// End of an oversized line, start over from the next one
+			bDiscarding = false;
+			continue;
+		}
+
+		int32 LineLength = LineFeed - LineStart;
+		if (LineLength > 0 && Data[LineFeed - 1] == '\r')
+		{
+			--LineLength;
+		}
+
+		if (LineLength > MaxLineLength)
+		{
+			++NumOversizedLines;
+			continue;
+		}
+
+		if (LineLength > 0)
+		{
+			OutLine = FAnsiStringView(reinterpret_cast<const ANSICHAR*>(Data + LineStart), LineLength);
+			return true;
+		}
+	}
+
+	// No line feed in the rest of the data. Stop buffering a line that can only end up too long.
+	// The last byte may be the CR of a line that is exactly MaxLineLength long, its LF comes with the next read
+	if (bDiscarding || WritePos - ReadPos > MaxLineLength + 1)
+	{
+		if (!bDiscarding)
+		{
+			++NumOversizedLines;
+			bDiscarding = true;
+		}
+		ReadPos = ScanPos = WritePos;
+	}
+
+	return false;
+}
+
+void FTwitchLineFramer::Reset()
+{
+	ReadPos = ScanPos = WritePos = 0;
+	bDiscarding = false;
+}
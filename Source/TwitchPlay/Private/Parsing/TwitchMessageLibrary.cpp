@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Parsing/TwitchMessageLibrary.h"
+
+#include "Parsing/TwitchUtf8.h"
+
+bool UTwitchMessageLibrary::HasBadge(const FTwitchChatMessage& Message, const ETwitchBadge Badge)
+{
+	return Badge != ETwitchBadge::MAX && Message.HasBadge(Badge);
+}
+
+int32 UTwitchMessageLibrary::GetBadgeVersion(const FTwitchChatMessage& Message, const ETwitchBadge Badge)
+{
+	if (!HasBadge(Message, Badge))
+	{
+		return 0;
+	}
+	return static_cast<int32>(FMath::Min<uint32>(Message.Tags.GetBadges().GetVersion(Badge), MAX_int32));
+}
+
+bool UTwitchMessageLibrary::IsModerator(const FTwitchChatMessage& Message)
+{
+	return Message.HasBadge(ETwitchBadge::MODERATOR);
+}
+
+bool UTwitchMessageLibrary::IsFirstMessage(const FTwitchChatMessage& Message)
+{
+	return Message.Tags.GetBool(ETwitchIrcTag::FirstMsg);
+}
+
+FString UTwitchMessageLibrary::GetMessageId(const FTwitchChatMessage& Message)
+{
+	FString MessageId;
+	Message.Tags.GetString(ETwitchIrcTag::Id, MessageId);
+	return MessageId;
+}
+
+int64 UTwitchMessageLibrary::GetRoomId(const FTwitchChatMessage& Message)
+{
+	uint64 RoomId = 0;
+	Message.Tags.GetUInt64(ETwitchIrcTag::RoomId, RoomId);
+	return static_cast<int64>(RoomId);
+}
+
+bool UTwitchMessageLibrary::GetReplyParent(const FTwitchChatMessage& Message, FString& OutMessageId, FString& OutUserLogin, FString& OutDisplayName, FString& OutMessageBody)
+{
+	if (!Message.Tags.GetString(ETwitchIrcTag::ReplyParentMsgId, OutMessageId))
+	{
+		return false;
+	}
+
+	Message.Tags.GetString(ETwitchIrcTag::ReplyParentUserLogin, OutUserLogin);
+	Message.Tags.GetString(ETwitchIrcTag::ReplyParentDisplayName, OutDisplayName);
+	Message.Tags.GetString(ETwitchIrcTag::ReplyParentMsgBody, OutMessageBody);
+	return true;
+}
+
+TArray<FTwitchEmoteSpan> UTwitchMessageLibrary::GetMessageEmotes(const FTwitchChatMessage& Message)
+{
+	TArray<FTwitchEmoteRange> Ranges;
+	Message.Tags.GetEmotes(Message.Message, Ranges);
+
+	TArray<FTwitchEmoteSpan> Emotes;
+	Emotes.Reserve(Ranges.Num());
+	for (const FTwitchEmoteRange& Range : Ranges)
+	{
+		FTwitchEmoteSpan& Emote = Emotes.AddDefaulted_GetRef();
+		Emote.EmoteId = TwitchUtf8::ToString(Range.Id);
+		Emote.Start = Range.Start;
+		Emote.End = Range.End;
+	}
+	return Emotes;
+}
+
+bool UTwitchMessageLibrary::GetMessageTag(const FTwitchChatMessage& Message, const FString& Key, FString& OutValue)
+{
+	const FTCHARToUTF8 Utf8Key(*Key);
+	FAnsiStringView Value;
+	if (!Message.Tags.FindRawValue(FAnsiStringView(Utf8Key.Get(), Utf8Key.Length()), Value))
+	{
+		return false;
+	}
+
+	TwitchIrc::UnescapeTagValue(Value, OutValue);
+	return true;
+}
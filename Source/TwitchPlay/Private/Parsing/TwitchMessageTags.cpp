@@ -0,0 +1,175 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Parsing/TwitchMessageTags.h"
+
+FTwitchMessageTags::FTwitchMessageTags()
+	: bIndexed(false)
+	, bBadgesDecoded(false)
+{
+}
+
+void FTwitchMessageTags::Reset(const TRefCountPtr<FTwitchTextSlab>& InSlab, const FTwitchTextSpan& InTags)
+{
+	Slab = InSlab;
+	Tags = InTags;
+	bIndexed = false;
+	bBadgesDecoded = false;
+}
+
+FAnsiStringView FTwitchMessageTags::GetRaw() const
+{
+	return Slab.IsValid() ? Slab->View(Tags) : FAnsiStringView();
+}
+
+bool FTwitchMessageTags::GetRawValue(const ETwitchIrcTag Tag, FAnsiStringView& OutValue) const
+{
+	if (!bIndexed)
+	{
+		IndexTags();
+	}
+
+	const FTwitchTextSpan& Value = Values[static_cast<int32>(Tag)];
+	if (Value.Offset == INDEX_NONE)
+	{
+		return false;
+	}
+
+	OutValue = Slab->View(Value);
+	return true;
+}
+
+bool FTwitchMessageTags::FindRawValue(const FAnsiStringView& Key, FAnsiStringView& OutValue) const
+{
+	FTwitchIrcTagIterator Iterator(GetRaw());
+	FAnsiStringView TagKey;
+	FAnsiStringView TagValue;
+	while (Iterator.Next(TagKey, TagValue))
+	{
+		if (TagKey.Len() == Key.Len() && FMemory::Memcmp(TagKey.GetData(), Key.GetData(), Key.Len()) == 0)
+		{
+			OutValue = TagValue;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FTwitchMessageTags::GetString(const ETwitchIrcTag Tag, FString& OutValue) const
+{
+	FAnsiStringView Value;
+	if (!GetRawValue(Tag, Value))
+	{
+		return false;
+	}
+
+	TwitchIrc::UnescapeTagValue(Value, OutValue);
+	return true;
+}
+
+bool FTwitchMessageTags::GetUInt64(const ETwitchIrcTag Tag, uint64& OutValue) const
+{
+	FAnsiStringView Value;
+	return GetRawValue(Tag, Value) && TwitchIrc::ParseUInt64(Value, OutValue);
+}
+
+bool FTwitchMessageTags::GetBool(const ETwitchIrcTag Tag) const
+{
+	FAnsiStringView Value;
+	return GetRawValue(Tag, Value) && Value.Len() == 1 && Value[0] == '1';
+}
+
+const FTwitchBadgeSet& FTwitchMessageTags::GetBadges() const
+{
+	if (!bBadgesDecoded)
+	{
+		Badges = FTwitchBadgeSet();
+
+		FAnsiStringView Value;
+		if (GetRawValue(ETwitchIrcTag::Badges, Value))
+		{
+			TwitchIrc::ParseBadges(Value, Badges);
+		}
+		bBadgesDecoded = true;
+	}
+	return Badges;
+}
+
+void FTwitchMessageTags::GetEmotes(const FString& Text, TArray<FTwitchEmoteRange>& OutRanges) const
+{
+	OutRanges.Reset();
+
+	FAnsiStringView Value;
+	if (!GetRawValue(ETwitchIrcTag::Emotes, Value) || Value.IsEmpty())
+	{
+		return;
+	}
+
+	TwitchIrc::ParseEmotes(Value, OutRanges);
+	OutRanges.Sort([](const FTwitchEmoteRange& A, const FTwitchEmoteRange& B)
+	{
+		return A.Start < B.Start;
+	});
+
+	// Twitch counts code points, a character outside the BMP takes two UTF-16 TCHARs. One pass for all the ranges
+	int32 CodePoint = 0;
+	int32 Index = 0;
+	int32 Valid = 0;
+	for (FTwitchEmoteRange& Range : OutRanges)
+	{
+		int32 Bounds[2] = {Range.Start, Range.End};
+		bool bInText = true;
+		for (int32& Bound : Bounds)
+		{
+			while (CodePoint < Bound && Index < Text.Len())
+			{
+				const TCHAR Char = Text[Index++];
+				if (sizeof(TCHAR) == 2 && Char >= 0xD800 && Char <= 0xDBFF && Index < Text.Len())
+				{
+					++Index;
+				}
+				++CodePoint;
+			}
+			bInText &= CodePoint == Bound && Index < Text.Len();
+			Bound = Index;
+		}
+
+		// The last character of the emote can be a surrogate pair too
+		if (sizeof(TCHAR) == 2 && bInText && Text[Bounds[1]] >= 0xD800 && Text[Bounds[1]] <= 0xDBFF && Bounds[1] + 1 < Text.Len())
+		{
+			++Bounds[1];
+		}
+
+		// Overlapping ranges would mean a broken tag, they are dropped like the ones past the end of the text
+		if (bInText && (Valid == 0 || OutRanges[Valid - 1].End < Bounds[0]))
+		{
+			OutRanges[Valid++] = FTwitchEmoteRange {Range.Id, Bounds[0], Bounds[1]};
+		}
+	}
+	OutRanges.SetNum(Valid, false);
+}
+
+void FTwitchMessageTags::IndexTags() const
+{
+	for (FTwitchTextSpan& Value : Values)
+	{
+		Value = FTwitchTextSpan {INDEX_NONE, 0};
+	}
+
+	// Values are stored as offsets in the slab, they stay valid in copies
+	const FAnsiStringView Raw = GetRaw();
+	FTwitchIrcTagIterator Iterator(Raw);
+	FAnsiStringView Key;
+	FAnsiStringView Value;
+	while (Iterator.Next(Key, Value))
+	{
+		const ETwitchIrcTag Tag = TwitchIrc::ClassifyTag(Key);
+		if (Tag != ETwitchIrcTag::Unknown)
+		{
+			const int32 Offset = Value.IsEmpty() ? 0 : static_cast<int32>(Value.GetData() - Raw.GetData());
+			Values[static_cast<int32>(Tag)] = FTwitchTextSpan {Tags.Offset + Offset, Value.Len()};
+		}
+	}
+
+	bIndexed = true;
+}
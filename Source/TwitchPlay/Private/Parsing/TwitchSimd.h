@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+#include <arm_neon.h>
+#elif PLATFORM_ENABLE_VECTORINTRINSICS
+#include <emmintrin.h>
+#endif
+
+/**
+ * Small vectorized byte scanning helpers shared by the parsing code.
+ * They work on 16 bytes at a time and fall back to a plain loop for the tail (and on platforms without intrinsics).
+ */
+namespace TwitchSimd
+{
+	/**
+	* Finds the first occurrence of a byte.
+	*
+	* @param Data - Bytes to scan
+	* @param Num - Number of bytes to scan
+	* @param Value - The byte to look for
+	*
+	* @return The index of the first occurrence, INDEX_NONE if not found.
+	*/
+	FORCEINLINE int32 FindByte(const uint8* Data, const int32 Num, const uint8 Value)
+	{
+		int32 Index = 0;
+
+#if PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+		const uint8x16_t Needle = vdupq_n_u8(Value);
+		for (; Index + 16 <= Num; Index += 16)
+		{
+			const uint8x16_t Matches = vceqq_u8(vld1q_u8(Data + Index), Needle);
+
+			// Narrow every byte of the mask to 4 bits, so the whole block fits in a 64 bit integer we can count
+			const uint64 Mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(Matches), 4)), 0);
+			if (Mask != 0)
+			{
+				return Index + static_cast<int32>(FMath::CountTrailingZeros64(Mask) >> 2);
+			}
+		}
+#elif PLATFORM_ENABLE_VECTORINTRINSICS
+		const __m128i Needle = _mm_set1_epi8(static_cast<char>(Value));
+		for (; Index + 16 <= Num; Index += 16)
+		{
+			const __m128i Block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Data + Index));
+			const uint32 Mask = static_cast<uint32>(_mm_movemask_epi8(_mm_cmpeq_epi8(Block, Needle)));
+			if (Mask != 0)
+			{
+				return Index + static_cast<int32>(FMath::CountTrailingZeros(Mask));
+			}
+		}
+#endif
+
+		for (; Index < Num; ++Index)
+		{
+			if (Data[Index] == Value)
+			{
+				return Index;
+			}
+		}
+
+		return INDEX_NONE;
+	}
+}
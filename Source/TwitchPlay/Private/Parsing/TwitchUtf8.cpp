@@ -0,0 +1,220 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Parsing/TwitchUtf8.h"
+#include "TwitchSimd.h"
+
+namespace
+{
+	constexpr uint32 ReplacementCharacter = 0xFFFD;
+
+	FORCEINLINE bool IsContinuation(const uint8 Byte)
+	{
+		return (Byte & 0xC0) == 0x80;
+	}
+
+	// Widens 16 ASCII bytes to TCHARs
+	FORCEINLINE void WidenBlock(const uint8* In, TCHAR* Out)
+	{
+#if PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+		const uint8x16_t Block = vld1q_u8(In);
+		const uint16x8_t Low = vmovl_u8(vget_low_u8(Block));
+		const uint16x8_t High = vmovl_u8(vget_high_u8(Block));
+		if constexpr (sizeof(TCHAR) == 2)
+		{
+			vst1q_u16(reinterpret_cast<uint16*>(Out), Low);
+			vst1q_u16(reinterpret_cast<uint16*>(Out) + 8, High);
+		}
+		else
+		{
+			vst1q_u32(reinterpret_cast<uint32*>(Out), vmovl_u16(vget_low_u16(Low)));
+			vst1q_u32(reinterpret_cast<uint32*>(Out) + 4, vmovl_u16(vget_high_u16(Low)));
+			vst1q_u32(reinterpret_cast<uint32*>(Out) + 8, vmovl_u16(vget_low_u16(High)));
+			vst1q_u32(reinterpret_cast<uint32*>(Out) + 12, vmovl_u16(vget_high_u16(High)));
+		}
+#elif PLATFORM_ENABLE_VECTORINTRINSICS
+		const __m128i Zero = _mm_setzero_si128();
+		const __m128i Block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(In));
+		const __m128i Low = _mm_unpacklo_epi8(Block, Zero);
+		const __m128i High = _mm_unpackhi_epi8(Block, Zero);
+		if constexpr (sizeof(TCHAR) == 2)
+		{
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(Out), Low);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(Out) + 1, High);
+		}
+		else
+		{
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(Out), _mm_unpacklo_epi16(Low, Zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(Out) + 1, _mm_unpackhi_epi16(Low, Zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(Out) + 2, _mm_unpacklo_epi16(High, Zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(Out) + 3, _mm_unpackhi_epi16(High, Zero));
+		}
+#else
+		for (int32 Index = 0; Index < 16; ++Index)
+		{
+			Out[Index] = static_cast<TCHAR>(In[Index]);
+		}
+#endif
+	}
+
+	// Returns a bit per byte of the 16 byte block that is not ASCII
+	FORCEINLINE uint32 NonAsciiMask(const uint8* In)
+	{
+#if PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+		const uint8x16_t HighBits = vcltq_s8(vreinterpretq_s8_u8(vld1q_u8(In)), vdupq_n_s8(0));
+		if (vmaxvq_u8(HighBits) == 0)
+		{
+			return 0;
+		}
+		uint32 Mask = 0;
+		for (int32 Index = 0; Index < 16; ++Index)
+		{
+			Mask |= static_cast<uint32>(In[Index] >> 7) << Index;
+		}
+		return Mask;
+#elif PLATFORM_ENABLE_VECTORINTRINSICS
+		return static_cast<uint32>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(In))));
+#else
+		uint32 Mask = 0;
+		for (int32 Index = 0; Index < 16; ++Index)
+		{
+			Mask |= static_cast<uint32>(In[Index] >> 7) << Index;
+		}
+		return Mask;
+#endif
+	}
+
+	/**
+	* Decodes one multi-byte sequence, rejecting overlong forms, surrogates and code points above U+10FFFF.
+	*
+	* @param In - Start of the sequence
+	* @param Available - Bytes left in the input
+	* @param OutCodePoint - The decoded code point, or U+FFFD
+	* @return The number of bytes consumed
+	*/
+	FORCEINLINE int32 DecodeSequence(const uint8* In, const int32 Available, uint32& OutCodePoint)
+	{
+		const uint8 Lead = In[0];
+		OutCodePoint = ReplacementCharacter;
+
+		if (Lead >= 0xC2 && Lead <= 0xDF)
+		{
+			if (Available >= 2 && IsContinuation(In[1]))
+			{
+				OutCodePoint = ((Lead & 0x1F) << 6) | (In[1] & 0x3F);
+				return 2;
+			}
+		}
+		else if (Lead >= 0xE0 && Lead <= 0xEF)
+		{
+			if (Available >= 3 && IsContinuation(In[1]) && IsContinuation(In[2]))
+			{
+				const uint32 CodePoint = ((Lead & 0x0F) << 12) | ((In[1] & 0x3F) << 6) | (In[2] & 0x3F);
+				if (CodePoint >= 0x800 && (CodePoint < 0xD800 || CodePoint > 0xDFFF))
+				{
+					OutCodePoint = CodePoint;
+					return 3;
+				}
+			}
+		}
+		else if (Lead >= 0xF0 && Lead <= 0xF4)
+		{
+			if (Available >= 4 && IsContinuation(In[1]) && IsContinuation(In[2]) && IsContinuation(In[3]))
+			{
+				const uint32 CodePoint = ((Lead & 0x07) << 18) | ((In[1] & 0x3F) << 12) | ((In[2] & 0x3F) << 6) | (In[3] & 0x3F);
+				if (CodePoint >= 0x10000 && CodePoint <= 0x10FFFF)
+				{
+					OutCodePoint = CodePoint;
+					return 4;
+				}
+			}
+		}
+
+		// Invalid lead byte or truncated sequence: replace this byte and resync on the next one
+		return 1;
+	}
+
+	FORCEINLINE int32 WriteCodePoint(const uint32 CodePoint, TCHAR* Out)
+	{
+		if constexpr (sizeof(TCHAR) == 2)
+		{
+			if (CodePoint > 0xFFFF)
+			{
+				Out[0] = static_cast<TCHAR>(0xD800 + ((CodePoint - 0x10000) >> 10));
+				Out[1] = static_cast<TCHAR>(0xDC00 + ((CodePoint - 0x10000) & 0x3FF));
+				return 2;
+			}
+		}
+
+		Out[0] = static_cast<TCHAR>(CodePoint);
+		return 1;
+	}
+}
+
+void TwitchUtf8::Decode(const FAnsiStringView& Utf8, FString& OutString)
+{
+	const int32 Num = Utf8.Len();
+	if (Num == 0)
+	{
+		OutString.Reset();
+		return;
+	}
+
+	// Every byte produces at most one TCHAR (4 byte sequences produce a surrogate pair), plus the terminator
+	TArray<TCHAR>& Chars = OutString.GetCharArray();
+	Chars.SetNumUninitialized(Num + 1, false);
+
+	const uint8* In = reinterpret_cast<const uint8*>(Utf8.GetData());
+	TCHAR* Out = Chars.GetData();
+	int32 InPos = 0;
+	int32 OutPos = 0;
+
+	while (InPos < Num)
+	{
+		// ASCII fast path, 32 then 16 bytes at a time. OutPos never passes InPos, so whole blocks always fit.
+		while (InPos + 32 <= Num && (NonAsciiMask(In + InPos) | NonAsciiMask(In + InPos + 16)) == 0)
+		{
+			WidenBlock(In + InPos, Out + OutPos);
+			WidenBlock(In + InPos + 16, Out + OutPos + 16);
+			InPos += 32;
+			OutPos += 32;
+		}
+
+		if (InPos + 16 <= Num)
+		{
+			const uint32 Mask = NonAsciiMask(In + InPos);
+
+			// Widen the whole block but only keep its ASCII prefix
+			WidenBlock(In + InPos, Out + OutPos);
+			const int32 AsciiLength = Mask == 0 ? 16 : static_cast<int32>(FMath::CountTrailingZeros(Mask));
+			InPos += AsciiLength;
+			OutPos += AsciiLength;
+			if (AsciiLength == 16)
+			{
+				continue;
+			}
+		}
+		else
+		{
+			while (InPos < Num && In[InPos] < 0x80)
+			{
+				Out[OutPos++] = static_cast<TCHAR>(In[InPos++]);
+			}
+			if (InPos == Num)
+			{
+				break;
+			}
+		}
+
+		// Decode the multi-byte characters up to the next ASCII byte
+		while (InPos < Num && In[InPos] >= 0x80)
+		{
+			uint32 CodePoint;
+			InPos += DecodeSequence(In + InPos, Num - InPos, CodePoint);
+			OutPos += WriteCodePoint(CodePoint, Out + OutPos);
+		}
+	}
+
+	Out[OutPos] = TEXT('\0');
+	Chars.SetNum(OutPos + 1, false);
+}
@@ -0,0 +1,218 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Polls/TwitchPoll.h"
+
+// Room for this many voters before the table first grows
+static constexpr int32 InitialVoterSlots = 1024;
+
+// Options are stored in a uint8 per voter
+static constexpr int32 MaxPollOptions = 255;
+
+static FORCEINLINE ANSICHAR ToLowerAscii(const ANSICHAR Char)
+{
+	return (Char >= 'A' && Char <= 'Z') ? Char + ('a' - 'A') : Char;
+}
+
+// Spreads the user ids over the table. They are mostly sequential numbers
+static FORCEINLINE uint64 HashUserId(uint64 UserId)
+{
+	UserId ^= UserId >> 33;
+	UserId *= 0xff51afd7ed558ccdull;
+	UserId ^= UserId >> 33;
+	return UserId;
+}
+
+FTwitchPoll::FTwitchPoll(const TArray<FString>& InOptions, const float DurationSeconds, const bool bInAllowVoteChange)
+	: NumVoters(0)
+	, EndTime(DurationSeconds > 0.0f ? FPlatformTime::Seconds() + DurationSeconds : MAX_dbl)
+	, bAllowVoteChange(bInAllowVoteChange)
+	, bClosed(false)
+	, bChanged(true)
+{
+	for (const FString& Option : InOptions)
+	{
+		if (Options.Num() == MaxPollOptions)
+		{
+			break;
+		}
+
+		const FString Key = Option.TrimStartAndEnd();
+		if (Key.IsEmpty())
+		{
+			continue;
+		}
+
+		Options.Add(Key);
+
+		const FTCHARToUTF8 Utf8Key(*Key);
+		TArray<ANSICHAR>& OptionKey = OptionKeys.AddDefaulted_GetRef();
+		OptionKey.SetNumUninitialized(Utf8Key.Length());
+		for (int32 Index = 0; Index < Utf8Key.Length(); ++Index)
+		{
+			OptionKey[Index] = ToLowerAscii(Utf8Key.Get()[Index]);
+		}
+	}
+
+	Counts.SetNumZeroed(Options.Num());
+	VoterIds.SetNumZeroed(InitialVoterSlots);
+	VoterOptions.SetNumZeroed(InitialVoterSlots);
+}
+
+bool FTwitchPoll::Vote(const uint64 UserId, const FAnsiStringView& Message, const double Now)
+{
+	if (UserId == 0)
+	{
+		return false;
+	}
+
+	// Matching the option needs no lock, the options never change
+	const int32 Option = FindOption(Message);
+	if (Option == INDEX_NONE)
+	{
+		return false;
+	}
+
+	FScopeLock ScopeLock(&Lock);
+	if (bClosed || Now >= EndTime)
+	{
+		return false;
+	}
+
+	const int32 Slot = FindVoterSlot(UserId);
+	if (VoterIds[Slot] == 0)
+	{
+		VoterIds[Slot] = UserId;
+		VoterOptions[Slot] = static_cast<uint8>(Option);
+		++Counts[Option];
+		++NumVoters;
+
+		// Keep the table at most half full, probes stay short
+		if (NumVoters * 2 > VoterIds.Num())
+		{
+			GrowVoters();
+		}
+	}
+	else if (bAllowVoteChange && VoterOptions[Slot] != Option)
+	{
+		--Counts[VoterOptions[Slot]];
+		VoterOptions[Slot] = static_cast<uint8>(Option);
+		++Counts[Option];
+	}
+	else
+	{
+		return false;
+	}
+
+	bChanged = true;
+	return true;
+}
+
+void FTwitchPoll::Close()
+{
+	FScopeLock ScopeLock(&Lock);
+	if (!bClosed)
+	{
+		bClosed = true;
+		bChanged = true;
+	}
+}
+
+bool FTwitchPoll::IsOpen(const double Now) const
+{
+	FScopeLock ScopeLock(&Lock);
+	return !bClosed && Now < EndTime;
+}
+
+bool FTwitchPoll::ConsumeResults(const double Now, FTwitchPollResults& OutResults)
+{
+	{
+		FScopeLock ScopeLock(&Lock);
+		if (!bChanged)
+		{
+			return false;
+		}
+		bChanged = false;
+	}
+
+	GetResults(Now, OutResults);
+	return true;
+}
+
+void FTwitchPoll::GetResults(const double Now, FTwitchPollResults& OutResults) const
+{
+	FScopeLock ScopeLock(&Lock);
+	OutResults.Options = Options;
+	OutResults.Votes = Counts;
+	OutResults.TotalVotes = NumVoters;
+	OutResults.bIsOpen = !bClosed && Now < EndTime;
+	OutResults.TimeRemaining = (OutResults.bIsOpen && EndTime != MAX_dbl) ? static_cast<float>(EndTime - Now) : 0.0f;
+}
+
+int32 FTwitchPoll::FindOption(const FAnsiStringView& Message) const
+{
+	// First word of the message
+	int32 Start = 0;
+	while (Start < Message.Len() && Message[Start] == ' ')
+	{
+		++Start;
+	}
+	int32 End = Start;
+	while (End < Message.Len() && Message[End] != ' ')
+	{
+		++End;
+	}
+
+	const int32 Length = End - Start;
+	for (int32 Option = 0; Option < OptionKeys.Num(); ++Option)
+	{
+		const TArray<ANSICHAR>& OptionKey = OptionKeys[Option];
+		if (OptionKey.Num() != Length)
+		{
+			continue;
+		}
+
+		int32 Index = 0;
+		while (Index < Length && ToLowerAscii(Message[Start + Index]) == OptionKey[Index])
+		{
+			++Index;
+		}
+
+		if (Index == Length)
+		{
+			return Option;
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+int32 FTwitchPoll::FindVoterSlot(const uint64 UserId) const
+{
+	const int32 Mask = VoterIds.Num() - 1;
+	int32 Slot = static_cast<int32>(HashUserId(UserId) & Mask);
+	while (VoterIds[Slot] != 0 && VoterIds[Slot] != UserId)
+	{
+		Slot = (Slot + 1) & Mask;
+	}
+	return Slot;
+}
+
+void FTwitchPoll::GrowVoters()
+{
+	TArray<uint64> OldIds = MoveTemp(VoterIds);
+	TArray<uint8> OldOptions = MoveTemp(VoterOptions);
+
+	VoterIds.SetNumZeroed(OldIds.Num() * 2);
+	VoterOptions.SetNumZeroed(OldIds.Num() * 2);
+
+	for (int32 OldSlot = 0; OldSlot < OldIds.Num(); ++OldSlot)
+	{
+		if (OldIds[OldSlot] != 0)
+		{
+			const int32 Slot = FindVoterSlot(OldIds[OldSlot]);
+			VoterIds[Slot] = OldIds[OldSlot];
+			VoterOptions[Slot] = OldOptions[OldSlot];
+		}
+	}
+}
@@ -2,42 +2,72 @@
 
 
 #include "Runnables/TwitchMessageReceiver.h"
+#include "Chatters/TwitchChatterRegistry.h"
+#include "Network/TwitchConnector.h"
+#include "Parsing/TwitchIrcMessage.h"
+#include "Parsing/TwitchUtf8.h"
+#include "HAL/Event.h"
+#include "HAL/RunnableThread.h"
+#include "Hash/CityHash.h"
 #include "Sockets.h"
 #include "SocketSubsystem.h"
+#include "TwitchStats.h"
 
-inline FString ANSIBytesToString(const uint8* In, int32 Count)
-{
-	FString Result;
-	Result.Empty(Count);
+// Time the server has to reply to our PASS and NICK messages
+static constexpr double AuthTimeoutSeconds = 2.5;
 
-	while (Count)
-	{
-		Result += static_cast<ANSICHAR>(*In);
+// Time without anything received before we PING the server to check the connection
+static const FTimespan IdleWaitTime = FTimespan::FromSeconds(60.0);
 
-		++In;
-		Count--;
-	}
-	return Result;
-}
+// Time the server has to answer our PING before the connection is considered lost
+static const FTimespan PingTimeout = FTimespan::FromSeconds(10.0);
+
+// Time a backed up socket has to take the PART lines when we leave
+static const FTimespan PartFlushTimeout = FTimespan::FromSeconds(1.0);
 
 FTwitchMessageReceiver::FTwitchMessageReceiver()
 	: SendingQueue(MakeUnique<FTwitchSendMessagesQueue>())
-	, ReceivingQueue(MakeUnique<FTwitchReceiveMessagesQueue>())
-	, ConnectionQueue(MakeUnique<FTwitchConnectionQueue>())
+	, SlabPool(MakeShared<FTwitchTextSlabPool, ESPMode::ThreadSafe>())
+	, ControlQueue(MakeUnique<FTwitchSendMessagesQueue>())
+	, ConnectionQueue(MakeUnique<FTwitchConnectionQueue>(MaxQueuedConnectionMessages, ETwitchQueueOverflowPolicy::DROP_OLDEST))
 	, ConnectionSocket(nullptr)
 	, MessagesThread(nullptr)
+	, SendWorker(*this)
+	, SenderThread(nullptr)
+	, SendEvent(FPlatformProcess::GetSynchEventFromPool(false))
+	, WakeEvent(FPlatformProcess::GetSynchEventFromPool(false))
 	, bShouldExit(false)
-	, bWaitingForAuth(false)
-	, NumAuthWaits(0)
-	, AccumulationTime(0)
-	, TimeBetweenMessages(1.2f)
-	, NextSendMessageTime(0)
+	, LastRecoverySeconds(0.0)
+	, bPingPending(false)
+	, bReconnectRequested(false)
+	, TimeBetweenMessages(0.0f)
+	, SendBufferPool(MakeUnique<FTwitchSendBufferPool>())
+	, PendingSendOffset(0)
+	, ReconnectRandom(static_cast<int32>(FPlatformTime::Cycles()))
+	, ReplaySpeed(1.0f)
+	, NumBytesReceived(0)
+	, NumLinesReceived(0)
+	, ParseSeconds(0.0)
+	, NumMessagesSent(0)
+	, NumDuplicatesDropped(0)
+	, SendWaitSeconds(0.0)
+	, NumSendPending(0)
+	, NumOutboundTokens(0)
+	, NumPendingSendBytes(0)
+	, NumMessagesRejected(0)
 {
 	
 }
 
 FTwitchMessageReceiver::~FTwitchMessageReceiver()
 {
+	if (MessagesThread != nullptr)
+	{
+		MessagesThread->Kill(true);
+		delete MessagesThread;
+		MessagesThread = nullptr;
+	}
+
 	if (ConnectionSocket != nullptr)
 	{
 		ConnectionSocket->Close();
@@ -45,303 +75,859 @@ FTwitchMessageReceiver::~FTwitchMessageReceiver()
 		ConnectionSocket = nullptr;
 	}
 
+	FPlatformProcess::ReturnSynchEventToPool(SendEvent);
+	SendEvent = nullptr;
+	FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+	WakeEvent = nullptr;
+
+	StopCapture();
+
 	SendingQueue = nullptr;
 	ReceivingQueue = nullptr;
+	ControlQueue = nullptr;
 	ConnectionQueue = nullptr;
-	MessagesThread = nullptr;
 }
 
-void FTwitchMessageReceiver::StartConnection(const FString& oauth, const FString& username, const FString& channel, const float timeBetweenMessages)
+void FTwitchMessageReceiver::StartConnection(const FString& oauth, const FString& username, const FString& channel, const float timeBetweenMessages, const FTwitchReceiverSettings& settings)
 {
 	checkf(!MessagesThread, TEXT("FTwitchMessageReceiver::StartConnection called more than once?"));
+	Settings = settings;
+	ReceivingQueue = MakeUnique<FTwitchReceiveMessagesQueue>(FMath::Max(Settings.MaxQueuedMessages, 1), Settings.OverflowPolicy);
 	OAuth = oauth;
 	Username = username.ToLower();
-	Channel = channel.ToLower();
 	TimeBetweenMessages = timeBetweenMessages;
+	SendScheduler.Configure(Settings.RateLimits, TimeBetweenMessages);
+
+	// Joined once the sending thread starts, after the authentication
+	if(!channel.IsEmpty())
+	{
+		JoinChannels({channel});
+	}
+
+	MessagesThread = FRunnableThread::Create(this, TEXT("FTwitchMessageReceiver"));
+}
+
+void FTwitchMessageReceiver::StartReplay(const FString& filename, const float speed, const FTwitchReceiverSettings& settings)
+{
+	checkf(!MessagesThread, TEXT("FTwitchMessageReceiver::StartReplay called more than once?"));
+	Settings = settings;
+	ReceivingQueue = MakeUnique<FTwitchReceiveMessagesQueue>(FMath::Max(Settings.MaxQueuedMessages, 1), Settings.OverflowPolicy);
+	ReplayFilename = filename;
+	ReplaySpeed = speed;
+
 	MessagesThread = FRunnableThread::Create(this, TEXT("FTwitchMessageReceiver"));
 }
 
+void FTwitchMessageReceiver::StartOffline(const FTwitchReceiverSettings& settings)
+{
+	checkf(!MessagesThread, TEXT("FTwitchMessageReceiver::StartOffline called on a started receiver?"));
+	Settings = settings;
+	ReceivingQueue = MakeUnique<FTwitchReceiveMessagesQueue>(FMath::Max(Settings.MaxQueuedMessages, 1), Settings.OverflowPolicy);
+}
+
+bool FTwitchMessageReceiver::StartCapture(const FString& filename)
+{
+	TUniquePtr<FTwitchCaptureWriter> Writer = MakeUnique<FTwitchCaptureWriter>();
+	if(!Writer->Open(filename))
+	{
+		return false;
+	}
+
+	FScopeLock Lock(&CaptureLock);
+	CaptureWriter = MoveTemp(Writer);
+	return true;
+}
+
+void FTwitchMessageReceiver::StopCapture()
+{
+	TUniquePtr<FTwitchCaptureWriter> Writer;
+	{
+		FScopeLock Lock(&CaptureLock);
+		Writer = MoveTemp(CaptureWriter);
+	}
+
+	// Closed outside the lock, the receiving thread does not wait for the last flush
+	if(Writer.IsValid())
+	{
+		Writer->Close();
+	}
+}
+
+bool FTwitchMessageReceiver::IsCapturing() const
+{
+	FScopeLock Lock(&CaptureLock);
+	return CaptureWriter.IsValid();
+}
+
 uint32 FTwitchMessageReceiver::Run()
 {
-	if(!ConnectionSocket)
+	if(!ReplayFilename.IsEmpty())
 	{
-		// Create the server connection
-		ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
-		TSharedRef<FInternetAddr> ConnectionAddr = SocketSubsystem->CreateInternetAddr();
+		return RunReplay();
+	}
 
-		FAddressInfoResult GAIResult = SocketSubsystem->GetAddressInfo(TEXT("irc.chat.twitch.tv"),nullptr,EAddressInfoFlags::Default,NAME_None);
-		if (GAIResult.Results.Num() == 0)
+	// Set once the first session is up. Before that any failure is final, after that a lost connection is retried
+	bool bHasConnected = false;
+	int32 NumFailedAttempts = 0;
+	double LostTime = 0.0;
+	uint32 ExitCode = 0;
+
+	while(!bShouldExit)
+	{
+		FString Reason;
+		ETwitchConnectionMessageType FailureType = ETwitchConnectionMessageType::FAILED_TO_CONNECT;
+		if(Connect(Reason))
 		{
-			const FTwitchConnection Connection(ETwitchConnectionMessageType::FAILED_TO_CONNECT, TEXT("Could not resolve hostname!"));
-			ConnectionQueue->Enqueue(Connection);
-			ReceiveConnections(Connection);
-			return 1; // if the host could not be resolved return false
-		}
+			FailureType = ETwitchConnectionMessageType::FAILED_TO_AUTHENTICATE;
+			const ETwitchAuthResult AuthResult = Authenticate(Reason);
+			if(AuthResult == ETwitchAuthResult::AUTHENTICATED)
+			{
+				if(bHasConnected)
+				{
+					const double RecoverySeconds = FPlatformTime::Seconds() - LostTime;
+					LastRecoverySeconds = RecoverySeconds;
+
+					const FTwitchConnection Connection(ETwitchConnectionMessageType::RECONNECTED, FString::Printf(TEXT("Reconnected in %.2f seconds, after %d failed attempts"), RecoverySeconds, NumFailedAttempts));
+					ConnectionQueue->Enqueue(Connection);
+				}
+				else
+				{
+					const FTwitchConnection Connection(ETwitchConnectionMessageType::CONNECTED, Reason);
+					ConnectionQueue->Enqueue(Connection);
+				}
+
+				const ETwitchSessionEnd SessionEnd = RunSession(bHasConnected);
+				bHasConnected = true;
+				NumFailedAttempts = 0;
+
+				if(SessionEnd == ETwitchSessionEnd::STOPPED)
+				{
+					break;
+				}
+
+				LostTime = FPlatformTime::Seconds();
+				DestroySocket();
+
+				if(SessionEnd == ETwitchSessionEnd::RECONNECT_REQUESTED && Settings.bAutoReconnect)
+				{
+					// The server is going down for maintenance, a new connection right away lands on another one
+					const FTwitchConnection Connection(ETwitchConnectionMessageType::RECONNECTING, TEXT("Server asked to reconnect"));
+					ConnectionQueue->Enqueue(Connection);
+					continue;
+				}
 
-		ConnectionAddr->SetRawIp(GAIResult.Results[0].Address->GetRawIp());
+				FailureType = ETwitchConnectionMessageType::DISCONNECTED;
+				Reason = TEXT("Lost connection to server");
+			}
+			else
+			{
+				DestroySocket();
 
-		// Set connection port
-		// HTTPS 6697
-		// HTTP 6667
-		const int32 Port = 6667;
-		ConnectionAddr->SetPort(Port);
+				// Retrying won't fix a rejected token
+				if(AuthResult == ETwitchAuthResult::REJECTED)
+				{
+					bHasConnected = false;
+				}
+			}
+		}
 
-		FSocket* retSocket = SocketSubsystem->CreateSocket(NAME_Stream, TEXT("TwitchPlay Socket"), false);
+		if(bShouldExit)
+		{
+			break;
+		}
 
-		// Socket creation might fail on certain subsystems
-		if (retSocket == nullptr)
+		const bool bOutOfAttempts = Settings.MaxReconnectAttempts > 0 && NumFailedAttempts >= Settings.MaxReconnectAttempts;
+		if(!bHasConnected || !Settings.bAutoReconnect || bOutOfAttempts)
 		{
-			const FTwitchConnection Connection(ETwitchConnectionMessageType::FAILED_TO_CONNECT, TEXT("Could not create socket!"));
+			const FTwitchConnection Connection(FailureType, Reason);
 			ConnectionQueue->Enqueue(Connection);
-			ReceiveConnections(Connection);
-			return 1;
+			ExitCode = 1;
+			break;
 		}
 
-		// Setting underlying connection parameters
-		int32 SizeOut;
-		retSocket->SetReceiveBufferSize(2 * 1024 * 1024, SizeOut);
-		retSocket->SetReuseAddr(true);
+		const double Delay = GetReconnectDelay(NumFailedAttempts++);
+		const FTwitchConnection Connection(ETwitchConnectionMessageType::RECONNECTING, FString::Printf(TEXT("%s. Reconnecting in %.1f seconds (attempt %d)"), *Reason, Delay, NumFailedAttempts));
+		ConnectionQueue->Enqueue(Connection);
 
-		// Try connection
-		const bool bHasConnected = retSocket->Connect(*ConnectionAddr);
+		// A stop request wakes us up
+		WakeEvent->Wait(FTimespan::FromSeconds(Delay));
+	}
 
-		// If we cannot connect destroy the socket and return
-		if (!bHasConnected)
+	bShouldExit = true;
+	bIsConnected = false;
+	if(SenderThread)
+	{
+		SendEvent->Trigger();
+		SenderThread->WaitForCompletion();
+		delete SenderThread;
+		SenderThread = nullptr;
+	}
+
+	if(ConnectionSocket)
+	{
+		if(ConnectionSocket->GetConnectionState() == ESocketConnectionState::SCS_Connected)
 		{
-			retSocket->Close();
-			SocketSubsystem->DestroySocket(retSocket);
+			// Part ways
+			SendChannelListCommand(TEXT("PART"), GetJoinedChannels());
+			FlushOutbound();
 
-			const FTwitchConnection Connection(ETwitchConnectionMessageType::FAILED_TO_CONNECT, TEXT("Connection to Twitch IRC failed!"));
+			// The sending thread is done, nobody else will retry what the socket did not take
+			if(NumPendingSendBytes > 0 && ConnectionSocket->Wait(ESocketWaitConditions::WaitForWrite, PartFlushTimeout))
+			{
+				FlushPendingBytes();
+			}
+			
+			const FTwitchConnection Connection(ETwitchConnectionMessageType::DISCONNECTED, TEXT("Diconnected by request gracefully"));
 			ConnectionQueue->Enqueue(Connection);
-			ReceiveConnections(Connection);
-			return 1;
 		}
 
+		DestroySocket();
+	}
+
+	// Nothing more will be received, the capture is complete
+	StopCapture();
+	
+	return ExitCode;
+}
+
+bool FTwitchMessageReceiver::Connect(FString& OutError)
+{
+	// Resolve the server and race connections to all its addresses, without waiting longer than the timeout or past a stop request
+	// Port: HTTPS 6697, HTTP 6667
+	FTwitchConnector Connector(Settings.ServerHost, Settings.ServerPort, Settings.ConnectTimeoutSeconds, Settings.ConnectAttemptDelaySeconds);
+	FSocket* retSocket = Connector.Connect(WakeEvent, [this]() { return static_cast<bool>(bShouldExit); }, OutError);
+	if (retSocket == nullptr)
+	{
+		return false;
+	}
+
+	// Nothing from a previous connection is valid anymore
+	ResetPendingBytes();
+
+	{
+		FScopeLock Lock(&SocketLock);
 		ConnectionSocket = retSocket;
+	}
+
+	LineFramer.Reset();
+	bPingPending = false;
+	bReconnectRequested = false;
+
+	const bool bPassOK = SendIRCMessage(TEXT("PASS ") + OAuth);
+	const bool bNickOK = SendIRCMessage(TEXT("NICK ") + Username);
+	if(!(bPassOK && bNickOK))
+	{
+		DestroySocket();
+
+		OutError = TEXT("Could not send initial PASS and NICK messages for Auth");
+		return false;
+	}
 
-		const bool bPassOK = SendIRCMessage(TEXT("PASS ") + OAuth);
-		const bool bNickOK = SendIRCMessage(TEXT("NICK ") + Username);
-		const bool bSuccess = bPassOK && bNickOK;
-		if(bSuccess)
+	return true;
+}
+
+FTwitchMessageReceiver::ETwitchAuthResult FTwitchMessageReceiver::Authenticate(FString& OutMessage)
+{
+	const double AuthDeadline = FPlatformTime::Seconds() + AuthTimeoutSeconds;
+	while(!bShouldExit)
+	{
+		const double AuthTimeLeft = AuthDeadline - FPlatformTime::Seconds();
+		if(AuthTimeLeft <= 0.0)
 		{
-			bWaitingForAuth = true;
+			OutMessage = TEXT("Server did not respond");
+			return ETwitchAuthResult::FAILED;
 		}
-		else
+
+		// Wait for the server reply, a stop request will wake us up too
+		if(!ConnectionSocket->Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromSeconds(AuthTimeLeft)))
 		{
-			retSocket->Close();
-			SocketSubsystem->DestroySocket(retSocket);
+			continue;
+		}
 
-			const FTwitchConnection Connection(ETwitchConnectionMessageType::FAILED_TO_CONNECT,TEXT("Could not send initial PASS and NICK messages for Auth"));
-			ConnectionQueue->Enqueue(Connection);
-			ReceiveConnections(Connection);
-			return 1;
+		if(!ReceiveFromConnection())
+		{
+			OutMessage = TEXT("Server closed the connection");
+			return ETwitchAuthResult::FAILED;
+		}
+
+		FAnsiStringView Line;
+		if(LineFramer.PopLine(Line))
+		{
+			OutMessage = TwitchUtf8::ToString(Line);
+			if(!(OutMessage.StartsWith(TEXT(":tmi.twitch.tv 001")) && OutMessage.Contains(TEXT(":Welcome, GLHF!"))))
+			{
+				return ETwitchAuthResult::REJECTED;
+			}
+
+			return ETwitchAuthResult::AUTHENTICATED;
 		}
 	}
 
-	while(bWaitingForAuth && !bShouldExit)
+	OutMessage = TEXT("Stopped");
+	return ETwitchAuthResult::FAILED;
+}
+
+FTwitchMessageReceiver::ETwitchSessionEnd FTwitchMessageReceiver::RunSession(const bool bResumed)
+{
+	// Request command capability (If the user has extended bot permissions this means something, else it is mostly ignored)
+	// This allows whispers to function, if the bot account has extended permissions.
+	SendIRCMessage(TEXT("CAP REQ :twitch.tv/commands"));
+
+	// Request tags capability (If the user has extended bot permissions this means something, else it is mostly ignored)
+	SendIRCMessage(TEXT("CAP REQ :twitch.tv/tags"));
+
+	// The sending thread joins the channels again. The messages it holds were kept for the new connection
+	bRestoreChannels = bResumed;
+	bIsConnected = true;
+
+	// From now on all messages go through the sending thread, including the JOINs queued so far
+	if(SenderThread == nullptr)
+	{
+		SenderThread = FRunnableThread::Create(&SendWorker, TEXT("FTwitchMessageSender"));
+	}
+	SendEvent->Trigger();
+
+	// The welcome line is usually followed by more server lines in the same read
+	ParseReceivedLines();
+
+	while(!bShouldExit && !bReconnectRequested)
 	{
-		FString connectionMessage = ReceiveFromConnection();
-		if(!connectionMessage.IsEmpty())
+		// Block until the server sends something or we are woken up to stop
+		if(ConnectionSocket->Wait(ESocketWaitConditions::WaitForRead, bPingPending ? PingTimeout : IdleWaitTime))
 		{
-			if(!(connectionMessage.StartsWith(TEXT(":tmi.twitch.tv 001")) && connectionMessage.Contains(TEXT(":Welcome, GLHF!"))))
+			if(ReceiveFromConnection())
 			{
-				ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
-				ConnectionSocket->Close();
-				SocketSubsystem->DestroySocket(ConnectionSocket);
-				ConnectionSocket = nullptr;
-			
-				const FTwitchConnection Connection(ETwitchConnectionMessageType::FAILED_TO_AUTHENTICATE, connectionMessage);
-				ConnectionQueue->Enqueue(Connection);
-				ReceiveConnections(Connection);
-				return 1;
+				bPingPending = false;
+				ParseReceivedLines();
+				continue;
 			}
+		}
+		else if(!bPingPending && ConnectionSocket->GetConnectionState() == ESocketConnectionState::SCS_Connected)
+		{
+			// Nothing to read for a while. Make sure the connection is still alive, a half open one looks just like this
+			bPingPending = true;
+			SendIRCMessage(TEXT("PING :tmi.twitch.tv"));
+			continue;
+		}
 
-			const FTwitchConnection Connection(ETwitchConnectionMessageType::CONNECTED, connectionMessage);
-			ConnectionQueue->Enqueue(Connection);
-			ReceiveConnections(Connection);
-			
-			bWaitingForAuth = false;
+		break;
+	}
+
+	bIsConnected = false;
+
+	if(bShouldExit)
+	{
+		return ETwitchSessionEnd::STOPPED;
+	}
+
+	return bReconnectRequested ? ETwitchSessionEnd::RECONNECT_REQUESTED : ETwitchSessionEnd::LOST;
+}
+
+uint32 FTwitchMessageReceiver::RunReplay()
+{
+	FTwitchCaptureReader Reader;
+	FString Error;
+	if(!Reader.Open(ReplayFilename, Error))
+	{
+		ConnectionQueue->Enqueue(FTwitchConnection(ETwitchConnectionMessageType::FAILED_TO_CONNECT, Error));
+		bShouldExit = true;
+		return 1;
+	}
 
-			if(!Channel.IsEmpty())
+	bIsConnected = true;
+	ConnectionQueue->Enqueue(FTwitchConnection(ETwitchConnectionMessageType::CONNECTED, FString::Printf(TEXT("Replaying %s"), *ReplayFilename)));
+
+	const double StartTime = FPlatformTime::Seconds();
+	int64 NumBytes = 0;
+
+	int64 TimeMicros;
+	const uint8* Data;
+	int32 Size;
+	while(!bShouldExit && Reader.Next(TimeMicros, Data, Size))
+	{
+		if(ReplaySpeed > 0.0f)
+		{
+			// A stop request wakes us up
+			const double WaitSeconds = StartTime + TimeMicros / (1000000.0 * ReplaySpeed) - FPlatformTime::Seconds();
+			if(WaitSeconds >= 0.001)
 			{
-				const bool joinOK = SendIRCMessage(TEXT("JOIN #") + Channel);
-				if (!joinOK)
+				WakeEvent->Wait(FTimespan::FromSeconds(WaitSeconds));
+				if(bShouldExit)
 				{
-					ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
-					ConnectionSocket->Close();
-					SocketSubsystem->DestroySocket(ConnectionSocket);
-					ConnectionSocket = nullptr;
-
-					const FTwitchConnection Connection2(ETwitchConnectionMessageType::FAILED_TO_AUTHENTICATE, TEXT("Failed to join channel"));
-					ConnectionQueue->Enqueue(Connection2);
-					ReceiveConnections(Connection2);
-					return 1;
+					break;
 				}
 			}
+		}
 
-			bIsConnected = true;
+		ProcessReceivedBytes(Data, Size);
+		NumBytes += Size;
 
-			// Request command capability (If the user has extended bot permissions this means something, else it is mostly ignored)
-			// This allows whispers to function, if the bot account has extended permissions.
-			SendIRCMessage(TEXT("CAP REQ :twitch.tv/commands"));
+		// Nothing goes out during a replay, the answers to the recorded PINGs and anything the game sends are dropped
+		ControlQueue->Empty();
+		SendingQueue->Empty();
+		ChannelPrivilegeQueue.Empty();
+		bReconnectRequested = false;
+	}
 
-			// Request tags capability (If the user has extended bot permissions this means something, else it is mostly ignored)
-			SendIRCMessage(TEXT("CAP REQ :twitch.tv/tags"));
+	const double ElapsedSeconds = FPlatformTime::Seconds() - StartTime;
+	bIsConnected = false;
+	bShouldExit = true;
+
+	ConnectionQueue->Enqueue(FTwitchConnection(ETwitchConnectionMessageType::DISCONNECTED, FString::Printf(TEXT("Replay finished, %lld bytes in %.3f seconds"), NumBytes, ElapsedSeconds)));
+	return 0;
+}
+
+double FTwitchMessageReceiver::GetReconnectDelay(const int32 NumFailedAttempts)
+{
+	// Exponential backoff with jitter, so many clients dropped at once don't all come back at the same time
+	const double BaseDelay = FMath::Max(Settings.ReconnectBaseDelaySeconds, 0.1f);
+	const double MaxDelay = FMath::Max<double>(Settings.ReconnectMaxDelaySeconds, BaseDelay);
+	const double Delay = FMath::Min(BaseDelay * (1 << FMath::Min(NumFailedAttempts, 16)), MaxDelay);
+	return Delay * ReconnectRandom.FRandRange(0.5f, 1.0f);
+}
+
+uint32 FTwitchMessageReceiver::RunSender()
+{
+	while(!bShouldExit)
+	{
+		// Nothing goes out while reconnecting, the queued messages wait for the new connection
+		if(!bIsConnected)
+		{
+			SendEvent->Wait();
+			continue;
 		}
-		else
+
+		if(bRestoreChannels)
 		{
-			// Wait a bit
-			SleepReceiver(0.5f);
-			++NumAuthWaits;
-			if(NumAuthWaits > 4)
+			bRestoreChannels = false;
+			for(const FString& ChannelName : GetJoinedChannels())
 			{
-				NumAuthWaits = 0;
-				bShouldExit = true;
-
-				const FTwitchConnection Connection(ETwitchConnectionMessageType::FAILED_TO_AUTHENTICATE, TEXT("Server did not respond"));
-				ConnectionQueue->Enqueue(Connection);
-				ReceiveConnections(Connection);
+				SendScheduler.PushJoin(ChannelName);
 			}
 		}
-	}
 
-	while(ConnectionSocket != nullptr && !bShouldExit)
-	{
-		if(ConnectionSocket->GetConnectionState() == ESocketConnectionState::SCS_Connected)
+		FTwitchSendMessage sendMessage;
+
+		// Control messages are answers to the server and don't count against the rate limits
+		while(ControlQueue->Dequeue(sendMessage))
+		{
+			OutboundBuffer.Append(sendMessage.Line);
+		}
+
+		TPair<FString, bool> ChannelPrivilege;
+		while(ChannelPrivilegeQueue.Dequeue(ChannelPrivilege))
+		{
+			SendScheduler.SetChannelPrivileged(ChannelPrivilege.Key, ChannelPrivilege.Value);
+		}
+
+		// Hand the new messages to the scheduler. Leaving is not rate limited, all the PARTs go out right away in one batch
+		PartChannels.Reset();
+		while(SendingQueue->Dequeue(sendMessage))
 		{
-			FString connectionMessage = ReceiveFromConnection();
-			if (!connectionMessage.IsEmpty())
+			switch(sendMessage.Type)
 			{
-				ParseMessage(connectionMessage);
+			case ETwitchSendMessageType::CHAT_MESSAGE:
+			{
+				// Twitch would reject it after it cost a token
+				if(IsDuplicateChat(sendMessage, FPlatformTime::Seconds()))
+				{
+					DropDuplicateChat(sendMessage);
+					break;
+				}
+
+				const FString TargetChannel = sendMessage.Channel;
+				SendScheduler.Push(MoveTemp(sendMessage), TargetChannel);
+				break;
+			}
+			case ETwitchSendMessageType::JOIN_MESSAGE:
+				SendScheduler.PushJoin(sendMessage.Channel);
+				break;
+			case ETwitchSendMessageType::PART_MESSAGE:
+				// No need to leave a channel we did not join yet
+				if(!SendScheduler.CancelJoin(sendMessage.Channel))
+				{
+					PartChannels.Add(sendMessage.Channel);
+				}
+				break;
+			default:
+				ProcessSendMessage(sendMessage);
+				break;
 			}
+		}
+
+		if(PartChannels.Num() > 0)
+		{
+			SendChannelListCommand(TEXT("PART"), PartChannels);
+		}
 
-			if(NextSendMessageTime <= AccumulationTime)
+		// Send everything the rate limits allow right now. While the socket is behind, the messages wait in the scheduler
+		// where they keep their priority, instead of piling up behind the bytes it did not take
+		const double Now = FPlatformTime::Seconds();
+		double WaitSeconds = 0.0;
+		bool bSendBytesCapped = false;
+		{
+			TWITCHPLAY_SCOPE("Send", STAT_TwitchPlay_Send);
+			while(bIsConnected)
 			{
-				// Send our messages
-				FTwitchSendMessage sendMessage;
-				if(SendingQueue->Dequeue(sendMessage))
+				const int32 NumUnsentBytes = OutboundBuffer.Num() + NumPendingSendBytes;
+				if(NumUnsentBytes > 0 && NumUnsentBytes >= Settings.MaxPendingSendBytes)
 				{
-					if(sendMessage.Type == ETwitchSendMessageType::CHAT_MESSAGE)
-					{
-						if(!sendMessage.Channel.IsEmpty())
-						{
-							// Specific user private message
-							SendIRCMessage(sendMessage.Message, sendMessage.Channel);
-						}
-						else if(!Channel.IsEmpty())
-						{
-							// To the currently joined channel
-							SendIRCMessage(sendMessage.Message, Channel);
-						}
-						else
-						{
-							const FTwitchConnection Connection(ETwitchConnectionMessageType::ERROR,TEXT("Cannot send message. No channel specified, and not joined to a channel."));
-							ConnectionQueue->Enqueue(Connection);
-							ReceiveConnections(Connection);
-						}
-					}
-					else if(sendMessage.Type == ETwitchSendMessageType::JOIN_MESSAGE)
-					{
-						if(!Channel.IsEmpty())
-						{
-							SendIRCMessage(TEXT("PART #") + Channel);
-						}
-						Channel = sendMessage.Channel;
-						if(!Channel.IsEmpty())
-						{
-							SendIRCMessage(TEXT("JOIN #") + Channel);
-						}
-					}
-
-					NextSendMessageTime = AccumulationTime + TimeBetweenMessages;
+					bSendBytesCapped = true;
+					break;
 				}
+				if(!SendScheduler.Pop(Now, sendMessage, WaitSeconds))
+				{
+					break;
+				}
+
+				// An identical line may have been written while this one waited for its token. The token is lost,
+				// Twitch would have counted the rejected message as well
+				if(sendMessage.Type == ETwitchSendMessageType::CHAT_MESSAGE && IsDuplicateChat(sendMessage, Now))
+				{
+					DropDuplicateChat(sendMessage);
+					continue;
+				}
+				ProcessSendMessage(sendMessage);
 			}
-			
-			// Sleep a bit before pulling more messages
-			SleepReceiver(0.2f);
+
+			// Control answers, PARTs and chat go out in a single write, after what the socket did not take last time
+			FlushOutbound();
 		}
-		else
+
+		NumSendPending = SendScheduler.GetNumPending();
+		NumOutboundTokens = SendScheduler.GetAccountTokens(Now);
+		SET_DWORD_STAT(STAT_TwitchPlay_SendQueueDepth, NumSendPending);
+		SET_DWORD_STAT(STAT_TwitchPlay_OutboundTokens, NumOutboundTokens);
+		SET_DWORD_STAT(STAT_TwitchPlay_PendingSendBytes, NumPendingSendBytes);
+
+		// Sleep until a message is queued, the next token is available or we are stopping
+		const uint32 WaitMilliseconds = SendScheduler.IsEmpty() ? MAX_uint32 : static_cast<uint32>(FMath::Max(FMath::CeilToInt(WaitSeconds * 1000.0), 1));
+
+		// The socket buffer is full, the rest is flushed when it is writable again. Past the byte cap the ready messages
+		// cannot go out before that, so the scheduler does not shorten the wait
+		if(NumPendingSendBytes > 0)
 		{
-			const FTwitchConnection Connection(ETwitchConnectionMessageType::DISCONNECTED, TEXT("Lost connection to server"));
-			ConnectionQueue->Enqueue(Connection);
-			ReceiveConnections(Connection);
-			bShouldExit = true;
-			bIsConnected = false;
+			WaitUntilWritable(bSendBytesCapped ? WritableRetryMilliseconds : FMath::Min(WaitMilliseconds, WritableRetryMilliseconds));
+			continue;
+		}
+
+		// The socket took everything it was held back for, more can go out right away
+		if(bSendBytesCapped)
+		{
+			continue;
 		}
+		SendEvent->Wait(WaitMilliseconds);
 	}
 
-	bIsConnected = false;
-	if(ConnectionSocket)
+	return 0;
+}
+
+void FTwitchMessageReceiver::ProcessSendMessage(FTwitchSendMessage& SendMessage)
+{
+	if(SendMessage.Type == ETwitchSendMessageType::CHAT_MESSAGE)
 	{
-		if(ConnectionSocket->GetConnectionState() == ESocketConnectionState::SCS_Connected)
+		if(!SendMessage.Channel.IsEmpty())
 		{
-			if(!Channel.IsEmpty())
+			// The channel was resolved and the line encoded when the message was queued. It is written in this wake up
+			const double Now = FPlatformTime::Seconds();
+			if(!SendScheduler.IsChannelPrivileged(SendMessage.Channel))
 			{
-				// Part ways
-				SendIRCMessage(TEXT("PART #") + Channel);
+				DuplicateFilter.Record(SendMessage.Line, Now);
 			}
-			
-			const FTwitchConnection Connection(ETwitchConnectionMessageType::DISCONNECTED, TEXT("Diconnected by request gracefully"));
+			OutboundBuffer.Append(SendMessage.Line);
+			SendBufferPool->Release(MoveTemp(SendMessage.Line));
+
+			const double WaitSeconds = Now - SendMessage.QueueTime;
+			SendWaitSeconds = SendWaitSeconds + WaitSeconds;
+			++NumMessagesSent;
+			SET_FLOAT_STAT(STAT_TwitchPlay_SendWaitMilliseconds, WaitSeconds * 1000.0);
+		}
+		else
+		{
+			const FTwitchConnection Connection(ETwitchConnectionMessageType::ERROR,TEXT("Cannot send message. No channel specified, and not joined to a channel."));
 			ConnectionQueue->Enqueue(Connection);
-			ReceiveConnections(Connection);
 		}
+	}
+	else if(SendMessage.Type == ETwitchSendMessageType::JOIN_MESSAGE)
+	{
+		// Already batched by the scheduler, as in "#a,#b,#c"
+		TwitchOutbound::AppendLine(TEXT("JOIN ") + SendMessage.Message, OutboundBuffer);
+	}
+	else if(SendMessage.Type == ETwitchSendMessageType::RAW_MESSAGE)
+	{
+		TwitchOutbound::AppendLine(SendMessage.Message, OutboundBuffer);
+	}
+}
 
-		ConnectionSocket->Close();
-		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(ConnectionSocket);
-		ConnectionSocket = nullptr;
+bool FTwitchMessageReceiver::IsDuplicateChat(const FTwitchSendMessage& SendMessage, const double Now) const
+{
+	// Twitch exempts the privileged accounts from the duplicate rule
+	return !SendScheduler.IsChannelPrivileged(SendMessage.Channel) && DuplicateFilter.IsDuplicate(SendMessage.Line, Now);
+}
+
+void FTwitchMessageReceiver::DropDuplicateChat(FTwitchSendMessage& SendMessage)
+{
+	++NumDuplicatesDropped;
+	SendBufferPool->Release(MoveTemp(SendMessage.Line));
+
+	// The game was told the message was queued, let it know it will not go out
+	const FTwitchConnection Connection(ETwitchConnectionMessageType::ERROR, FString::Printf(TEXT("Chat message to #%s dropped, an identical one was sent less than %.0f seconds ago."), *SendMessage.Channel, TwitchOutbound::DuplicateWindowSeconds));
+	ConnectionQueue->Enqueue(Connection);
+}
+
+void FTwitchMessageReceiver::FlushOutbound()
+{
+	if(OutboundBuffer.Num() > 0)
+	{
+		QueueBytes(OutboundBuffer.GetData(), OutboundBuffer.Num());
+
+		// Keeps its allocation, most wake ups write about as much as the previous ones
+		OutboundBuffer.Reset();
 	}
-	
-	return 0;
+
+	FlushPendingBytes();
 }
 
-bool FTwitchMessageReceiver::SendIRCMessage(const FString& message, const FString channel) const
+bool FTwitchMessageReceiver::SendIRCMessage(const FString& message)
 {
-	// Only operate on existing and connected sockets
-	if (ConnectionSocket != nullptr && ConnectionSocket->GetConnectionState() == ESocketConnectionState::SCS_Connected)
+	TArray<uint8, TInlineAllocator<256>> Line;
+	const FTCHARToUTF8 Utf8(*message, message.Len());
+	Line.Append(reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length());
+	Line.Add('\r');
+	Line.Add('\n');
+	QueueBytes(Line.GetData(), Line.Num());
+
+	// The receiving thread never waits for the socket to have room, the sending thread writes the rest
+	const bool bConnectionOK = FlushPendingBytes();
+	if(NumPendingSendBytes > 0)
 	{
-		FString messageOut = message;
-		// If the user specified a receiver format the message appropriately ("PRIVMSG")
-		if (!channel.IsEmpty())
+		SendEvent->Trigger();
+	}
+	return bConnectionOK;
+}
+
+void FTwitchMessageReceiver::QueueBytes(const uint8* Data, const int32 Size)
+{
+	FScopeLock Lock(&PendingSendLock);
+	PendingSendBytes.Append(Data, Size);
+	NumPendingSendBytes = PendingSendBytes.Num() - PendingSendOffset;
+}
+
+bool FTwitchMessageReceiver::FlushPendingBytes()
+{
+	FScopeLock PendingLock(&PendingSendLock);
+	if(PendingSendOffset >= PendingSendBytes.Num())
+	{
+		return true;
+	}
+
+	bool bConnectionOK = true;
+	{
+		// The receiving thread may be replacing the socket after a lost connection
+		FScopeLock Lock(&SocketLock);
+
+		// GetConnectionState reports a socket with a full send buffer as not connected, the send result tells instead
+		if (ConnectionSocket == nullptr)
+		{
+			return false;
+		}
+
+		// A send takes what fits in the socket buffer. The rest goes from where it stopped once there is room again
+		while (PendingSendOffset < PendingSendBytes.Num())
 		{
-			messageOut = FString::Printf(TEXT("PRIVMSG #%s :%s"), *channel, *message);
+			int32 SentOut = 0;
+			if (!ConnectionSocket->Send(PendingSendBytes.GetData() + PendingSendOffset, PendingSendBytes.Num() - PendingSendOffset, SentOut))
+			{
+				bConnectionOK = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->GetLastErrorCode() == SE_EWOULDBLOCK;
+				break;
+			}
+
+			if (SentOut <= 0)
+			{
+				break;
+			}
+			PendingSendOffset += SentOut;
 		}
-		messageOut += TEXT("\r\n");
-		const TCHAR* serializedMessage = GetData(messageOut);
-		const int32 size = FCString::Strlen(serializedMessage);
-		int32 sentOut;
-		return ConnectionSocket->Send(reinterpret_cast<const uint8*>(TCHAR_TO_UTF8(serializedMessage)), size, sentOut);
 	}
-	
-	return false;
+
+	// Sent bytes are dropped from the front once they are the larger part, so each byte is moved at most once or twice
+	if (PendingSendOffset >= PendingSendBytes.Num())
+	{
+		PendingSendBytes.Reset();
+		PendingSendOffset = 0;
+	}
+	else if (PendingSendOffset > PendingSendBytes.Num() / 2)
+	{
+		PendingSendBytes.RemoveAt(0, PendingSendOffset, false);
+		PendingSendOffset = 0;
+	}
+
+	NumPendingSendBytes = PendingSendBytes.Num() - PendingSendOffset;
+	return bConnectionOK;
+}
+
+void FTwitchMessageReceiver::ResetPendingBytes()
+{
+	FScopeLock Lock(&PendingSendLock);
+	PendingSendBytes.Reset();
+	PendingSendOffset = 0;
+	NumPendingSendBytes = 0;
 }
 
 void FTwitchMessageReceiver::Stop()
 {
 	bShouldExit = true;
+	WakeThreads();
 }
 
 void FTwitchMessageReceiver::Exit()
 {
 }
 
-void FTwitchMessageReceiver::PullMessages(TArray<FString>& OutUsernames, TArray<FString>& OutMessages) const
+void FTwitchMessageReceiver::AddPipelineStats(FTwitchPipelineStats& OutStats) const
+{
+	OutStats.BytesReceived += NumBytesReceived;
+	OutStats.LinesReceived += NumLinesReceived;
+	OutStats.MessagesDropped += GetNumDroppedMessages();
+	OutStats.MessagesSent += NumMessagesSent;
+	OutStats.DuplicatesDropped += NumDuplicatesDropped;
+	OutStats.ReceiveQueueDepth += GetReceiveQueueDepth();
+	OutStats.SendQueueDepth += NumSendPending;
+	OutStats.OutboundTokens += NumOutboundTokens;
+	OutStats.PendingSendBytes += NumPendingSendBytes;
+	OutStats.MessagesRejected += NumMessagesRejected;
+	OutStats.ParseSeconds += ParseSeconds;
+	OutStats.SendWaitSeconds += SendWaitSeconds;
+}
+
+void FTwitchMessageReceiver::PullMessages(TArray<FTwitchReceivedMessage>& OutMessages) const
+{
+	if(ReceivingQueue.IsValid())
+	{
+		ReceivingQueue->DequeueAll(OutMessages);
+	}
+}
+
+bool FTwitchMessageReceiver::SendMessage(const ETwitchSendMessageType type, const FString& message, const FString& channel, const ETwitchMessagePriority priority) const
+{
+	if(!SendingQueue.IsValid())
+	{
+		return false;
+	}
+
+	// The socket is not keeping up. Refusing now lets the game know, instead of the message going out late or not at all
+	if(type == ETwitchSendMessageType::CHAT_MESSAGE && NumPendingSendBytes >= Settings.MaxPendingSendBytes)
+	{
+		++NumMessagesRejected;
+		return false;
+	}
+
+	// Messages without a channel go to the default channel at the time they are queued. The line is built from the normalized name
+	const FString TargetChannel = type != ETwitchSendMessageType::CHAT_MESSAGE ? channel : channel.IsEmpty() ? GetDefaultChannel() : NormalizeChannel(channel);
+	const double QueueTime = FPlatformTime::Seconds();
+	if(type != ETwitchSendMessageType::CHAT_MESSAGE || TargetChannel.IsEmpty())
+	{
+		SendingQueue->Enqueue(FTwitchSendMessage {type, message, TargetChannel, priority, QueueTime});
+		SendEvent->Trigger();
+		return true;
+	}
+
+	// Encoded once, here. Too long messages become several, each one taking a rate limit token
+	const FTCHARToUTF8 Utf8Message(*message, message.Len());
+	const FTCHARToUTF8 Utf8Channel(*TargetChannel, TargetChannel.Len());
+	const FAnsiStringView ChannelView(Utf8Channel.Get(), Utf8Channel.Length());
+	TwitchOutbound::FChatChunks Chunks;
+	if(!TwitchOutbound::SplitChatMessage(FAnsiStringView(Utf8Message.Get(), Utf8Message.Length()), TwitchOutbound::MaxMessageBytes, Chunks))
+	{
+		return false;
+	}
+
+	for(const TwitchOutbound::FChatChunk& Chunk : Chunks)
+	{
+		FTwitchSendMessage ChunkMessage {type, FString(), TargetChannel, priority, QueueTime, SendBufferPool->Acquire()};
+		TwitchOutbound::AppendChatLine(ChannelView, Chunk, ChunkMessage.Line);
+		SendingQueue->Enqueue(MoveTemp(ChunkMessage));
+	}
+	SendEvent->Trigger();
+	return true;
+}
+
+void FTwitchMessageReceiver::JoinChannels(const TArray<FString>& channels)
+{
+	FScopeLock Lock(&ChannelsLock);
+	for(const FString& channel : channels)
+	{
+		const FString ChannelName = NormalizeChannel(channel);
+		if(!ChannelName.IsEmpty() && !Channels.Contains(ChannelName))
+		{
+			Channels.Add(ChannelName);
+			SendingQueue->Enqueue(FTwitchSendMessage {ETwitchSendMessageType::JOIN_MESSAGE, TEXT(""), ChannelName});
+		}
+	}
+	SendEvent->Trigger();
+}
+
+void FTwitchMessageReceiver::LeaveChannels(const TArray<FString>& channels)
 {
-	if(ReceivingQueue.IsValid() && !ReceivingQueue->IsEmpty())
+	FScopeLock Lock(&ChannelsLock);
+	for(const FString& channel : channels)
 	{
-		FTwitchReceiveMessages message;
-		while(ReceivingQueue->Dequeue(message))
+		const FString ChannelName = NormalizeChannel(channel);
+		if(Channels.Remove(ChannelName) > 0)
 		{
-			OutUsernames.Append(message.Usernames);
-			OutMessages.Append(message.Messages);
+			SendingQueue->Enqueue(FTwitchSendMessage {ETwitchSendMessageType::PART_MESSAGE, TEXT(""), ChannelName});
 		}
 	}
+	SendEvent->Trigger();
+}
+
+void FTwitchMessageReceiver::SetPoll(const TSharedPtr<FTwitchPoll, ESPMode::ThreadSafe>& InPoll)
+{
+	FScopeLock Lock(&PollLock);
+	Poll = InPoll;
+}
+
+TArray<FString> FTwitchMessageReceiver::GetJoinedChannels() const
+{
+	FScopeLock Lock(&ChannelsLock);
+	return Channels;
+}
+
+FString FTwitchMessageReceiver::GetDefaultChannel() const
+{
+	FScopeLock Lock(&ChannelsLock);
+	return Channels.Num() > 0 ? Channels[0] : FString();
+}
+
+FString FTwitchMessageReceiver::NormalizeChannel(const FString& channel)
+{
+	FString ChannelName = channel.TrimStartAndEnd().ToLower();
+	ChannelName.RemoveFromStart(TEXT("#"));
+	return ChannelName;
 }
 
-void FTwitchMessageReceiver::SendMessage(const ETwitchSendMessageType type, const FString& message, const FString& channel) const
+void FTwitchMessageReceiver::SendChannelListCommand(const TCHAR* Command, const TArray<FString>& ChannelList)
 {
-	if(SendingQueue.IsValid())
+	FString Line;
+	for(const FString& ChannelName : ChannelList)
 	{
-		SendingQueue->Enqueue(FTwitchSendMessage {type, message, channel});
+		if(!Line.IsEmpty() && Line.Len() + ChannelName.Len() + 2 > MaxChannelListLength)
+		{
+			TwitchOutbound::AppendLine(FString::Printf(TEXT("%s %s"), Command, *Line), OutboundBuffer);
+			Line.Reset();
+		}
+
+		if(!Line.IsEmpty())
+		{
+			Line += TEXT(',');
+		}
+		Line += TEXT('#');
+		Line += ChannelName;
+	}
+
+	if(!Line.IsEmpty())
+	{
+		TwitchOutbound::AppendLine(FString::Printf(TEXT("%s %s"), Command, *Line), OutboundBuffer);
 	}
 }
 
@@ -363,6 +949,7 @@ void FTwitchMessageReceiver::StopConnection(bool bWaitTillComplete)
 	if(MessagesThread)
 	{
 		bShouldExit = true;
+		WakeThreads();
 		if(bWaitTillComplete)
 		{
 			MessagesThread->Kill(true);
@@ -370,351 +957,358 @@ void FTwitchMessageReceiver::StopConnection(bool bWaitTillComplete)
 	}
 }
 
-void FTwitchMessageReceiver::SleepReceiver(float seconds)
+void FTwitchMessageReceiver::WakeThreads()
 {
-	FPlatformProcess::Sleep(seconds);
-	AccumulationTime += seconds;
+	SendEvent->Trigger();
+	WakeEvent->Trigger();
+
+	// Don't stay stuck on a full queue nobody will pull from anymore
+	if(ReceivingQueue.IsValid())
+	{
+		ReceivingQueue->Unblock();
+	}
+
+	// Shutting down the read side makes any pending socket wait return right away.
+	// Writing is still possible, so we can part ways gracefully.
+	FScopeLock Lock(&SocketLock);
+	if(ConnectionSocket)
+	{
+		ConnectionSocket->Shutdown(ESocketShutdownMode::Read);
+	}
 }
 
-FString FTwitchMessageReceiver::ReceiveFromConnection() const
+bool FTwitchMessageReceiver::WaitUntilWritable(const uint32 TimeoutMilliseconds)
 {
-	TArray<uint8> data;
-	uint32 dataSize;
-	bool received = false;
-	if (ConnectionSocket->HasPendingData(dataSize))
 	{
-		received = true;
-		data.SetNumUninitialized(dataSize); // Make space for the data
-		int32 dataRead;
-		ConnectionSocket->Recv(data.GetData(), data.Num(), dataRead); // Receive the data. Hopefully the buffer is large enough
+		// Held while waiting so the receiving thread does not destroy the socket under us, the timeout keeps it short
+		FScopeLock Lock(&SocketLock);
+		if(ConnectionSocket)
+		{
+			return ConnectionSocket->Wait(ESocketWaitConditions::WaitForWrite, FTimespan::FromMilliseconds(TimeoutMilliseconds));
+		}
 	}
 
-	FString connectionMessage;
-	if (received)
+	// The connection is being replaced, the sending thread waits for it on its event
+	SendEvent->Wait(TimeoutMilliseconds);
+	return false;
+}
+
+void FTwitchMessageReceiver::DestroySocket()
+{
+	FScopeLock Lock(&SocketLock);
+	if(ConnectionSocket)
 	{
-		connectionMessage = ANSIBytesToString(data.GetData(), data.Num());
+		ConnectionSocket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(ConnectionSocket);
+		ConnectionSocket = nullptr;
 	}
-
-	return connectionMessage;
 }
 
-void FTwitchMessageReceiver::ParseMessage(const FString& Message) const
+bool FTwitchMessageReceiver::ReceiveFromConnection()
 {
-	FTwitchReceiveMessages TwitchMessages;
-	
-	TArray<FString> MessageLines;
-	Message.ParseIntoArrayLines(MessageLines); // A single "message" from Twitch IRC could include multiple lines. Split them now
+	int32 FreeSpace;
+	uint8* WriteBuffer = LineFramer.GetWriteBuffer(FreeSpace);
 
-	// Parse each line into its parts
-	// Each line from Twitch contains meta information and content
-	// Also need to check if the message is a PING sent from Twitch to check if the connection is alive
-	// This is in the form "PING :tmi.twitch.tv" to which we need to reply with "PONG :tmi.twitch.tv"
-	for (int32 CycleLine = 0; CycleLine < MessageLines.Num(); CycleLine++)
+	// Receive straight into the framer, a line cut in half stays there until the rest of it arrives
+	int32 dataRead = 0;
 	{
-		// If we receive a PING immediately reply with a PONG and skip the line parsing
-		if (MessageLines[CycleLine].Equals("PING :tmi.twitch.tv"))
+		TWITCHPLAY_SCOPE("Receive", STAT_TwitchPlay_Receive);
+		if (!ConnectionSocket->Recv(WriteBuffer, FreeSpace, dataRead))
 		{
-			SendIRCMessage("PONG :tmi.twitch.tv");
-			continue; // Skip line parsing
+			// The socket was signaled as readable but nothing could be read: the other end closed the connection
+			return false;
 		}
+	}
+
+	LineFramer.CommitWrite(dataRead);
+	NumBytesReceived += dataRead;
+	INC_DWORD_STAT_BY(STAT_TwitchPlay_BytesReceived, dataRead);
 
-		if (!MessageLines[CycleLine].IsEmpty())
+	if(dataRead > 0)
+	{
+		FScopeLock Lock(&CaptureLock);
+		if(CaptureWriter.IsValid())
 		{
-			const FTwitchConnection Connection(ETwitchConnectionMessageType::MESSAGE, MessageLines[CycleLine]);
-			ConnectionQueue->Enqueue(Connection);
-			ReceiveConnections(Connection);
+			CaptureWriter->Write(WriteBuffer, dataRead);
+		}
+	}
+	return true;
+}
+
+void FTwitchMessageReceiver::ProcessReceivedBytes(const uint8* Data, const int32 Size)
+{
+	int32 Offset = 0;
+	while(Offset < Size)
+	{
+		int32 FreeSpace;
+		uint8* WriteBuffer = LineFramer.GetWriteBuffer(FreeSpace);
+		if(FreeSpace <= 0)
+		{
+			break;
 		}
 
-		// Parsing line
-		// IRC tags docs: https://dev.twitch.tv/docs/irc/tags
-		// Message form with tag is:
+		// More than the framer holds is parsed in several passes, like several socket reads
+		const int32 NumBytes = FMath::Min(FreeSpace, Size - Offset);
+		FMemory::Memcpy(WriteBuffer, Data + Offset, NumBytes);
+		LineFramer.CommitWrite(NumBytes);
+		Offset += NumBytes;
+		NumBytesReceived += NumBytes;
+		INC_DWORD_STAT_BY(STAT_TwitchPlay_BytesReceived, NumBytes);
 
-		// Example of a non-Bits message: The first Kappa (emote ID 25) is from character 0 (K) to character 4 (a), and the other Kappa is from 12 to 16.
-			// @badge-info=subscriber/11;badges=subscriber/6,premium/1,global_mod/1,turbo/1;color=#0D4200;display-name=ronni;emotes=25:0-4,12-16/1902:6-10;id=b34ccfc7-4977-403a-8a94-33c6bac34fb8;mod=0;room-id=1337;subscriber=0;tmi-sent-ts=1507246572675;turbo=1;user-id=1337;user-type=global_mod :ronni!ronni@ronni.tmi.twitch.tv PRIVMSG #ronni :Kappa Keepo Kappa
+		ParseReceivedLines();
+	}
+}
 
-		// Example of a Bits message:
-			// @badge-info=subscriber/11;badges=subscriber/6,premium/1,staff/1,bits/1000;bits=100;color=#1E90FF;display-name=ronni;emotes=;id=b34ccfc7-4977-403a-8a94-33c6bac34fb8;mod=0;room-id=1337;subscriber=0;tmi-sent-ts=1507246572675;turbo=1;user-id=1337;user-type=staff :ronni!ronni@ronni.tmi.twitch.tv PRIVMSG #ronni :cheer100
+void FTwitchMessageReceiver::ParseReceivedLines()
+{
+	// The text of the whole batch goes into one slab
+	ReceiveBatch.Slab = SlabPool->Acquire();
+	ReceiveBatch.ReceiveTime = FPlatformTime::Seconds();
 
-		if (MessageLines[CycleLine].StartsWith("@badge-info") && MessageLines[CycleLine].Contains("PRIVMSG"))
+	// Held for the whole batch, so the poll is looked up once per read
+	TSharedPtr<FTwitchPoll, ESPMode::ThreadSafe> ActivePoll;
+	{
+		FScopeLock Lock(&PollLock);
+		ActivePoll = Poll;
+	}
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	{
+		TWITCHPLAY_SCOPE("Frame", STAT_TwitchPlay_Frame);
+		FramedLines.Reset();
+		FAnsiStringView Line;
+		while (LineFramer.PopLine(Line))
 		{
-			FTwitchChatMessage ChatMessage;
+			FramedLines.Add(Line);
+		}
+	}
 
-			TArray<FString> messageParts;
-			MessageLines[CycleLine].ParseIntoArray(messageParts, TEXT(" :"));
+	{
+		TWITCHPLAY_SCOPE("Parse", STAT_TwitchPlay_Parse);
+		for (const FAnsiStringView& Line : FramedLines)
+		{
+			ParseMessage(Line, ReceiveBatch, ActivePoll.Get());
+		}
 
-			//Tags
-			TArray<FString> Tags;
-			messageParts[0].ParseIntoArray(Tags, TEXT(";"));
-			
-			for (auto Tag : Tags)
+		if(ReceiveBatch.Messages.Num())
+		{
+			// The messages of a read become visible together, they are all parsed at that point
+			const double ParseTime = FPlatformTime::Seconds();
+			for (FTwitchReceivedMessage& Message : ReceiveBatch.Messages)
 			{
-				if (Tag.StartsWith("@badge-info"))
-				{
-					FString Values;
-					Tag.Split("=", nullptr, &Values);
-					if (Values.IsEmpty())
-					{
-						continue;
-					}
-					TArray<FString> BadgesInfo;
-					Values.ParseIntoArray(BadgesInfo, TEXT(","));
-
-					for (auto BadgeInfo : BadgesInfo)
-					{
-						if (BadgeInfo.StartsWith("admin"))
-						{
-							
-							continue;
-						}
-
-						if (BadgeInfo.StartsWith("bits"))
-						{
-							
-							continue;
-						}
-
-						if (BadgeInfo.StartsWith("broadcaster"))
-						{
-							
-							continue;
-						}
-
-						if (BadgeInfo.StartsWith("global_mod"))
-						{
-							
-							continue;
-						}
-
-						if (BadgeInfo.StartsWith("moderator"))
-						{
-							
-							continue;
-						}
-
-						if (BadgeInfo.StartsWith("subscriber"))
-						{
-							FString Subscriber;
-							BadgeInfo.Split("/", nullptr, &Subscriber);
-							if (Subscriber.IsNumeric())
-							{
-								ChatMessage.bIsSubbed = FCString::Atof(*Subscriber) > 0;
-							}
-							continue;
-						}
-
-						if (BadgeInfo.StartsWith("premium"))
-						{
-							FString Premium;
-							BadgeInfo.Split("/", nullptr, &Premium);
-							if (Premium.IsNumeric())
-							{
-								ChatMessage.bIsSubbed = FCString::Atof(*Premium) > 0;
-							}
-							continue;
-						}
-
-						if (BadgeInfo.StartsWith("staff"))
-						{
-							
-							continue;
-						}
-
-						if (BadgeInfo.StartsWith("turbo"))
-						{
-							
-							continue;
-						}
-					}
-					continue;
-				}
-				
-				if (Tag.StartsWith("badges"))
-				{
-					FString Values;
-					Tag.Split("=", nullptr, &Values);
-					if (Values.IsEmpty())
-					{
-						continue;
-					}
-					TArray<FString> Badges;
-					Values.ParseIntoArray(Badges, TEXT(","));
-
-					for (auto Badge : Badges)
-					{
-						{
-							if (Badge.StartsWith("admin"))
-							{
-							
-								continue;
-							}
-
-							if (Badge.StartsWith("bits"))
-							{
-							
-								continue;
-							}
-
-							if (Badge.StartsWith("broadcaster"))
-							{
-							
-								continue;
-							}
-
-							if (Badge.StartsWith("global_mod"))
-							{
-							
-								continue;
-							}
-
-							if (Badge.StartsWith("moderator"))
-							{
-							
-								continue;
-							}
-
-							if (Badge.StartsWith("subscriber"))
-							{
-								FString Subscriber;
-								Badge.Split("/", nullptr, &Subscriber);
-								if (Subscriber.IsNumeric())
-								{
-									ChatMessage.bIsSubbed = FCString::Atof(*Subscriber) > 0;
-								}
-								continue;
-							}
-
-							if (Badge.StartsWith("premium"))
-							{
-								FString Premium;
-								Badge.Split("/", nullptr, &Premium);
-								if (Premium.IsNumeric())
-								{
-									ChatMessage.bIsSubbed = FCString::Atof(*Premium) > 0;
-								}
-								continue;
-							}
-
-							if (Badge.StartsWith("staff"))
-							{
-							
-								continue;
-							}
-
-							if (Badge.StartsWith("turbo"))
-							{
-							
-								continue;
-							}
-						}
-					}
-					continue;
-				}
-				
-				if (Tag.StartsWith("bits"))
-				{
-					FString Bits;
-					Tag.Split("=", nullptr, &Bits);
-					if (Bits.IsNumeric())
-					{
-						ChatMessage.bBits = true;
-						ChatMessage.Bits = FCString::Atof(*Bits);
-					}
-					continue;
-				}
-				
-				if (Tag.StartsWith("color"))
-				{
-					FString Color;
-					Tag.Split("=", nullptr, &Color);
-					if (!Color.IsEmpty())
-					{
-						ChatMessage.UserColor = FColor::FromHex(Color);
-					}
-					continue;
-				}
-				
-				if (Tag.StartsWith("display-name"))
-				{
-					FString DisplayName;
-					Tag.Split("=", nullptr, &DisplayName);
-					
-					if (!DisplayName.IsEmpty())
-					{
-						ChatMessage.Username = DisplayName;
-					}
-					continue;
-				}
-				
-				if (Tag.StartsWith("emotes"))
-				{
+				Message.ParseTime = ParseTime;
+			}
+			ReceivingQueue->EnqueueBatch(ReceiveBatch.Messages);
+		}
+	}
 
-					continue;
-				}
-				
-				if (Tag.StartsWith("flags"))
-				{
+	if(FramedLines.Num() > 0)
+	{
+		const double BatchSeconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+		NumLinesReceived += FramedLines.Num();
+		ParseSeconds = ParseSeconds + BatchSeconds;
+		INC_DWORD_STAT_BY(STAT_TwitchPlay_LinesReceived, FramedLines.Num());
+		SET_FLOAT_STAT(STAT_TwitchPlay_ParseMicrosPerLine, BatchSeconds * 1000000.0 / FramedLines.Num());
+	}
 
-					continue;
-				}
-				
-				if (Tag.StartsWith("id"))
-				{
+	// The queued messages hold the slab now, it goes back to the pool once they are all delivered
+	ReceiveBatch.Slab.SafeRelease();
+}
 
-					continue;
-				}
-				
-				if (Tag.StartsWith("mod"))
-				{
+void FTwitchMessageReceiver::ParseUserState(const FTwitchIrcMessage& IrcMessage)
+{
+	// The server sends our own user state when we join a channel and after each message we send there
+	// @badge-info=;badges=moderator/1;color=;display-name=bot;emote-sets=0;mod=1;subscriber=0;user-type=mod :tmi.twitch.tv USERSTATE #channel
+	const FAnsiStringView ChannelParam = IrcMessage.GetFirstParam();
+	if (ChannelParam.Len() < 2 || ChannelParam[0] != '#')
+	{
+		return;
+	}
 
-					continue;
-				}
-				
-				if (Tag.StartsWith("room-id"))
-				{
+	bool bPrivileged = false;
 
-					continue;
-				}
-				
-				if (Tag.StartsWith("tmi-sent-ts"))
-				{
+	FTwitchIrcTagIterator Tags(IrcMessage.Tags);
+	FAnsiStringView Key;
+	FAnsiStringView Value;
+	while (Tags.Next(Key, Value))
+	{
+		const ETwitchIrcTag Tag = TwitchIrc::ClassifyTag(Key);
+		if (Tag == ETwitchIrcTag::Mod && Value.Equals("1"))
+		{
+			bPrivileged = true;
+		}
+		else if (Tag == ETwitchIrcTag::Badges)
+		{
+			// Broadcasters and VIPs get the moderator limits too
+			FTwitchBadgeSet Badges;
+			TwitchIrc::ParseBadges(Value, Badges);
+			bPrivileged |= Badges.Has(ETwitchBadge::BROADCASTER) || Badges.Has(ETwitchBadge::MODERATOR) || Badges.Has(ETwitchBadge::VIP);
+		}
+	}
 
-					continue;
-				}
-				
-				if (Tag.StartsWith("user-id"))
-				{
+	const FString ChannelName = TwitchUtf8::ToString(ChannelParam.RightChop(1));
+	const bool* KnownPrivilege = ChannelPrivileges.Find(ChannelName);
+	if (KnownPrivilege == nullptr || *KnownPrivilege != bPrivileged)
+	{
+		ChannelPrivileges.Add(ChannelName, bPrivileged);
+		ChannelPrivilegeQueue.Enqueue(TPair<FString, bool>(ChannelName, bPrivileged));
+		SendEvent->Trigger();
+	}
+}
 
-					continue;
-				}
+void FTwitchMessageReceiver::ParseMessage(const FAnsiStringView& MessageLine, FTwitchReceiveMessages& TwitchMessages, FTwitchPoll* ActivePoll)
+{
+	FTwitchIrcMessage IrcMessage;
+	if (!FTwitchIrcMessage::Parse(MessageLine, IrcMessage))
+	{
+		return;
+	}
+
+	// Check if the message is a PING sent from Twitch to check if the connection is alive
+	// This is in the form "PING :tmi.twitch.tv" to which we need to reply with "PONG :tmi.twitch.tv"
+	if (IrcMessage.IsCommand("PING"))
+	{
+		// Answered with the same bytes, no need to decode them
+		FTwitchSendMessage Pong {ETwitchSendMessageType::RAW_MESSAGE};
+		static const ANSICHAR PongCommand[] = "PONG :";
+		Pong.Line.Append(reinterpret_cast<const uint8*>(PongCommand), UE_ARRAY_COUNT(PongCommand) - 1);
+		Pong.Line.Append(reinterpret_cast<const uint8*>(IrcMessage.Trailing.GetData()), IrcMessage.Trailing.Len());
+		Pong.Line.Add('\r');
+		Pong.Line.Add('\n');
+		ControlQueue->Enqueue(MoveTemp(Pong));
+		SendEvent->Trigger();
+		return; // Skip line parsing
+	}
+
+	// Twitch is about to restart the server we are connected to
+	if (IrcMessage.IsCommand("RECONNECT"))
+	{
+		bReconnectRequested = true;
+		return;
+	}
+
+	if (Settings.bEchoServerMessages)
+	{
+		ConnectionQueue->Enqueue(FTwitchConnection(ETwitchConnectionMessageType::MESSAGE, TwitchUtf8::ToString(MessageLine)));
+	}
+
+	if (IrcMessage.IsCommand("USERSTATE"))
+	{
+		ParseUserState(IrcMessage);
+		return;
+	}
+
+	if (!IrcMessage.IsCommand("PRIVMSG"))
+	{
+		return;
+	}
+
+	// Parsing line
+	// IRC tags docs: https://dev.twitch.tv/docs/irc/tags
+	// Message form with tag is:
+
+	// Example of a non-Bits message: The first Kappa (emote ID 25) is from character 0 (K) to character 4 (a), and the other Kappa is from 12 to 16.
+		// @badge-info=subscriber/11;badges=subscriber/6,premium/1,global_mod/1,turbo/1;color=#0D4200;display-name=ronni;emotes=25:0-4,12-16/1902:6-10;id=b34ccfc7-4977-403a-8a94-33c6bac34fb8;mod=0;room-id=1337;subscriber=0;tmi-sent-ts=1507246572675;turbo=1;user-id=1337;user-type=global_mod :ronni!ronni@ronni.tmi.twitch.tv PRIVMSG #ronni :Kappa Keepo Kappa
+
+	// Example of a Bits message:
+		// @badge-info=subscriber/11;badges=subscriber/6,premium/1,staff/1,bits/1000;bits=100;color=#1E90FF;display-name=ronni;emotes=;id=b34ccfc7-4977-403a-8a94-33c6bac34fb8;mod=0;room-id=1337;subscriber=0;tmi-sent-ts=1507246572675;turbo=1;user-id=1337;user-type=staff :ronni!ronni@ronni.tmi.twitch.tv PRIVMSG #ronni :cheer100
+
+	FTwitchReceivedMessage ChatMessage;
+
+	FAnsiStringView DisplayName;
+
+	FTwitchIrcTagIterator Tags(IrcMessage.Tags);
+	FAnsiStringView Key;
+	FAnsiStringView Value;
+	while (Tags.Next(Key, Value))
+	{
+		switch (TwitchIrc::ClassifyTag(Key))
+		{
+		case ETwitchIrcTag::Badges:
+		{
+			FTwitchBadgeSet Badges;
+			TwitchIrc::ParseBadges(Value, Badges);
+			ChatMessage.BadgeMask |= Badges.Mask;
+
+			// Founders and Prime (premium) subscribers count as subbed too
+			constexpr uint32 SubbedMask = FTwitchBadgeSet::GetBit(ETwitchBadge::SUBSCRIBER) | FTwitchBadgeSet::GetBit(ETwitchBadge::FOUNDER) | FTwitchBadgeSet::GetBit(ETwitchBadge::PREMIUM);
+			ChatMessage.bIsSubbed = (Badges.Mask & SubbedMask) != 0;
+			break;
+		}
+		case ETwitchIrcTag::Mod:
+			if (Value.Len() == 1 && Value[0] == '1')
+			{
+				ChatMessage.BadgeMask |= FTwitchBadgeSet::GetBit(ETwitchBadge::MODERATOR);
 			}
-			
-			
-			// Username
-			if (!ChatMessage.Username.IsEmpty() && messageParts.Num() >= 2)
+			break;
+		case ETwitchIrcTag::Bits:
+		{
+			uint64 Bits;
+			if (TwitchIrc::ParseUInt64(Value, Bits))
 			{
-				FString SenderUsername;
-				messageParts[1].Split("!", &SenderUsername, nullptr);
-
-				ChatMessage.Username = SenderUsername;
+				ChatMessage.bBits = true;
+				ChatMessage.Bits = static_cast<float>(Bits);
 			}
-
-			//Message
-			if (!ChatMessage.Username.IsEmpty() && messageParts.Num() >= 3)
+			break;
+		}
+		case ETwitchIrcTag::Color:
+			TwitchIrc::ParseColor(Value, ChatMessage.UserColor);
+			break;
+		case ETwitchIrcTag::DisplayName:
+			DisplayName = Value;
+			break;
+		case ETwitchIrcTag::Id:
+			ChatMessage.IdHash = CityHash64(Value.GetData(), Value.Len());
+			break;
+		case ETwitchIrcTag::UserId:
+		{
+			uint64 UserId;
+			if (TwitchIrc::ParseUInt64(Value, UserId))
 			{
-				ChatMessage.Message = messageParts[2];
+				ChatMessage.UserId = static_cast<int64>(UserId);
 			}
-			
-			TwitchMessages.Messages.Add(ChatMessage.Message);
-			TwitchMessages.Usernames.Add(ChatMessage.Username);
-
-			ReceiveMessages(ChatMessage);
+			break;
+		}
+		case ETwitchIrcTag::TmiSentTs:
+		{
+			uint64 SentTimestamp;
+			if (TwitchIrc::ParseUInt64(Value, SentTimestamp))
+			{
+				ChatMessage.SentTimestamp = static_cast<int64>(SentTimestamp);
+			}
+			break;
+		}
+		default:
+			break;
 		}
-		
 	}
 
-	if(TwitchMessages.Messages.Num())
+	// Login, the display name is only a fallback for a missing prefix
+	const FAnsiStringView Nick = IrcMessage.GetNick();
+	const FAnsiStringView Login = Nick.IsEmpty() ? DisplayName : Nick;
+	if (Login.IsEmpty())
 	{
-		ReceivingQueue->Enqueue(TwitchMessages);
+		return;
 	}
-}
+	ChatMessage.Chatter = FTwitchChatterRegistry::Get().Intern(static_cast<uint64>(ChatMessage.UserId), Login, DisplayName, ChatMessage.UserColor);
 
+	if (ActivePoll != nullptr)
+	{
+		ActivePoll->Vote(static_cast<uint64>(ChatMessage.UserId), IrcMessage.Trailing, FPlatformTime::Seconds());
+	}
+
+	// Message, tags and channel text go into the batch slab, "#channel" without the #
+	ChatMessage.Slab = TwitchMessages.Slab;
+	ChatMessage.ReceiveTime = TwitchMessages.ReceiveTime;
+	ChatMessage.Text = TwitchMessages.Slab->Append(IrcMessage.Trailing);
+	ChatMessage.Tags = TwitchMessages.Slab->Append(IrcMessage.Tags);
+	const FAnsiStringView ChannelParam = IrcMessage.GetFirstParam();
+	if (ChannelParam.Len() > 1 && ChannelParam[0] == '#')
+	{
+		const FAnsiStringView ChannelName = ChannelParam.RightChop(1);
+		ChatMessage.Channel = TwitchMessages.Slab->Append(ChannelName);
+		ChatMessage.ChannelHash = CityHash64(ChannelName.GetData(), ChannelName.Len());
+	}
+
+	TwitchMessages.Messages.Add(MoveTemp(ChatMessage));
+}
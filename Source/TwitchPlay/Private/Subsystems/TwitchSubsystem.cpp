@@ -3,29 +3,35 @@
 
 #include "Subsystems/TwitchSubsystem.h"
 
+#include "Chatters/TwitchChatterRegistry.h"
 #include "LogTwitch.h"
-#include "Runnables/TwitchMessageReceiver.h"
+#include "Network/TwitchConnectionPool.h"
+#include "TwitchStats.h"
 
 void UTwitchSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
-	TimeBetweenChatMessages = 1.2f;
-	TwitchMessageReceiver = nullptr;
+	TimeBetweenChatMessages = 0.0f;
+	ConnectionPool = nullptr;
 
 	BoundEvents = TMap<FString, FOnCommandReceived>();
 	OnMessageReceived.AddDynamic(this, &UTwitchSubsystem::MessageReceivedHandler);
+
+	TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UTwitchSubsystem::Tick));
 }
 
 void UTwitchSubsystem::Deinitialize()
 {
-	if(TwitchMessageReceiver.IsValid())
+	FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+
+	if(ConnectionPool.IsValid())
 	{
-		TwitchMessageReceiver->StopConnection(true);
+		ConnectionPool->StopConnection(true);
 	}
 }
 
 void UTwitchSubsystem::Connect(const FString& OAuth, const FString& Username, const FString& Channel)
 {
-	if(TwitchMessageReceiver.IsValid())
+	if(ConnectionPool.IsValid())
 	{
 		OnConnectionMessage.Broadcast(ETwitchConnectionMessageType::ERROR, TEXT("Already connected / connecting / pending!"));
 		FLogTwitchPlay::Warning("UTwitchSubsystem::Connect  Already connected / connecting / pending!");
@@ -39,39 +45,87 @@ void UTwitchSubsystem::Connect(const FString& OAuth, const FString& Username, co
 	}
 
 	// Create the connection and messaging thread
-	TwitchMessageReceiver = MakeUnique<FTwitchMessageReceiver>();
-	TwitchMessageReceiver->StartConnection(OAuth, Username, Channel, TimeBetweenChatMessages);
+	ConnectionPool = MakeUnique<FTwitchConnectionPool>();
+	bReplaying = false;
+	ConnectionPool->StartConnection(OAuth, Username, Channel, TimeBetweenChatMessages, NumConnections, MakeReceiverSettings());
 
-	
-	TwitchMessageReceiver->ReceiveMessages = [&](const FTwitchChatMessage& Messages)
+	if(bPollRunning)
 	{
-		OnMessageReceived.Broadcast(Messages);
-	};
+		ConnectionPool->SetPoll(Poll);
+	}
+}
 
-	TwitchMessageReceiver->ReceiveConnections = [&](const FTwitchConnection& Connection)
+void UTwitchSubsystem::StartReplay(const FString& CaptureFile, const float Speed)
+{
+	if(ConnectionPool.IsValid())
 	{
-		OnConnectionMessage.Broadcast(Connection.Type,Connection.Message);
-	};
+		OnConnectionMessage.Broadcast(ETwitchConnectionMessageType::ERROR, TEXT("Already connected / connecting / pending!"));
+		FLogTwitchPlay::Warning("UTwitchSubsystem::StartReplay  Already connected / connecting / pending!");
+		return;
+	}
+
+	ConnectionPool = MakeUnique<FTwitchConnectionPool>();
+	bReplaying = true;
+	ConnectionPool->StartReplay(CaptureFile, Speed, MakeReceiverSettings());
+
+	if(bPollRunning)
+	{
+		ConnectionPool->SetPoll(Poll);
+	}
+}
+
+bool UTwitchSubsystem::StartCapture(const FString& CaptureFile)
+{
+	return ConnectionPool.IsValid() && ConnectionPool->StartCapture(CaptureFile);
 }
 
-bool UTwitchSubsystem::SendChatMessage(const FString& Message, const FString Channel)
+void UTwitchSubsystem::StopCapture()
 {
-	if(TwitchMessageReceiver.IsValid())
+	if(ConnectionPool.IsValid())
 	{
-		TwitchMessageReceiver->SendMessage(ETwitchSendMessageType::CHAT_MESSAGE, Message, Channel);
-		return true;
+		ConnectionPool->StopCapture();
+	}
+}
+
+bool UTwitchSubsystem::IsCapturing() const
+{
+	return ConnectionPool.IsValid() && ConnectionPool->IsCapturing();
+}
+
+FTwitchReceiverSettings UTwitchSubsystem::MakeReceiverSettings() const
+{
+	FTwitchReceiverSettings Settings;
+	Settings.MaxQueuedMessages = MaxQueuedMessages;
+	Settings.OverflowPolicy = QueueOverflowPolicy;
+	Settings.bEchoServerMessages = bEchoServerMessages;
+	Settings.RateLimits = RateLimits;
+	Settings.bAutoReconnect = bAutoReconnect;
+	Settings.ReconnectMaxDelaySeconds = ReconnectMaxDelaySeconds;
+	Settings.MaxReconnectAttempts = MaxReconnectAttempts;
+	Settings.ServerHost = ServerHost;
+	Settings.ServerPort = ServerPort;
+	Settings.ConnectTimeoutSeconds = ConnectTimeoutSeconds;
+	Settings.ConnectAttemptDelaySeconds = ConnectAttemptDelaySeconds;
+	Settings.MaxPendingSendBytes = MaxPendingSendBytes;
+	return Settings;
+}
+
+bool UTwitchSubsystem::SendChatMessage(const FString& Message, const FString Channel, const ETwitchMessagePriority Priority)
+{
+	if(ConnectionPool.IsValid())
+	{
+		return ConnectionPool->SendMessage(ETwitchSendMessageType::CHAT_MESSAGE, Message, Channel, Priority);
 	}
 
 	return false;
 }
 
-bool UTwitchSubsystem::SendWhisper(const FString& Username, const FString& Message, const FString Channel)
+bool UTwitchSubsystem::SendWhisper(const FString& Username, const FString& Message, const FString Channel, const ETwitchMessagePriority Priority)
 {
-	if(TwitchMessageReceiver.IsValid())
+	if(ConnectionPool.IsValid())
 	{
 		const FString whisperMessage = FString::Printf(TEXT("/w %s %s"), *Username, *Message);
-		TwitchMessageReceiver->SendMessage(ETwitchSendMessageType::CHAT_MESSAGE, whisperMessage, Channel);
-		return true;
+		return ConnectionPool->SendMessage(ETwitchSendMessageType::CHAT_MESSAGE, whisperMessage, Channel, Priority);
 	}
 
 	return false;
@@ -79,52 +133,215 @@ bool UTwitchSubsystem::SendWhisper(const FString& Username, const FString& Messa
 
 void UTwitchSubsystem::JoinChannel(const FString& Channel)
 {
-	if(!TwitchMessageReceiver.IsValid())
+	if(!ConnectionPool.IsValid())
+	{
+		return;
+	}
+
+	ConnectionPool->JoinChannels({Channel});
+}
+
+void UTwitchSubsystem::JoinChannels(const TArray<FString>& Channels)
+{
+	if(!ConnectionPool.IsValid())
+	{
+		return;
+	}
+
+	ConnectionPool->JoinChannels(Channels);
+}
+
+void UTwitchSubsystem::LeaveChannel(const FString& Channel)
+{
+	if(!ConnectionPool.IsValid())
 	{
 		return;
 	}
 
-	TwitchMessageReceiver->SendMessage(ETwitchSendMessageType::JOIN_MESSAGE, TEXT(""), Channel);
+	ConnectionPool->LeaveChannels({Channel});
+}
+
+TArray<FString> UTwitchSubsystem::GetJoinedChannels() const
+{
+	return ConnectionPool.IsValid() ? ConnectionPool->GetJoinedChannels() : TArray<FString>();
 }
 
 void UTwitchSubsystem::Disconnect()
 {
-	if(!TwitchMessageReceiver.IsValid())
+	if(!ConnectionPool.IsValid())
 	{
 		return;
 	}
 	
-	TwitchMessageReceiver->StopConnection(false);
+	ConnectionPool->StopConnection(false);
 }
 
 bool UTwitchSubsystem::IsConnected() const
 {
-	return TwitchMessageReceiver.IsValid() && TwitchMessageReceiver->IsConnected();
+	return ConnectionPool.IsValid() && ConnectionPool->IsConnected();
 }
 
 bool UTwitchSubsystem::IsPendingConnection() const
 {
-	return TwitchMessageReceiver.IsValid() && !TwitchMessageReceiver->IsConnected();
+	return ConnectionPool.IsValid() && !ConnectionPool->IsConnected();
 }
 
 bool UTwitchSubsystem::GetConnectionInfo(FString& OutOAuth, FString& OutUsername, FString& OutChannel) const
 {
-	if(!TwitchMessageReceiver.IsValid())
+	if(!ConnectionPool.IsValid())
 	{
 		return false;
 	}
 
-	TwitchMessageReceiver->GetConnectionInfo(OutOAuth, OutUsername, OutChannel);
+	ConnectionPool->GetConnectionInfo(OutOAuth, OutUsername, OutChannel);
 	return true;
 }
 
+int64 UTwitchSubsystem::GetDroppedMessageCount() const
+{
+	return ConnectionPool.IsValid() ? ConnectionPool->GetNumDroppedMessages() : 0;
+}
+
+bool UTwitchSubsystem::StartPoll(const TArray<FString>& Options, const float DurationSeconds, const bool bAllowVoteChange)
+{
+	TSharedPtr<FTwitchPoll, ESPMode::ThreadSafe> NewPoll = MakeShared<FTwitchPoll, ESPMode::ThreadSafe>(Options, DurationSeconds, bAllowVoteChange);
+
+	FTwitchPollResults Results;
+	NewPoll->GetResults(FPlatformTime::Seconds(), Results);
+	if(Results.Options.Num() == 0)
+	{
+		FLogTwitchPlay::Warning("UTwitchSubsystem::StartPoll  A poll needs at least one option");
+		return false;
+	}
+
+	if(bPollRunning)
+	{
+		Poll->Close();
+		FinishPoll(FPlatformTime::Seconds());
+	}
+
+	Poll = NewPoll;
+	bPollRunning = true;
+	if(ConnectionPool.IsValid())
+	{
+		ConnectionPool->SetPoll(Poll);
+	}
+	return true;
+}
+
+void UTwitchSubsystem::EndPoll()
+{
+	if(bPollRunning)
+	{
+		Poll->Close();
+	}
+}
+
+bool UTwitchSubsystem::IsPollOpen() const
+{
+	return bPollRunning && Poll->IsOpen(FPlatformTime::Seconds());
+}
+
+bool UTwitchSubsystem::GetPollResults(FTwitchPollResults& OutResults) const
+{
+	if(!Poll.IsValid())
+	{
+		return false;
+	}
+
+	Poll->GetResults(FPlatformTime::Seconds(), OutResults);
+	return true;
+}
+
+TArray<FTwitchEmoteCount> UTwitchSubsystem::GetTopEmotes(const int32 Count) const
+{
+	TArray<FTwitchEmoteCount> TopEmotes;
+	EmoteCounter.GetTop(Count, TopEmotes);
+	return TopEmotes;
+}
+
+void UTwitchSubsystem::ResetEmoteCounts()
+{
+	EmoteCounter.Reset();
+}
+
+FTwitchChatLatency UTwitchSubsystem::GetChatLatency() const
+{
+	FTwitchChatLatency Latency;
+	TwitchLatency.GetPercentiles(Latency.Twitch);
+	ParseLatency.GetPercentiles(Latency.Parse);
+	DispatchLatency.GetPercentiles(Latency.Dispatch);
+	TotalLatency.GetPercentiles(Latency.Total);
+	return Latency;
+}
+
+void UTwitchSubsystem::ResetChatLatency()
+{
+	TwitchLatency.Reset();
+	ParseLatency.Reset();
+	DispatchLatency.Reset();
+	TotalLatency.Reset();
+}
+
+void UTwitchSubsystem::FinishPoll(const double Now)
+{
+	bPollRunning = false;
+	if(ConnectionPool.IsValid())
+	{
+		ConnectionPool->SetPoll(nullptr);
+	}
+
+	Poll->GetResults(Now, PollResults);
+	OnPollEnded.Broadcast(PollResults);
+}
+
+float UTwitchSubsystem::GetLastReconnectSeconds() const
+{
+	return ConnectionPool.IsValid() ? static_cast<float>(ConnectionPool->GetLastRecoverySeconds()) : 0.0f;
+}
+
+FTwitchPipelineStats UTwitchSubsystem::GetPipelineStats() const
+{
+	return ConnectionPool.IsValid() ? ConnectionPool->GetPipelineStats() : FTwitchPipelineStats();
+}
+
 void UTwitchSubsystem::SetupEncapsulationChars(const FString& CommandChar, const FString& OptionsChar)
 {
 	CommandEncapsulationChar = CommandChar;
 	OptionsEncapsulationChar = OptionsChar;
+	CommandDispatcher.Invalidate();
+}
+
+void UTwitchSubsystem::SetCommandsCaseSensitive(const bool bCaseSensitive)
+{
+	bCaseSensitiveCommands = bCaseSensitive;
+	CommandDispatcher.Invalidate();
+}
+
+void UTwitchSubsystem::RegisterCommandAlias(const FString& Alias, const FString& CommandName)
+{
+	if (Alias.IsEmpty() || CommandName.IsEmpty())
+	{
+		FLogTwitchPlay::Warning("UTwitchSubsystem::RegisterCommandAlias  Alias or command string is invalid");
+		return;
+	}
+
+	CommandAliases.Add(Alias, CommandName);
+	CommandDispatcher.Invalidate();
+}
+
+bool UTwitchSubsystem::UnregisterCommandAlias(const FString& Alias)
+{
+	if (!CommandAliases.Remove(Alias))
+	{
+		return false;
+	}
+
+	CommandDispatcher.Invalidate();
+	return true;
 }
 
-bool UTwitchSubsystem::RegisterCommand(const FString& CommandName, const FOnCommandReceived& Callback)
+bool UTwitchSubsystem::RegisterCommand(const FString& CommandName, const FOnCommandReceived& Callback, const FString& Channel)
 {
 	// No reason to register an empty command
 	if (CommandName.IsEmpty())
@@ -135,7 +352,8 @@ bool UTwitchSubsystem::RegisterCommand(const FString& CommandName, const FOnComm
 
 	// Pointer to the command in the event map, if present
 	// If the command is found I can use this to switch from the previous function and bind the new one
-	FOnCommandReceived* RegisteredCommand = BoundEvents.Find(CommandName);
+	TMap<FString, FOnCommandReceived>& CommandEvents = Channel.IsEmpty() ? BoundEvents : ChannelBoundEvents.FindOrAdd(FTwitchMessageReceiver::NormalizeChannel(Channel)).BoundEvents;
+	FOnCommandReceived* RegisteredCommand = CommandEvents.Find(CommandName);
 
 	// If the command we want to register is already in the event map 
 	// copy the new delegate object info into it   
@@ -143,19 +361,20 @@ bool UTwitchSubsystem::RegisterCommand(const FString& CommandName, const FOnComm
 	if (RegisteredCommand)
 	{
 		*RegisteredCommand = Callback;
-		FLogTwitchPlay::Info("UTwitchSubsystem::RegisterCommand  " + CommandName + " command registered. It overwrote a previous registration of the same type");
+		FLogTwitchPlay::Infof(TEXT("UTwitchSubsystem::RegisterCommand  %s command registered. It overwrote a previous registration of the same type"), *CommandName);
 	}
 	else
 	{
 		// If the command is not registered yet create a new entry for it
 		// and copy the incoming delegate object info to the new delegate object
-		BoundEvents.Add(CommandName, Callback);
-		FLogTwitchPlay::Info("UTwitchSubsystem::RegisterCommand  " + CommandName + " command registered");
+		CommandEvents.Add(CommandName, Callback);
+		FLogTwitchPlay::Infof(TEXT("UTwitchSubsystem::RegisterCommand  %s command registered"), *CommandName);
+		CommandDispatcher.Invalidate();
 	}
 	return true;
 }
 
-bool UTwitchSubsystem::UnregisterCommand(const FString& CommandName)
+bool UTwitchSubsystem::UnregisterCommand(const FString& CommandName, const FString& Channel)
 {
 	// No reason to unregister an empty command 
 	if (CommandName.IsEmpty())
@@ -164,12 +383,20 @@ bool UTwitchSubsystem::UnregisterCommand(const FString& CommandName)
 		return false;
 	}
 
-	if (!BoundEvents.Remove(CommandName))
+	TMap<FString, FOnCommandReceived>* CommandEvents = &BoundEvents;
+	if (!Channel.IsEmpty())
+	{
+		FTwitchChannelCommands* ChannelCommands = ChannelBoundEvents.Find(FTwitchMessageReceiver::NormalizeChannel(Channel));
+		CommandEvents = ChannelCommands != nullptr ? &ChannelCommands->BoundEvents : nullptr;
+	}
+
+	if (CommandEvents == nullptr || !CommandEvents->Remove(CommandName))
 	{
 		FLogTwitchPlay::Warning("UTwitchSubsystem::UnregisterCommand  No command of this type was registered");
 		return false;
 	}
 	
+	CommandDispatcher.Invalidate();
 	return true;
 }
 
@@ -179,6 +406,9 @@ void UTwitchSubsystem::UnregisterAllCommands()
 	{
 		UnregisterCommand(CommandName);
 	}
+
+	ChannelBoundEvents.Empty();
+	CommandDispatcher.Invalidate();
 }
 
 TArray<FString> UTwitchSubsystem::GetAllCommandNames() const
@@ -188,26 +418,90 @@ TArray<FString> UTwitchSubsystem::GetAllCommandNames() const
 	return Keys;
 }
 
-void UTwitchSubsystem::MessageReceivedHandler(const FTwitchChatMessage& Message)
+TArray<FString> UTwitchSubsystem::GetChannelCommandNames(const FString& Channel) const
+{
+	TArray<FString> Keys;
+	if (const FTwitchChannelCommands* ChannelCommands = ChannelBoundEvents.Find(FTwitchMessageReceiver::NormalizeChannel(Channel)))
+	{
+		ChannelCommands->BoundEvents.GetKeys(Keys);
+	}
+	return Keys;
+}
+
+bool UTwitchSubsystem::Tick(float DeltaTime)
 {
-	const FString Command = GetCommandString(Message.Message);
+	// Poll results are published once per frame, however many votes came in
+	if(bPollRunning)
+	{
+		const double Now = FPlatformTime::Seconds();
+		if(Poll->ConsumeResults(Now, PollResults))
+		{
+			OnPollUpdated.Broadcast(PollResults);
+		}
+
+		if(!Poll->IsOpen(Now))
+		{
+			FinishPoll(Now);
+		}
+	}
 
-	// No reason to search for the command in the event map, there isn't any
-	if (Command.IsEmpty())
+	if(!ConnectionPool.IsValid())
 	{
-		return;
+		return true;
+	}
+
+	ETwitchConnectionMessageType ConnectionType;
+	FString ConnectionMessage;
+	while(ConnectionPool->PullConnectionMessage(ConnectionType, ConnectionMessage))
+	{
+		OnConnectionMessage.Broadcast(ConnectionType, ConnectionMessage);
 	}
 
-	FOnCommandReceived* RegisteredCommand = BoundEvents.Find(Command);
+	// Everything that arrived since the last frame is delivered in one pass
+	TWITCHPLAY_SCOPE("Dispatch", STAT_TwitchPlay_Dispatch);
+	SET_DWORD_STAT(STAT_TwitchPlay_ReceiveQueueDepth, ConnectionPool->GetReceiveQueueDepth());
+	ConnectionPool->PullMessages(ReceivedMessages);
+	SET_DWORD_STAT(STAT_TwitchPlay_MessagesDropped, ConnectionPool->GetNumDroppedMessages());
+	INC_DWORD_STAT_BY(STAT_TwitchPlay_MessagesDelivered, ReceivedMessages.Num());
 
-	// If the command was registered proceed with finding any command options
-	// Then fire the event
-	if (RegisteredCommand != nullptr)
+	// tmi-sent-ts is Unix time in milliseconds, the other stamps are platform time
+	const double PlatformToUnixMilliseconds = (FDateTime::UtcNow() - FDateTime(1970, 1, 1)).GetTotalMilliseconds() - FPlatformTime::Seconds() * 1000.0;
+
+	for(const FTwitchReceivedMessage& Message : ReceivedMessages)
 	{
-		TArray<FString> CommandOptions;
-		GetCommandOptionsStrings(Message.Message, CommandOptions);
-		RegisteredCommand->ExecuteIfBound(Command, CommandOptions, Message.Username);
+		const double HandleTime = FPlatformTime::Seconds();
+		ParseLatency.RecordSeconds(Message.ParseTime - Message.ReceiveTime);
+		DispatchLatency.RecordSeconds(HandleTime - Message.ParseTime);
+		if(Message.SentTimestamp > 0 && !bReplaying)
+		{
+			TwitchLatency.Record(static_cast<int64>((Message.ReceiveTime * 1000.0 + PlatformToUnixMilliseconds - Message.SentTimestamp) * 1000.0));
+			TotalLatency.Record(static_cast<int64>((HandleTime * 1000.0 + PlatformToUnixMilliseconds - Message.SentTimestamp) * 1000.0));
+		}
+
+		Message.ToChatMessage(DeliveredMessage);
+		FTwitchChatterRegistry::Get().CopyLogin(DeliveredMessage.Chatter, DeliveredMessage.Username);
+
+		if(bCountEmotes)
+		{
+			DeliveredMessage.Tags.GetEmotes(DeliveredMessage.Message, EmoteRanges);
+			for(const FTwitchEmoteRange& Emote : EmoteRanges)
+			{
+				EmoteCounter.Add(Emote.Id, FStringView(*DeliveredMessage.Message + Emote.Start, Emote.End - Emote.Start + 1));
+			}
+		}
+
+		OnMessageReceived.Broadcast(DeliveredMessage);
 	}
+
+	// Gives the text slabs back to the receivers
+	ReceivedMessages.Reset();
+
+	return true;
+}
+
+void UTwitchSubsystem::MessageReceivedHandler(const FTwitchChatMessage& Message)
+{
+	CommandDispatcher.Dispatch(Message, CommandEncapsulationChar, OptionsEncapsulationChar, bCaseSensitiveCommands, CommandCooldowns);
 }
 
 FString UTwitchSubsystem::GetDelimitedString(const FString& InString, const FString& Delimiter)
@@ -245,15 +539,103 @@ FString UTwitchSubsystem::GetDelimitedString(const FString& InString, const FStr
 	return InString.Mid(CommandStartIndex + Delimiter.Len(), CommandEndIndex - (CommandStartIndex + Delimiter.Len()));
 }
 
-FString UTwitchSubsystem::GetCommandString(const FString& Message) const
-{
-	// Only the first command is accepted
-	FString RetCommand = GetDelimitedString(Message, CommandEncapsulationChar);
-	return RetCommand;
-}
-
 void UTwitchSubsystem::GetCommandOptionsStrings(const FString& Message, TArray<FString>& OutOptions) const
 {
 	const FString Options = GetDelimitedString(Message, OptionsEncapsulationChar);
 	Options.ParseIntoArray(OutOptions, TEXT(","));
 }
+
+FTwitchCommandDispatcher::FTwitchCommandDispatcher(const TMap<FString, FOnCommandReceived>& InBoundEvents, const TMap<FString, FTwitchChannelCommands>& InChannelBoundEvents, const TMap<FString, FString>& InCommandAliases)
+	: BoundEvents(InBoundEvents)
+	, ChannelBoundEvents(InChannelBoundEvents)
+	, CommandAliases(InCommandAliases)
+	, bMatcherDirty(true)
+{
+}
+
+bool FTwitchCommandDispatcher::Dispatch(const FTwitchChatMessage& Message, const FString& CommandDelimiter, const FString& OptionsDelimiter, const bool bCaseSensitive, const FTwitchCommandCooldowns& Cooldowns)
+{
+	if (bMatcherDirty)
+	{
+		RebuildMatcher(CommandDelimiter, bCaseSensitive);
+	}
+
+	// Most messages are not commands, they stop here without allocating
+	const int32 CommandIndex = CommandMatcher.Match(Message.Message);
+	if (CommandIndex == INDEX_NONE)
+	{
+		return false;
+	}
+	const FString& Command = MatcherCommandNames[CommandIndex];
+
+	// Commands registered for the message channel come first
+	const FOnCommandReceived* RegisteredCommand = nullptr;
+	if (const FTwitchChannelCommands* ChannelCommands = ChannelBoundEvents.Find(Message.Channel))
+	{
+		RegisteredCommand = ChannelCommands->BoundEvents.Find(Command);
+	}
+	if (RegisteredCommand == nullptr)
+	{
+		RegisteredCommand = BoundEvents.Find(Command);
+	}
+
+	// If the command was registered and is not cooling down proceed with finding any command options
+	// Then fire the event
+	if (RegisteredCommand == nullptr || !CooldownFilter.TryPass(Message.UserId, CommandIndex, Cooldowns, FPlatformTime::Seconds()))
+	{
+		return false;
+	}
+
+	TArray<FString> CommandOptions;
+	UTwitchSubsystem::GetDelimitedString(Message.Message, OptionsDelimiter).ParseIntoArray(CommandOptions, TEXT(","));
+	RegisteredCommand->ExecuteIfBound(Command, CommandOptions, Message.Username);
+	return true;
+}
+
+void FTwitchCommandDispatcher::RebuildMatcher(const FString& CommandDelimiter, const bool bCaseSensitive)
+{
+	// Every registered name, for all channels or a single one. Which callback fires is decided per message
+	// Names keep the index they had, so the cooldowns running for them carry over
+	TArray<FString> Names;
+	TArray<int32> CommandIndices;
+	auto AddCommand = [this, &Names, &CommandIndices](const FString& CommandName)
+	{
+		int32 CommandIndex = MatcherCommandNames.IndexOfByKey(CommandName);
+		if (CommandIndex == INDEX_NONE)
+		{
+			CommandIndex = MatcherCommandNames.Add(CommandName);
+		}
+		if (!CommandIndices.Contains(CommandIndex))
+		{
+			Names.Add(CommandName);
+			CommandIndices.Add(CommandIndex);
+		}
+	};
+
+	for (const TPair<FString, FOnCommandReceived>& BoundEvent : BoundEvents)
+	{
+		AddCommand(BoundEvent.Key);
+	}
+	for (const TPair<FString, FTwitchChannelCommands>& ChannelCommands : ChannelBoundEvents)
+	{
+		for (const TPair<FString, FOnCommandReceived>& BoundEvent : ChannelCommands.Value.BoundEvents)
+		{
+			AddCommand(BoundEvent.Key);
+		}
+	}
+
+	// Aliases of unregistered commands match nothing
+	for (const TPair<FString, FString>& Alias : CommandAliases)
+	{
+		const int32 CommandIndex = MatcherCommandNames.IndexOfByKey(Alias.Value);
+		if (CommandIndex != INDEX_NONE && CommandIndices.Contains(CommandIndex))
+		{
+			Names.Add(Alias.Key);
+			CommandIndices.Add(CommandIndex);
+		}
+	}
+
+	CommandMatcher.Build(Names, CommandIndices, CommandDelimiter, bCaseSensitive);
+	CooldownFilter.SetNumCommands(MatcherCommandNames.Num());
+	bMatcherDirty = false;
+}
@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Parsing/TwitchCommandMatcher.h"
+
+namespace
+{
+	// "jump" and its alias "hop" share index 0
+	void BuildCommands(FTwitchCommandMatcher& Matcher, const FString& Delimiter, const bool bCaseSensitive)
+	{
+		Matcher.Build({TEXT("jump"), TEXT("jumping"), TEXT("Fly"), TEXT("hop"), TEXT("a!b")}, {0, 1, 2, 0, 3}, Delimiter, bCaseSensitive);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTwitchCommandMatcherTest, "TwitchPlay.Parsing.CommandMatcher.Match", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTwitchCommandMatcherTest::RunTest(const FString& Parameters)
+{
+	FTwitchCommandMatcher Matcher;
+	TestTrue(TEXT("Empty before the first build"), Matcher.IsEmpty());
+	TestEqual(TEXT("Nothing to match"), Matcher.Match(TEXT("!jump!")), INDEX_NONE);
+
+	BuildCommands(Matcher, TEXT("!"), false);
+	TestEqual(TEXT("Command"), Matcher.Match(TEXT("!jump!")), 0);
+	TestEqual(TEXT("Alias"), Matcher.Match(TEXT("!hop!")), 0);
+	TestEqual(TEXT("Longer command sharing a prefix"), Matcher.Match(TEXT("!jumping!")), 1);
+	TestEqual(TEXT("Prefix of a command"), Matcher.Match(TEXT("!jum!")), INDEX_NONE);
+	TestEqual(TEXT("Between two commands"), Matcher.Match(TEXT("!jumpi!")), INDEX_NONE);
+	TestEqual(TEXT("Past a command"), Matcher.Match(TEXT("!jumpx!")), INDEX_NONE);
+	TestEqual(TEXT("Case ignored"), Matcher.Match(TEXT("!JUMP!")), 0);
+	TestEqual(TEXT("Name folded too"), Matcher.Match(TEXT("!fly!")), 2);
+	TestEqual(TEXT("Text around the command"), Matcher.Match(TEXT("go !jump! now")), 0);
+	TestEqual(TEXT("No closing delimiter"), Matcher.Match(TEXT("!jump")), INDEX_NONE);
+	TestEqual(TEXT("Only the first delimited string"), Matcher.Match(TEXT("!nope! !jump!")), INDEX_NONE);
+	TestEqual(TEXT("No delimiter"), Matcher.Match(TEXT("jump")), INDEX_NONE);
+	TestEqual(TEXT("Name containing the delimiter skipped"), Matcher.Match(TEXT("!a!b!")), INDEX_NONE);
+
+	BuildCommands(Matcher, TEXT("!"), true);
+	TestEqual(TEXT("Case sensitive"), Matcher.Match(TEXT("!jump!")), 0);
+	TestEqual(TEXT("Case sensitive, other case"), Matcher.Match(TEXT("!JUMP!")), INDEX_NONE);
+	TestEqual(TEXT("Case sensitive, name case"), Matcher.Match(TEXT("!Fly!")), 2);
+	TestEqual(TEXT("Case sensitive, name in lowercase"), Matcher.Match(TEXT("!fly!")), INDEX_NONE);
+
+	BuildCommands(Matcher, TEXT("::"), false);
+	TestEqual(TEXT("Multi character delimiter"), Matcher.Match(TEXT("say ::Jumping:: now")), 1);
+	TestEqual(TEXT("Half a delimiter"), Matcher.Match(TEXT(":jump:")), INDEX_NONE);
+	TestEqual(TEXT("Name with a delimiter character"), Matcher.Match(TEXT("::a!b::")), 3);
+
+	// Names equal once folded, the first one wins
+	Matcher.Build({TEXT("Jump"), TEXT("jump")}, {5, 6}, TEXT("!"), false);
+	TestEqual(TEXT("First of the folded duplicates"), Matcher.Match(TEXT("!jump!")), 5);
+
+	Matcher.Build({}, {}, TEXT("!"), false);
+	TestTrue(TEXT("Rebuilt empty"), Matcher.IsEmpty());
+	TestEqual(TEXT("Nothing left to match"), Matcher.Match(TEXT("!jump!")), INDEX_NONE);
+
+	return true;
+}
+
+#endif
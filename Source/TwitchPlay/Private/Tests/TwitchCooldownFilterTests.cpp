@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Data/TwitchCooldownFilter.h"
+
+namespace
+{
+	FTwitchCommandCooldowns MakeCooldowns(const float User, const float Command, const float Global)
+	{
+		FTwitchCommandCooldowns Cooldowns;
+		Cooldowns.UserCooldownSeconds = User;
+		Cooldowns.CommandCooldownSeconds = Command;
+		Cooldowns.GlobalCooldownSeconds = Global;
+		return Cooldowns;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTwitchCooldownFilterSharedTest, "TwitchPlay.Data.CooldownFilter.Shared", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTwitchCooldownFilterSharedTest::RunTest(const FString& Parameters)
+{
+	{
+		FTwitchCooldownFilter Filter(64);
+		Filter.Reset(2);
+		const double Start = FPlatformTime::Seconds();
+		const FTwitchCommandCooldowns Cooldowns = MakeCooldowns(0.0f, 5.0f, 0.0f);
+		TestTrue(TEXT("Command"), Filter.TryPass(1, 0, Cooldowns, Start));
+		TestFalse(TEXT("Command cooling down for everyone"), Filter.TryPass(2, 0, Cooldowns, Start + 1.0));
+		TestTrue(TEXT("Other command"), Filter.TryPass(2, 1, Cooldowns, Start + 1.0));
+		TestTrue(TEXT("Command cooled down"), Filter.TryPass(2, 0, Cooldowns, Start + 5.5));
+
+		// Commands added later start ready
+		Filter.SetNumCommands(3);
+		TestTrue(TEXT("New command"), Filter.TryPass(2, 2, Cooldowns, Start + 5.5));
+		TestFalse(TEXT("Running cooldowns kept"), Filter.TryPass(3, 0, Cooldowns, Start + 6.0));
+	}
+
+	{
+		FTwitchCooldownFilter Filter(64);
+		Filter.Reset(2);
+		const double Start = FPlatformTime::Seconds();
+		const FTwitchCommandCooldowns Cooldowns = MakeCooldowns(0.0f, 0.0f, 2.0f);
+		TestTrue(TEXT("Global"), Filter.TryPass(1, 0, Cooldowns, Start));
+		TestFalse(TEXT("Any command cooling down"), Filter.TryPass(2, 1, Cooldowns, Start + 1.0));
+		TestTrue(TEXT("Global cooled down"), Filter.TryPass(2, 1, Cooldowns, Start + 2.5));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTwitchCooldownFilterUserTest, "TwitchPlay.Data.CooldownFilter.User", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTwitchCooldownFilterUserTest::RunTest(const FString& Parameters)
+{
+	{
+		FTwitchCooldownFilter Filter(64);
+		Filter.Reset(2);
+		const double Start = FPlatformTime::Seconds();
+
+		// 1 s stays in the first wheel level, 10 s starts in the second, 1000 s in the third
+		const FTwitchCommandCooldowns Short = MakeCooldowns(1.0f, 0.0f, 0.0f);
+		const FTwitchCommandCooldowns Medium = MakeCooldowns(10.0f, 0.0f, 0.0f);
+		const FTwitchCommandCooldowns Long = MakeCooldowns(1000.0f, 0.0f, 0.0f);
+
+		TestTrue(TEXT("Short"), Filter.TryPass(7, 0, Short, Start));
+		TestTrue(TEXT("Medium"), Filter.TryPass(8, 0, Medium, Start));
+		TestTrue(TEXT("Long"), Filter.TryPass(9, 0, Long, Start));
+		TestTrue(TEXT("No user id, no user cooldown"), Filter.TryPass(0, 0, Short, Start));
+		TestTrue(TEXT("No user id again"), Filter.TryPass(0, 0, Short, Start));
+		TestEqual(TEXT("Running"), Filter.Num(), 3);
+
+		TestFalse(TEXT("Short cooling down"), Filter.TryPass(7, 0, Short, Start + 0.5));
+		TestTrue(TEXT("Same user, other command"), Filter.TryPass(7, 1, Short, Start + 0.5));
+		TestTrue(TEXT("Short cooled down"), Filter.TryPass(7, 0, Short, Start + 1.6));
+
+		TestFalse(TEXT("Medium cooling down"), Filter.TryPass(8, 0, Medium, Start + 9.5));
+		TestTrue(TEXT("Medium cooled down"), Filter.TryPass(8, 0, Medium, Start + 10.5));
+
+		// Cascaded down two levels on the way
+		TestFalse(TEXT("Long cooling down"), Filter.TryPass(9, 0, Long, Start + 600.0));
+		TestFalse(TEXT("Long almost cooled down"), Filter.TryPass(9, 0, Long, Start + 999.5));
+		TestTrue(TEXT("Long cooled down"), Filter.TryPass(9, 0, Long, Start + 1000.5));
+		TestEqual(TEXT("Expired entries freed"), Filter.Num(), 1);
+	}
+
+	{
+		// A stall longer than the second level skips the tick by tick walk
+		FTwitchCooldownFilter Filter(64);
+		Filter.Reset(1);
+		const double Start = FPlatformTime::Seconds();
+		const FTwitchCommandCooldowns Short = MakeCooldowns(1.0f, 0.0f, 0.0f);
+		const FTwitchCommandCooldowns Long = MakeCooldowns(2000.0f, 0.0f, 0.0f);
+
+		TestTrue(TEXT("Short before the stall"), Filter.TryPass(1, 0, Short, Start));
+		TestTrue(TEXT("Long before the stall"), Filter.TryPass(2, 0, Long, Start));
+		TestTrue(TEXT("Short expired during the stall"), Filter.TryPass(1, 0, Short, Start + 700.0));
+		TestFalse(TEXT("Long kept through the stall"), Filter.TryPass(2, 0, Long, Start + 700.0));
+		TestFalse(TEXT("Long kept through a second stall"), Filter.TryPass(2, 0, Long, Start + 1999.5));
+		TestTrue(TEXT("Long expired on time once rescheduled"), Filter.TryPass(2, 0, Long, Start + 2000.5));
+		TestEqual(TEXT("Only the new cooldown left"), Filter.Num(), 1);
+	}
+
+	{
+		// A full table lets the commands of new users through rather than growing
+		FTwitchCooldownFilter Filter(2);
+		Filter.Reset(1);
+		const double Start = FPlatformTime::Seconds();
+		const FTwitchCommandCooldowns Short = MakeCooldowns(1.0f, 0.0f, 0.0f);
+		TestTrue(TEXT("First user"), Filter.TryPass(1, 0, Short, Start));
+		TestTrue(TEXT("Second user"), Filter.TryPass(2, 0, Short, Start));
+		TestTrue(TEXT("Third user, not recorded"), Filter.TryPass(3, 0, Short, Start));
+		TestTrue(TEXT("Third user again"), Filter.TryPass(3, 0, Short, Start + 0.5));
+		TestFalse(TEXT("Recorded user"), Filter.TryPass(1, 0, Short, Start + 0.5));
+		TestEqual(TEXT("Table full"), Filter.Num(), 2);
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,132 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Parsing/TwitchIrcMessage.h"
+
+namespace
+{
+	FString ToString(const FAnsiStringView& View)
+	{
+		return FString(View.Len(), View.GetData());
+	}
+
+	// The tags of a tag block as "key=value", joined by '|'. Values are raw
+	FString ListTags(const FAnsiStringView& Tags)
+	{
+		TArray<FString> Pairs;
+		FTwitchIrcTagIterator Iterator(Tags);
+		FAnsiStringView Key;
+		FAnsiStringView Value;
+		while (Iterator.Next(Key, Value))
+		{
+			Pairs.Add(ToString(Key) + TEXT("=") + ToString(Value));
+		}
+		return FString::Join(Pairs, TEXT("|"));
+	}
+
+	FString Unescape(const ANSICHAR* Value)
+	{
+		FString Result;
+		TwitchIrc::UnescapeTagValue(FAnsiStringView(Value), Result);
+		return Result;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTwitchIrcMessageParseTest, "TwitchPlay.Parsing.IrcMessage.Parse", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTwitchIrcMessageParseTest::RunTest(const FString& Parameters)
+{
+	FTwitchIrcMessage Message;
+
+	if (TestTrue(TEXT("Tagged PRIVMSG"), FTwitchIrcMessage::Parse("@badges=broadcaster/1;display-name=Foo\\sBar :foo!foo@foo.tmi.twitch.tv PRIVMSG #chan :hello :) world", Message)))
+	{
+		TestEqual(TEXT("Tags"), ToString(Message.Tags), FString(TEXT("badges=broadcaster/1;display-name=Foo\\sBar")));
+		TestEqual(TEXT("Prefix"), ToString(Message.Prefix), FString(TEXT("foo!foo@foo.tmi.twitch.tv")));
+		TestEqual(TEXT("Nick"), ToString(Message.GetNick()), FString(TEXT("foo")));
+		TestTrue(TEXT("Command"), Message.IsCommand("PRIVMSG"));
+		TestEqual(TEXT("Params"), ToString(Message.Params), FString(TEXT("#chan")));
+		TestEqual(TEXT("First param"), ToString(Message.GetFirstParam()), FString(TEXT("#chan")));
+		TestEqual(TEXT("Trailing keeps its spaces and colons"), ToString(Message.Trailing), FString(TEXT("hello :) world")));
+	}
+
+	if (TestTrue(TEXT("No prefix"), FTwitchIrcMessage::Parse("PING :tmi.twitch.tv", Message)))
+	{
+		TestTrue(TEXT("No prefix, no tags"), Message.Prefix.IsEmpty() && Message.Tags.IsEmpty());
+		TestTrue(TEXT("No prefix, command"), Message.IsCommand("PING"));
+		TestTrue(TEXT("No prefix, params"), Message.Params.IsEmpty());
+		TestEqual(TEXT("No prefix, trailing"), ToString(Message.Trailing), FString(TEXT("tmi.twitch.tv")));
+	}
+
+	if (TestTrue(TEXT("Tags without prefix"), FTwitchIrcMessage::Parse("@emote-sets=0;mod=1 USERSTATE  #chan", Message)))
+	{
+		TestEqual(TEXT("Tags without prefix, tags"), ToString(Message.Tags), FString(TEXT("emote-sets=0;mod=1")));
+		TestTrue(TEXT("Tags without prefix, prefix"), Message.Prefix.IsEmpty());
+		TestTrue(TEXT("Tags without prefix, command"), Message.IsCommand("USERSTATE"));
+		TestEqual(TEXT("Tags without prefix, params"), ToString(Message.Params), FString(TEXT("#chan")));
+		TestTrue(TEXT("Tags without prefix, trailing"), Message.Trailing.IsEmpty());
+	}
+
+	if (TestTrue(TEXT("Empty trailing"), FTwitchIrcMessage::Parse(":tmi.twitch.tv CAP * ACK :", Message)))
+	{
+		TestTrue(TEXT("Empty trailing, command"), Message.IsCommand("CAP"));
+		TestEqual(TEXT("Empty trailing, params"), ToString(Message.Params), FString(TEXT("* ACK")));
+		TestTrue(TEXT("Empty trailing, trailing"), Message.Trailing.IsEmpty());
+	}
+
+	TestFalse(TEXT("Empty line"), FTwitchIrcMessage::Parse("", Message));
+	TestFalse(TEXT("Tags only"), FTwitchIrcMessage::Parse("@mod=1 ", Message));
+	TestFalse(TEXT("Prefix only"), FTwitchIrcMessage::Parse(":tmi.twitch.tv", Message));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTwitchIrcMessageTagsTest, "TwitchPlay.Parsing.IrcMessage.Tags", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTwitchIrcMessageTagsTest::RunTest(const FString& Parameters)
+{
+	TestEqual(TEXT("Raw values, empty values, tags without '=' and empty entries"),
+		ListTags("badge-info=;badges=subscriber/12,bits/100;;display-name=Foo\\sBar;flag;msg=a\\:b\\\\c;"),
+		FString(TEXT("badge-info=|badges=subscriber/12,bits/100|display-name=Foo\\sBar|flag=|msg=a\\:b\\\\c")));
+	TestEqual(TEXT("Empty tag block"), ListTags(""), FString());
+
+	TestTrue(TEXT("Tag classified"), TwitchIrc::ClassifyTag("display-name") == ETwitchIrcTag::DisplayName);
+	TestTrue(TEXT("Same length, other tag"), TwitchIrc::ClassifyTag("display-namf") == ETwitchIrcTag::Unknown);
+
+	TestEqual(TEXT("Escaped space"), Unescape("Foo\\sBar"), FString(TEXT("Foo Bar")));
+	TestEqual(TEXT("Escaped semicolon and backslash"), Unescape("a\\:b\\\\c"), FString(TEXT("a;b\\c")));
+	TestEqual(TEXT("Escaped CR and LF"), Unescape("a\\r\\nb"), FString(TEXT("a\r\nb")));
+	TestEqual(TEXT("Unknown escape keeps the character"), Unescape("a\\qb"), FString(TEXT("aqb")));
+	TestEqual(TEXT("Trailing backslash dropped"), Unescape("ab\\"), FString(TEXT("ab")));
+	TestEqual(TEXT("Escaped UTF-8"), Unescape("caf\xC3\xA9\\s!"), FString(TEXT("caf\u00E9 !")));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTwitchIrcMessageNumbersTest, "TwitchPlay.Parsing.IrcMessage.Numbers", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTwitchIrcMessageNumbersTest::RunTest(const FString& Parameters)
+{
+	uint64 Value = 0;
+
+	TestTrue(TEXT("Zero"), TwitchIrc::ParseUInt64("0", Value) && Value == 0);
+	TestTrue(TEXT("tmi-sent-ts"), TwitchIrc::ParseUInt64("1507246572675", Value) && Value == 1507246572675ull);
+	TestTrue(TEXT("Leading zeros, 20 digits"), TwitchIrc::ParseUInt64("00000000000000000001", Value) && Value == 1);
+	TestTrue(TEXT("Largest value"), TwitchIrc::ParseUInt64("18446744073709551615", Value) && Value == MAX_uint64);
+
+	Value = 7;
+	TestFalse(TEXT("One past the largest value"), TwitchIrc::ParseUInt64("18446744073709551616", Value));
+	TestFalse(TEXT("20 digits past the largest value"), TwitchIrc::ParseUInt64("99999999999999999999", Value));
+	TestFalse(TEXT("21 digits"), TwitchIrc::ParseUInt64("100000000000000000000", Value));
+	TestFalse(TEXT("Empty"), TwitchIrc::ParseUInt64("", Value));
+	TestFalse(TEXT("Not a digit"), TwitchIrc::ParseUInt64("12a", Value));
+	TestFalse(TEXT("Negative"), TwitchIrc::ParseUInt64("-1", Value));
+	TestTrue(TEXT("Rejected values leave the output alone"), Value == 7);
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Parsing/TwitchLineFramer.h"
+
+namespace
+{
+	// Receives Data into the framer as a single read
+	void Receive(FTwitchLineFramer& Framer, const ANSICHAR* Data)
+	{
+		const int32 Size = FCStringAnsi::Strlen(Data);
+		int32 FreeSize = 0;
+		uint8* WriteBuffer = Framer.GetWriteBuffer(FreeSize);
+		check(Size <= FreeSize);
+		FMemory::Memcpy(WriteBuffer, Data, Size);
+		Framer.CommitWrite(Size);
+	}
+
+	// The lines popped, joined by '|'
+	FString PopLines(FTwitchLineFramer& Framer)
+	{
+		TArray<FString> Lines;
+		FAnsiStringView Line;
+		while (Framer.PopLine(Line))
+		{
+			Lines.Add(FString(Line.Len(), Line.GetData()));
+		}
+		return FString::Join(Lines, TEXT("|"));
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTwitchLineFramerSplitTest, "TwitchPlay.Parsing.LineFramer.Split", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTwitchLineFramerSplitTest::RunTest(const FString& Parameters)
+{
+	{
+		FTwitchLineFramer Framer;
+		Receive(Framer, "PING :a\r\nPING :b\r\n\r\nPING :c\n");
+		TestEqual(TEXT("Several lines in one read, empty lines skipped, LF alone accepted"), PopLines(Framer), FString(TEXT("PING :a|PING :b|PING :c")));
+	}
+
+	{
+		FTwitchLineFramer Framer;
+		Receive(Framer, "PING :a\r");
+		TestEqual(TEXT("CR without its LF is not a line yet"), PopLines(Framer), FString());
+		Receive(Framer, "\nPING :b\r\n");
+		TestEqual(TEXT("CRLF split across two reads"), PopLines(Framer), FString(TEXT("PING :a|PING :b")));
+	}
+
+	{
+		// Small enough that the incomplete line has to be moved to the front to make room
+		FTwitchLineFramer Framer(16, 8);
+		Receive(Framer, "abc\r\nde");
+		TestEqual(TEXT("Line before the cut"), PopLines(Framer), FString(TEXT("abc")));
+		Receive(Framer, "f\r\nxyz1234\r");
+		TestEqual(TEXT("Line cut across reads is carried over"), PopLines(Framer), FString(TEXT("def")));
+		Receive(Framer, "\n");
+		TestEqual(TEXT("Carried over line with its CRLF split"), PopLines(Framer), FString(TEXT("xyz1234")));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTwitchLineFramerOversizedTest, "TwitchPlay.Parsing.LineFramer.Oversized", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTwitchLineFramerOversizedTest::RunTest(const FString& Parameters)
+{
+	{
+		FTwitchLineFramer Framer(64, 8);
+		Receive(Framer, "123456789\r\nok\r\n");
+		TestEqual(TEXT("Oversized line in one read is dropped"), PopLines(Framer), FString(TEXT("ok")));
+		TestEqual(TEXT("Oversized lines counted"), Framer.GetNumOversizedLines(), 1);
+	}
+
+	{
+		FTwitchLineFramer Framer(64, 8);
+		Receive(Framer, "1234567890");
+		TestEqual(TEXT("Nothing while the oversized line is received"), PopLines(Framer), FString());
+		Receive(Framer, "abcdefghij");
+		TestEqual(TEXT("Nothing from the rest of the oversized line"), PopLines(Framer), FString());
+		Receive(Framer, "klm\r\nnext\r\n");
+		TestEqual(TEXT("Oversized line across reads is dropped as a whole"), PopLines(Framer), FString(TEXT("next")));
+		TestEqual(TEXT("Oversized line across reads counted once"), Framer.GetNumOversizedLines(), 1);
+	}
+
+	{
+		FTwitchLineFramer Framer(64, 8);
+		Receive(Framer, "12345678\r");
+		TestEqual(TEXT("Line of the maximum length waits for its LF"), PopLines(Framer), FString());
+		Receive(Framer, "\n");
+		TestEqual(TEXT("Line of the maximum length with its CRLF split is kept"), PopLines(Framer), FString(TEXT("12345678")));
+		TestEqual(TEXT("Line of the maximum length is not oversized"), Framer.GetNumOversizedLines(), 0);
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Network/TwitchOutbound.h"
+
+namespace
+{
+	FString ToString(const FAnsiStringView& View)
+	{
+		return FString(View.Len(), View.GetData());
+	}
+
+	TArray<uint8> ToBytes(const ANSICHAR* Text)
+	{
+		return TArray<uint8>(reinterpret_cast<const uint8*>(Text), FCStringAnsi::Strlen(Text));
+	}
+
+	// The chunks of a split message joined by '|', the command escape shown as "<esc>". Empty if the split was refused
+	FString SplitMessage(const ANSICHAR* Text, const int32 MaxBytes, bool& bOutFits)
+	{
+		TwitchOutbound::FChatChunks Chunks;
+		if (!TwitchOutbound::SplitChatMessage(FAnsiStringView(Text), MaxBytes, Chunks))
+		{
+			bOutFits = false;
+			return FString();
+		}
+
+		bOutFits = true;
+		TArray<FString> Parts;
+		for (const TwitchOutbound::FChatChunk& Chunk : Chunks)
+		{
+			bOutFits &= Chunk.Prefix.Len() + Chunk.Text.Len() <= MaxBytes;
+			const FString Prefix = Chunk.Prefix.Equals(TwitchOutbound::CommandEscape) ? FString(TEXT("<esc>")) : ToString(Chunk.Prefix);
+			Parts.Add(Prefix + ToString(Chunk.Text));
+		}
+		return FString::Join(Parts, TEXT("|"));
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTwitchOutboundSplitTest, "TwitchPlay.Network.Outbound.Split", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTwitchOutboundSplitTest::RunTest(const FString& Parameters)
+{
+	TestEqual(TEXT("Short text is not cut"), TwitchOutbound::FindSplit("hello", 10), 5);
+	TestEqual(TEXT("Cut at the last space"), TwitchOutbound::FindSplit("hello there general", 14), 11);
+	TestEqual(TEXT("Space in the first half ignored"), TwitchOutbound::FindSplit("ab cdefghijkl", 10), 10);
+	TestEqual(TEXT("Never inside a code point"), TwitchOutbound::FindSplit("aaaaaaaaa\xC3\xA9" "bbbb", 10), 9);
+
+	TestEqual(TEXT("Whisper"), TwitchOutbound::FindRepeatedCommand("/W Bob hi"), 7);
+	TestEqual(TEXT("Whisper with extra spaces"), TwitchOutbound::FindRepeatedCommand("/w  bob  hi"), 8);
+	TestEqual(TEXT("Whisper without text"), TwitchOutbound::FindRepeatedCommand("/w bob"), 0);
+	TestEqual(TEXT("Action"), TwitchOutbound::FindRepeatedCommand(".me waves"), 4);
+	TestEqual(TEXT("Other command"), TwitchOutbound::FindRepeatedCommand("/mod bob"), 0);
+	TestEqual(TEXT("Not a command"), TwitchOutbound::FindRepeatedCommand("hello there"), 0);
+
+	bool bFits = false;
+	TestEqual(TEXT("Fits in one chunk"), SplitMessage("/ban someone", 16, bFits), FString(TEXT("/ban someone")));
+	TestEqual(TEXT("Plain text"), SplitMessage("hello there general kenobi", 12, bFits), FString(TEXT("hello there|general|kenobi")));
+	TestTrue(TEXT("Plain text chunks fit"), bFits);
+
+	TestEqual(TEXT("Long whisper stays a whisper"), SplitMessage("/w user hello there general kenobi", 20, bFits), FString(TEXT("/w user hello there|/w user general|/w user kenobi")));
+	TestTrue(TEXT("Long whisper chunks fit"), bFits);
+	TestEqual(TEXT("Long action"), SplitMessage("/me waves at everyone here", 16, bFits), FString(TEXT("/me waves at|/me everyone|/me here")));
+	TestTrue(TEXT("Long action chunks fit"), bFits);
+	TestEqual(TEXT("Command in a whisper is text"), SplitMessage("/w bob hi /ban x", 14, bFits), FString(TEXT("/w bob hi /ban|/w bob x")));
+
+	TestEqual(TEXT("Continuation starting with '/' escaped"), SplitMessage("look at this /ban x", 14, bFits), FString(TEXT("look at this|<esc>/ban x")));
+	TestTrue(TEXT("Escaped chunks fit"), bFits);
+	TestEqual(TEXT("Continuation starting with '.' escaped"), SplitMessage("look at this .ban x", 14, bFits), FString(TEXT("look at this|<esc>.ban x")));
+
+	TwitchOutbound::FChatChunks Chunks;
+	TestFalse(TEXT("Long command refused"), TwitchOutbound::SplitChatMessage("/ban someone because of a long reason", 16, Chunks));
+	TestFalse(TEXT("Long '.' command refused"), TwitchOutbound::SplitChatMessage(".ban someone because of a long reason", 16, Chunks));
+
+	TArray<uint8> Line;
+	TwitchOutbound::AppendChatLine("chan", {FAnsiStringView("/me "), FAnsiStringView("hi")}, Line);
+	TestTrue(TEXT("Chat line"), Line == ToBytes("PRIVMSG #chan :/me hi\r\n"));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTwitchOutboundDuplicateTest, "TwitchPlay.Network.Outbound.Duplicate", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTwitchOutboundDuplicateTest::RunTest(const FString& Parameters)
+{
+	const TArray<uint8> Line = ToBytes("PRIVMSG #chan :hello\r\n");
+	const TArray<uint8> OtherChannel = ToBytes("PRIVMSG #other :hello\r\n");
+
+	FTwitchDuplicateFilter Filter;
+	TestFalse(TEXT("Never written"), Filter.IsDuplicate(Line, 0.0));
+	TestFalse(TEXT("Checking does not remember"), Filter.IsDuplicate(Line, 1.0));
+
+	// Written late, after waiting for the rate limits. The window starts then, not when it was queued
+	Filter.Record(Line, 25.0);
+	TestTrue(TEXT("Inside the window of the write"), Filter.IsDuplicate(Line, 31.0));
+	TestFalse(TEXT("Same text in another channel"), Filter.IsDuplicate(OtherChannel, 31.0));
+	TestFalse(TEXT("Window over"), Filter.IsDuplicate(Line, 55.0));
+
+	// Recording prunes the old entries
+	Filter.Record(OtherChannel, 100.0);
+	TestFalse(TEXT("Pruned"), Filter.IsDuplicate(Line, 100.0));
+	TestTrue(TEXT("Kept"), Filter.IsDuplicate(OtherChannel, 110.0));
+
+	Filter.Reset();
+	TestFalse(TEXT("Reset"), Filter.IsDuplicate(OtherChannel, 110.0));
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Polls/TwitchPoll.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTwitchPollVoteTest, "TwitchPlay.Polls.Poll.Vote", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTwitchPollVoteTest::RunTest(const FString& Parameters)
+{
+	const double Now = FPlatformTime::Seconds();
+	FTwitchPollResults Results;
+
+	{
+		// Options are trimmed, empty ones dropped
+		FTwitchPoll Poll({TEXT("Red"), TEXT(" blue "), TEXT("")}, 0.0f, true);
+		TestTrue(TEXT("First vote"), Poll.Vote(1, "red", Now));
+		TestFalse(TEXT("Same option again"), Poll.Vote(1, "RED please", Now));
+		TestTrue(TEXT("Vote changed"), Poll.Vote(1, "Blue", Now));
+		TestTrue(TEXT("Leading spaces, first word only"), Poll.Vote(2, "  bLUE and more", Now));
+		TestFalse(TEXT("No user id"), Poll.Vote(0, "red", Now));
+		TestFalse(TEXT("Longer word"), Poll.Vote(3, "redd", Now));
+		TestFalse(TEXT("Not the first word"), Poll.Vote(3, "go red", Now));
+		TestFalse(TEXT("Empty message"), Poll.Vote(3, "", Now));
+
+		Poll.GetResults(Now, Results);
+		TestTrue(TEXT("Options"), Results.Options == TArray<FString>({TEXT("Red"), TEXT("blue")}));
+		TestTrue(TEXT("Counts"), Results.Votes == TArray<int32>({0, 2}));
+		TestEqual(TEXT("Voters"), Results.TotalVotes, 2);
+		TestTrue(TEXT("Open"), Results.bIsOpen);
+		TestEqual(TEXT("Open until closed"), Results.TimeRemaining, 0.0f);
+
+		TestTrue(TEXT("Results changed"), Poll.ConsumeResults(Now, Results));
+		TestFalse(TEXT("Results unchanged"), Poll.ConsumeResults(Now, Results));
+		TestTrue(TEXT("Vote back"), Poll.Vote(2, "red", Now));
+		TestTrue(TEXT("Results changed by a vote"), Poll.ConsumeResults(Now, Results));
+		TestTrue(TEXT("Counts after the change"), Results.Votes == TArray<int32>({1, 1}));
+
+		Poll.Close();
+		TestFalse(TEXT("Closed"), Poll.IsOpen(Now));
+		TestFalse(TEXT("No vote once closed"), Poll.Vote(3, "red", Now));
+		TestTrue(TEXT("Closing changes the results"), Poll.ConsumeResults(Now, Results));
+		TestFalse(TEXT("Closed results"), Results.bIsOpen);
+	}
+
+	{
+		FTwitchPoll Poll({TEXT("a"), TEXT("b")}, 0.0f, false);
+		TestTrue(TEXT("First vote kept"), Poll.Vote(1, "a", Now));
+		TestFalse(TEXT("Vote change refused"), Poll.Vote(1, "b", Now));
+		Poll.GetResults(Now, Results);
+		TestTrue(TEXT("Counts without vote change"), Results.Votes == TArray<int32>({1, 0}));
+	}
+
+	{
+		FTwitchPoll Poll({TEXT("a"), TEXT("b")}, 10.0f, true);
+		TestTrue(TEXT("Timed poll open"), Poll.IsOpen(Now));
+		TestTrue(TEXT("Vote in time"), Poll.Vote(1, "a", Now));
+		Poll.GetResults(Now, Results);
+		TestTrue(TEXT("Time remaining"), Results.TimeRemaining > 9.0f && Results.TimeRemaining < 11.0f);
+		TestFalse(TEXT("Timed poll over"), Poll.IsOpen(Now + 20.0));
+		TestFalse(TEXT("Vote too late"), Poll.Vote(2, "a", Now + 20.0));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTwitchPollVotersTest, "TwitchPlay.Polls.Poll.Voters", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTwitchPollVotersTest::RunTest(const FString& Parameters)
+{
+	const double Now = FPlatformTime::Seconds();
+	FTwitchPoll Poll({TEXT("a"), TEXT("b")}, 0.0f, true);
+
+	// Enough voters for the table to grow several times, with sequential ids like Twitch user ids
+	constexpr int32 NumVoters = 3000;
+	int32 NumCounted = 0;
+	for (int32 Voter = 1; Voter <= NumVoters; ++Voter)
+	{
+		NumCounted += Poll.Vote(100000 + Voter, Voter % 3 == 0 ? "b" : "a", Now) ? 1 : 0;
+	}
+	TestEqual(TEXT("Every voter counted"), NumCounted, NumVoters);
+
+	// Every voter is still found after the table grew
+	int32 NumRecounted = 0;
+	for (int32 Voter = 1; Voter <= NumVoters; ++Voter)
+	{
+		NumRecounted += Poll.Vote(100000 + Voter, Voter % 3 == 0 ? "b" : "a", Now) ? 1 : 0;
+	}
+	TestEqual(TEXT("Same votes not counted again"), NumRecounted, 0);
+
+	FTwitchPollResults Results;
+	Poll.GetResults(Now, Results);
+	TestEqual(TEXT("Voters"), Results.TotalVotes, NumVoters);
+	TestTrue(TEXT("Counts"), Results.Votes == TArray<int32>({2000, 1000}));
+
+	return true;
+}
+
+#endif
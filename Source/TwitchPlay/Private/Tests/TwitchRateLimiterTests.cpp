@@ -0,0 +1,173 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Network/TwitchRateLimiter.h"
+
+namespace
+{
+	FTwitchRateLimits MakeLimits(const int32 MessagesPerWindow, const int32 PrivilegedMessagesPerWindow)
+	{
+		FTwitchRateLimits Limits;
+		Limits.MessagesPerWindow = MessagesPerWindow;
+		Limits.PrivilegedMessagesPerWindow = PrivilegedMessagesPerWindow;
+		Limits.WindowSeconds = 30.0f;
+		return Limits;
+	}
+
+	void PushChat(FTwitchSendScheduler& Scheduler, const TCHAR* Channel, const TCHAR* Text, const ETwitchMessagePriority Priority = ETwitchMessagePriority::NORMAL)
+	{
+		Scheduler.Push(FTwitchSendMessage {ETwitchSendMessageType::CHAT_MESSAGE, Text, Channel, Priority}, Channel);
+	}
+
+	// The messages the scheduler lets out at Now, joined by '|'
+	FString PopAll(FTwitchSendScheduler& Scheduler, const double Now, double& OutWaitSeconds)
+	{
+		TArray<FString> Messages;
+		FTwitchSendMessage Message;
+		OutWaitSeconds = -1.0;
+		while (Scheduler.Pop(Now, Message, OutWaitSeconds))
+		{
+			Messages.Add(Message.Message);
+		}
+		return FString::Join(Messages, TEXT("|"));
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTwitchTokenBucketTest, "TwitchPlay.Network.RateLimiter.TokenBucket", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTwitchTokenBucketTest::RunTest(const FString& Parameters)
+{
+	FTwitchTokenBucket Bucket(3, 10.0);
+	TestEqual(TEXT("Full at first"), Bucket.GetAvailable(0.0), 3);
+
+	// Bursts up to the capacity
+	TestTrue(TEXT("Burst 1"), Bucket.TryConsume(0.0));
+	TestTrue(TEXT("Burst 2"), Bucket.TryConsume(0.0));
+	TestTrue(TEXT("Burst 3"), Bucket.TryConsume(1.0));
+	TestFalse(TEXT("Empty"), Bucket.TryConsume(1.0));
+	TestEqual(TEXT("Wait for the oldest token"), Bucket.GetTimeUntilAvailable(5.0), 5.0);
+
+	// Each token comes back a window after it was spent
+	TestEqual(TEXT("Two tokens back"), Bucket.GetAvailable(10.0), 2);
+	TestTrue(TEXT("Token back"), Bucket.TryConsume(10.0));
+	TestTrue(TEXT("Second token back"), Bucket.TryConsume(10.0));
+	TestFalse(TEXT("Third token not back yet"), Bucket.TryConsume(10.5));
+	TestEqual(TEXT("Third token"), Bucket.GetTimeUntilAvailable(10.5), 0.5);
+
+	// A smaller capacity keeps the most recent sends
+	Bucket.SetCapacity(1);
+	TestEqual(TEXT("Shrunk"), Bucket.GetAvailable(11.0), 0);
+	TestEqual(TEXT("Shrunk, most recent send kept"), Bucket.GetTimeUntilAvailable(11.0), 9.0);
+	Bucket.SetCapacity(4);
+	TestEqual(TEXT("Grown"), Bucket.GetAvailable(11.0), 3);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTwitchSendSchedulerTest, "TwitchPlay.Network.RateLimiter.Scheduler", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTwitchSendSchedulerTest::RunTest(const FString& Parameters)
+{
+	double WaitSeconds = 0.0;
+
+	{
+		FTwitchSendScheduler Scheduler;
+		Scheduler.Configure(MakeLimits(2, 100), 0.0);
+		PushChat(Scheduler, TEXT("a"), TEXT("a1"));
+		PushChat(Scheduler, TEXT("a"), TEXT("a2"), ETwitchMessagePriority::LOW);
+		PushChat(Scheduler, TEXT("a"), TEXT("a3"), ETwitchMessagePriority::HIGH);
+		TestEqual(TEXT("Priority order within the channel budget"), PopAll(Scheduler, 0.0, WaitSeconds), FString(TEXT("a3|a1")));
+		TestEqual(TEXT("Channel bucket empty"), WaitSeconds, 30.0);
+
+		// A channel out of tokens does not hold back lower priority messages to other channels
+		PushChat(Scheduler, TEXT("a"), TEXT("a4"), ETwitchMessagePriority::HIGH);
+		PushChat(Scheduler, TEXT("b"), TEXT("b1"), ETwitchMessagePriority::LOW);
+		TestEqual(TEXT("Other channel goes"), PopAll(Scheduler, 1.0, WaitSeconds), FString(TEXT("b1")));
+		TestEqual(TEXT("Still pending"), Scheduler.GetNumPending(), 2);
+		TestEqual(TEXT("Channel tokens back"), PopAll(Scheduler, 30.0, WaitSeconds), FString(TEXT("a4|a2")));
+		TestTrue(TEXT("Drained"), Scheduler.IsEmpty());
+	}
+
+	{
+		FTwitchSendScheduler Scheduler;
+		Scheduler.Configure(MakeLimits(10, 100), 0.0);
+		PushChat(Scheduler, TEXT("c"), TEXT("c1"));
+		PushChat(Scheduler, TEXT("c"), TEXT("c2"));
+		PushChat(Scheduler, TEXT("d"), TEXT("d1"));
+		PushChat(Scheduler, TEXT("d"), TEXT("d2"));
+		TestEqual(TEXT("Channels take turns"), PopAll(Scheduler, 0.0, WaitSeconds), FString(TEXT("c1|d1|c2|d2")));
+	}
+
+	{
+		// Regular accounts share the privileged limit across channels
+		FTwitchSendScheduler Scheduler;
+		Scheduler.Configure(MakeLimits(10, 3), 0.0);
+		PushChat(Scheduler, TEXT("c"), TEXT("c1"));
+		PushChat(Scheduler, TEXT("d"), TEXT("d1"));
+		PushChat(Scheduler, TEXT("c"), TEXT("c2"));
+		PushChat(Scheduler, TEXT("d"), TEXT("d2"));
+		TestEqual(TEXT("Account limit"), PopAll(Scheduler, 0.0, WaitSeconds), FString(TEXT("c1|d1|c2")));
+		TestEqual(TEXT("Account tokens"), Scheduler.GetAccountTokens(0.0), 0);
+		TestEqual(TEXT("Account wait"), WaitSeconds, 30.0);
+		TestEqual(TEXT("Account tokens back"), PopAll(Scheduler, 30.0, WaitSeconds), FString(TEXT("d2")));
+	}
+
+	{
+		FTwitchRateLimits Limits = MakeLimits(1, 3);
+		Limits.PrivilegedChannels.Add(TEXT(" #Mod "));
+		FTwitchSendScheduler Scheduler;
+		Scheduler.Configure(Limits, 0.0);
+		TestTrue(TEXT("Configured names normalized"), Scheduler.IsChannelPrivileged(TEXT("mod")));
+		TestFalse(TEXT("Other channels not privileged"), Scheduler.IsChannelPrivileged(TEXT("user")));
+
+		PushChat(Scheduler, TEXT("mod"), TEXT("m1"));
+		PushChat(Scheduler, TEXT("mod"), TEXT("m2"));
+		PushChat(Scheduler, TEXT("user"), TEXT("u1"));
+		PushChat(Scheduler, TEXT("user"), TEXT("u2"));
+		TestEqual(TEXT("Privileged bucket"), PopAll(Scheduler, 0.0, WaitSeconds), FString(TEXT("m1|u1|m2")));
+
+		Scheduler.SetChannelPrivileged(TEXT("user"), true);
+		TestTrue(TEXT("Privilege detected later"), Scheduler.IsChannelPrivileged(TEXT("user")));
+	}
+
+	{
+		// Minimum spacing between chat messages
+		FTwitchSendScheduler Scheduler;
+		Scheduler.Configure(MakeLimits(10, 100), 1.5);
+		PushChat(Scheduler, TEXT("c"), TEXT("c1"));
+		PushChat(Scheduler, TEXT("c"), TEXT("c2"));
+		TestEqual(TEXT("Spaced"), PopAll(Scheduler, 0.0, WaitSeconds), FString(TEXT("c1")));
+		TestEqual(TEXT("Spacing wait"), WaitSeconds, 1.5);
+		TestEqual(TEXT("After the spacing"), PopAll(Scheduler, 1.5, WaitSeconds), FString(TEXT("c2")));
+	}
+
+	{
+		// Joins have their own bucket, are batched and go before chat
+		FTwitchSendScheduler Scheduler;
+		Scheduler.Configure(MakeLimits(10, 100), 0.0);
+		PushChat(Scheduler, TEXT("c"), TEXT("c1"));
+		Scheduler.PushJoin(TEXT("a"));
+		Scheduler.PushJoin(TEXT("b"));
+		Scheduler.PushJoin(TEXT("a"));
+		Scheduler.PushJoin(TEXT("c"));
+		TestTrue(TEXT("Join canceled"), Scheduler.CancelJoin(TEXT("c")));
+		TestFalse(TEXT("Join not queued"), Scheduler.CancelJoin(TEXT("d")));
+		TestEqual(TEXT("Joins queued once"), Scheduler.GetNumPending(), 3);
+
+		FTwitchSendMessage Message;
+		if (TestTrue(TEXT("Join first"), Scheduler.Pop(0.0, Message, WaitSeconds)))
+		{
+			TestTrue(TEXT("Join message"), Message.Type == ETwitchSendMessageType::JOIN_MESSAGE);
+			TestEqual(TEXT("Joins batched"), Message.Message, FString(TEXT("#a,#b")));
+		}
+		TestEqual(TEXT("Chat after the joins"), PopAll(Scheduler, 0.0, WaitSeconds), FString(TEXT("c1")));
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Parsing/TwitchUtf8.h"
+
+namespace
+{
+	constexpr uint32 Replacement = 0xFFFD;
+
+	// Builds the expected text from code points, as a surrogate pair where TCHAR is 16 bits
+	FString FromCodePoints(std::initializer_list<uint32> CodePoints)
+	{
+		FString Result;
+		for (const uint32 CodePoint : CodePoints)
+		{
+			if (sizeof(TCHAR) == 2 && CodePoint > 0xFFFF)
+			{
+				Result.AppendChar(static_cast<TCHAR>(0xD800 + ((CodePoint - 0x10000) >> 10)));
+				Result.AppendChar(static_cast<TCHAR>(0xDC00 + ((CodePoint - 0x10000) & 0x3FF)));
+			}
+			else
+			{
+				Result.AppendChar(static_cast<TCHAR>(CodePoint));
+			}
+		}
+		return Result;
+	}
+
+	FString Decode(const ANSICHAR* Utf8)
+	{
+		return TwitchUtf8::ToString(FAnsiStringView(Utf8));
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTwitchUtf8ValidTest, "TwitchPlay.Parsing.Utf8.Valid", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTwitchUtf8ValidTest::RunTest(const FString& Parameters)
+{
+	TestEqual(TEXT("Empty"), Decode(""), FString());
+	TestEqual(TEXT("ASCII"), Decode("Kappa 123"), FString(TEXT("Kappa 123")));
+	TestEqual(TEXT("Two, three and four byte sequences"), Decode("\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80"), FromCodePoints({ 0xE9, 0x20AC, 0x1F600 }));
+	TestEqual(TEXT("Largest code point"), Decode("\xF4\x8F\xBF\xBF"), FromCodePoints({ 0x10FFFF }));
+	TestEqual(TEXT("Last code points before and after the surrogates"), Decode("\xED\x9F\xBF\xEE\x80\x80"), FromCodePoints({ 0xD7FF, 0xE000 }));
+
+	// Past the 32 and 16 byte ASCII blocks, and inside them
+	const FString Ascii40 = FString::ChrN(40, TEXT('a'));
+	const FString Ascii20 = FString::ChrN(20, TEXT('b'));
+	const FString Accent = FromCodePoints({ 0xE9 });
+	TestEqual(TEXT("Non-ASCII after two blocks"), Decode(TCHAR_TO_UTF8(*(Ascii40 + Accent + Ascii20))), Ascii40 + Accent + Ascii20);
+	TestEqual(TEXT("Non-BMP inside a block"), Decode(TCHAR_TO_UTF8(*(Ascii20 + FromCodePoints({ 0x1F600 }) + Ascii40))), Ascii20 + FromCodePoints({ 0x1F600 }) + Ascii40);
+
+	// The string keeps its allocation but not its old text
+	FString Reused = Ascii40 + Ascii40;
+	TwitchUtf8::Decode(FAnsiStringView("\xC3\xA9t\xC3\xA9"), Reused);
+	TestEqual(TEXT("Decoded into a longer string"), Reused, FromCodePoints({ 0xE9, 't', 0xE9 }));
+	TestEqual(TEXT("Decoded into a longer string, length"), Reused.Len(), 3);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTwitchUtf8InvalidTest, "TwitchPlay.Parsing.Utf8.Invalid", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTwitchUtf8InvalidTest::RunTest(const FString& Parameters)
+{
+	// Each byte of an invalid sequence is replaced on its own, decoding resyncs on the next byte
+	TestEqual(TEXT("Overlong two byte '/'"), Decode("\xC0\xAF"), FromCodePoints({ Replacement, Replacement }));
+	TestEqual(TEXT("Overlong three byte '/'"), Decode("\xE0\x80\xAF"), FromCodePoints({ Replacement, Replacement, Replacement }));
+	TestEqual(TEXT("Overlong four byte '/'"), Decode("\xF0\x80\x80\xAF"), FromCodePoints({ Replacement, Replacement, Replacement, Replacement }));
+	TestEqual(TEXT("High surrogate"), Decode("\xED\xA0\x80"), FromCodePoints({ Replacement, Replacement, Replacement }));
+	TestEqual(TEXT("Low surrogate"), Decode("\xED\xBF\xBF"), FromCodePoints({ Replacement, Replacement, Replacement }));
+	TestEqual(TEXT("Above U+10FFFF"), Decode("\xF4\x90\x80\x80"), FromCodePoints({ Replacement, Replacement, Replacement, Replacement }));
+	TestEqual(TEXT("Invalid lead bytes"), Decode("a\xF5\xFF" "b"), FromCodePoints({ 'a', Replacement, Replacement, 'b' }));
+	TestEqual(TEXT("Lone continuation byte"), Decode("a\x80" "b"), FromCodePoints({ 'a', Replacement, 'b' }));
+
+	TestEqual(TEXT("Truncated at the end"), Decode("a\xE2\x82"), FromCodePoints({ 'a', Replacement, Replacement }));
+	TestEqual(TEXT("Truncated by ASCII"), Decode("\xF0\x9F\x98" "b"), FromCodePoints({ Replacement, Replacement, Replacement, 'b' }));
+	TestEqual(TEXT("Truncated by a valid sequence"), Decode("\xC3\xC3\xA9"), FromCodePoints({ Replacement, 0xE9 }));
+
+	const FString Ascii20 = FString::ChrN(20, TEXT('c'));
+	TestEqual(TEXT("Invalid byte inside a block"), Decode("cccccccccccccccccccc\xFF" "cccccccccccccccccccc"), Ascii20 + FromCodePoints({ Replacement }) + Ascii20);
+
+	return true;
+}
+
+#endif
@@ -1,12 +1,17 @@
 // Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
 
 #include "TwitchPlay.h"
+#include "Network/TwitchMockIrcServer.h"
 
 void FTwitchPlayModule::StartupModule()
 {}
 
 void FTwitchPlayModule::ShutdownModule()
-{}
+{
+#if WITH_TWITCHPLAY_MOCK_SERVER
+	TwitchMockServer::ShutdownConsoleServer();
+#endif
+}
 
 IMPLEMENT_MODULE(FTwitchPlayModule, TwitchPlay)
 
@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TwitchStats.h"
+
+DEFINE_STAT(STAT_TwitchPlay_Receive);
+DEFINE_STAT(STAT_TwitchPlay_Frame);
+DEFINE_STAT(STAT_TwitchPlay_Parse);
+DEFINE_STAT(STAT_TwitchPlay_BytesReceived);
+DEFINE_STAT(STAT_TwitchPlay_LinesReceived);
+DEFINE_STAT(STAT_TwitchPlay_ParseMicrosPerLine);
+
+DEFINE_STAT(STAT_TwitchPlay_Dispatch);
+DEFINE_STAT(STAT_TwitchPlay_MessagesDelivered);
+DEFINE_STAT(STAT_TwitchPlay_ReceiveQueueDepth);
+DEFINE_STAT(STAT_TwitchPlay_MessagesDropped);
+
+DEFINE_STAT(STAT_TwitchPlay_Send);
+DEFINE_STAT(STAT_TwitchPlay_SendQueueDepth);
+DEFINE_STAT(STAT_TwitchPlay_OutboundTokens);
+DEFINE_STAT(STAT_TwitchPlay_PendingSendBytes);
+DEFINE_STAT(STAT_TwitchPlay_SendWaitMilliseconds);
+
+UE_TRACE_CHANNEL_DEFINE(TwitchPlayChannel);
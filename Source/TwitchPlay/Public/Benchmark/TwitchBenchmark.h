@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if !UE_BUILD_SHIPPING
+
+// What the benchmarks run on
+struct FTwitchBenchmarkSettings
+{
+	// Lines generated for each corpus
+	int32 NumLines = 100000;
+
+	// Bytes handed to the receiver at once, like a socket read
+	int32 ReadSize = 16 * 1024;
+
+	// Seconds the end to end benchmark receives from the mock server. 0 skips it
+	float EndToEndSeconds = 5.0f;
+
+	// Chat messages per second the mock server sends in each channel, and the number of channels
+	float EndToEndRate = 2500.0f;
+	int32 EndToEndChannels = 4;
+
+	// Seed of the generated corpora, the same seed gives the same lines
+	int32 Seed = 1;
+
+	/**
+	* Reads the settings from console arguments like "Lines=200000 E2ESeconds=0".
+	*
+	* @param Args - The arguments. Missing ones keep their default
+	*/
+	static FTwitchBenchmarkSettings Parse(const TCHAR* Args);
+};
+
+/**
+ * Throughput, allocation and latency benchmarks of the receive path, on fixed generated corpora:
+ * tag heavy PRIVMSGs, bits messages, non ASCII text and command heavy chat.
+ *
+ * For each corpus, on the calling thread:
+ * - tokenize: FTwitchIrcMessage::Parse and the classification of every tag, nothing else.
+ * - receive: the receiver framing, parsing and queueing, fed ReadSize bytes at a time (FTwitchMessageReceiver::StartOffline).
+ * - deliver: what the subsystem does on the game thread, decoding, emote counting and command matching with options.
+ * Each reports lines/s and heap allocations per line. The latency between the parse of a read and the end of the
+ * handler of each of its messages, and the peak memory growth, are reported too.
+ *
+ * The end to end benchmark connects a receiver to the loopback mock server and reports the same latency, plus the
+ * latency from the server timestamp, with the real threads. Only in builds with the mock server.
+ *
+ * Also run from the console with TwitchPlay.Benchmark, which writes the results to a JSON file.
+ */
+namespace TwitchBenchmark
+{
+	/**
+	* Runs all the benchmarks. Blocks the calling thread until they are done.
+	*
+	* @param Settings - Corpus sizes and end to end traffic
+	* @return The results, as JSON
+	*/
+	TWITCHPLAY_API FString Run(const FTwitchBenchmarkSettings& Settings);
+}
+
+#endif // !UE_BUILD_SHIPPING
@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/TwitchStructs.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "TwitchChatterLibrary.generated.h"
+
+/**
+ * Blueprint access to the chatters of the chat messages.
+ */
+UCLASS()
+class TWITCHPLAY_API UTwitchChatterLibrary : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+
+	/**
+	* Whether the chatter is still known. Chatters not seen for a long time are forgotten when the registry is full.
+	*
+	* @param Chatter - The chatter, from a chat message.
+	*/
+	UFUNCTION(BlueprintPure, Category = "Twitch|Chatters")
+	static bool IsChatterValid(const FTwitchChatterHandle& Chatter);
+
+	/**
+	* Lowercase login name of the chatter, the name used in commands and whispers.
+	*
+	* @param Chatter - The chatter, from a chat message.
+	*/
+	UFUNCTION(BlueprintPure, Category = "Twitch|Chatters")
+	static FString GetChatterLogin(const FTwitchChatterHandle& Chatter);
+
+	/**
+	* Name of the chatter as shown in chat. The login if the chatter has no display name.
+	*
+	* @param Chatter - The chatter, from a chat message.
+	*/
+	UFUNCTION(BlueprintPure, Category = "Twitch|Chatters")
+	static FString GetChatterDisplayName(const FTwitchChatterHandle& Chatter);
+
+	/**
+	* Latest chat color of the chatter.
+	*
+	* @param Chatter - The chatter, from a chat message.
+	*/
+	UFUNCTION(BlueprintPure, Category = "Twitch|Chatters")
+	static FColor GetChatterColor(const FTwitchChatterHandle& Chatter);
+
+	/**
+	* Twitch user id of the chatter. 0 if unknown.
+	*
+	* @param Chatter - The chatter, from a chat message.
+	*/
+	UFUNCTION(BlueprintPure, Category = "Twitch|Chatters")
+	static int64 GetChatterUserId(const FTwitchChatterHandle& Chatter);
+};
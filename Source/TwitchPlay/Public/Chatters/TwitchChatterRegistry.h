@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/TwitchStructs.h"
+
+/**
+ * Chatters seen in chat, interned by Twitch user id so their names are allocated once instead of once per message.
+ *
+ * The receiving threads intern the sender of every message and the messages only carry the handle. A chatter
+ * already known with the same names and color is found under a read lock without allocating; the write lock is
+ * only taken for new chatters and name or color changes.
+ * The registry holds up to MaxChatters. When full, the slot of a chatter not seen recently is given to the new
+ * one (clock eviction) and its generation changes, so handles of the evicted chatter stop resolving.
+ */
+class TWITCHPLAY_API FTwitchChatterRegistry
+{
+public:
+
+	static constexpr int32 DefaultMaxChatters = 65536;
+
+	explicit FTwitchChatterRegistry(int32 InMaxChatters = DefaultMaxChatters);
+
+	// Registry shared by all the connections
+	static FTwitchChatterRegistry& Get();
+
+	/**
+	* Finds or adds a chatter. Called from the receiving threads.
+	*
+	* @param UserId - From the user-id tag. 0 if unknown, the chatter is then keyed by login
+	* @param Login - Lowercase login name, UTF-8
+	* @param DisplayName - From the display-name tag, UTF-8. Can be empty
+	* @param Color - From the color tag
+	* @return The chatter handle
+	*/
+	FTwitchChatterHandle Intern(uint64 UserId, const FAnsiStringView& Login, const FAnsiStringView& DisplayName, const FColor& Color);
+
+	// Handle of a chatter by user id. Invalid if not in the registry
+	FTwitchChatterHandle Find(uint64 UserId) const;
+
+	bool IsValid(const FTwitchChatterHandle& Chatter) const;
+
+	// Lowercase login name. Empty if the handle does not resolve
+	FString GetLogin(const FTwitchChatterHandle& Chatter) const;
+
+	// Copies the login into OutLogin, which keeps its allocation. Emptied if the handle does not resolve
+	void CopyLogin(const FTwitchChatterHandle& Chatter, FString& OutLogin) const;
+
+	// Display name, or the login when the chatter has none. Empty if the handle does not resolve
+	FString GetDisplayName(const FTwitchChatterHandle& Chatter) const;
+
+	// Latest chat color. White if the handle does not resolve
+	FColor GetColor(const FTwitchChatterHandle& Chatter) const;
+
+	// Twitch user id. 0 if unknown or the handle does not resolve
+	uint64 GetUserId(const FTwitchChatterHandle& Chatter) const;
+
+	int32 Num() const;
+
+private:
+
+	struct FChatter
+	{
+		// User id, or a hash of the login for chatters without one
+		uint64 Key = 0;
+
+		uint64 UserId = 0;
+
+		// Hash of the UTF-8 login and display name, to find changes without decoding
+		uint64 NamesHash = 0;
+
+		FString Login;
+
+		FString DisplayName;
+
+		FColor Color = FColor::White;
+
+		int32 Generation = 0;
+	};
+
+	// Chatter the handle points to, nullptr if it does not resolve. Lock must be held
+	const FChatter* Resolve(const FTwitchChatterHandle& Chatter) const;
+
+	// Slot of a chatter not seen since the last sweep. Write lock must be held
+	int32 Evict();
+
+	TArray<FChatter> Chatters;
+
+	// Set whenever a chatter is interned, cleared by the eviction sweep. Written under the read lock too
+	TArray<int8> RecentlySeen;
+
+	TMap<uint64, int32> Indices;
+
+	int32 MaxChatters;
+
+	int32 ClockHand;
+
+	mutable FRWLock Lock;
+};
@@ -0,0 +1,189 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Event.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter64.h"
+#include "TwitchEnums.h"
+
+/**
+ * Fixed capacity queue between the worker threads and the game thread.
+ * Storage is allocated once, so memory stays flat no matter how long nobody pulls from it.
+ * When full, the overflow policy decides what happens to new items. Dropped items are counted.
+ * Producers and the consumer take a lock once per batch, not once per item.
+ */
+template <typename ElementType>
+class TTwitchBoundedQueue
+{
+public:
+
+	TTwitchBoundedQueue(const int32 InCapacity, const ETwitchQueueOverflowPolicy InPolicy)
+		: Head(0)
+		, Count(0)
+		, Policy(InPolicy)
+		, SpaceEvent(FPlatformProcess::GetSynchEventFromPool(false))
+		, bUnblocked(false)
+		, NumDropped(0)
+	{
+		check(InCapacity > 0);
+		Items.SetNum(InCapacity);
+	}
+
+	~TTwitchBoundedQueue()
+	{
+		FPlatformProcess::ReturnSynchEventToPool(SpaceEvent);
+	}
+
+	TTwitchBoundedQueue(const TTwitchBoundedQueue&) = delete;
+	TTwitchBoundedQueue& operator=(const TTwitchBoundedQueue&) = delete;
+
+	void Enqueue(const ElementType& Item)
+	{
+		ElementType Copy(Item);
+		Enqueue(MoveTemp(Copy));
+	}
+
+	// Queues a single item, applying the overflow policy if full
+	void Enqueue(ElementType&& Item)
+	{
+		Lock.Lock();
+		if (MakeRoom())
+		{
+			Push(MoveTemp(Item));
+		}
+		Lock.Unlock();
+	}
+
+	// Queues all the items of a batch, in order, applying the overflow policy if full. Empties the batch
+	void EnqueueBatch(TArray<ElementType>& Batch)
+	{
+		Lock.Lock();
+		for (ElementType& Item : Batch)
+		{
+			if (MakeRoom())
+			{
+				Push(MoveTemp(Item));
+			}
+		}
+		Lock.Unlock();
+		Batch.Reset();
+	}
+
+	// Takes the oldest item, returns false if empty
+	bool Dequeue(ElementType& OutItem)
+	{
+		{
+			FScopeLock ScopeLock(&Lock);
+			if (Count == 0)
+			{
+				return false;
+			}
+			OutItem = MoveTemp(Items[Head]);
+			Head = (Head + 1) % Items.Num();
+			--Count;
+		}
+		SpaceEvent->Trigger();
+		return true;
+	}
+
+	// Moves every queued item into OutItems, oldest first
+	void DequeueAll(TArray<ElementType>& OutItems)
+	{
+		{
+			FScopeLock ScopeLock(&Lock);
+			if (Count == 0)
+			{
+				return;
+			}
+
+			OutItems.Reserve(OutItems.Num() + Count);
+			for (int32 Index = 0; Index < Count; ++Index)
+			{
+				OutItems.Add(MoveTemp(Items[(Head + Index) % Items.Num()]));
+			}
+			Head = 0;
+			Count = 0;
+		}
+		SpaceEvent->Trigger();
+	}
+
+	// Releases producers waiting on a full queue. From now on a full queue drops new items instead of blocking
+	void Unblock()
+	{
+		bUnblocked = true;
+		SpaceEvent->Trigger();
+	}
+
+	int32 Num() const
+	{
+		FScopeLock ScopeLock(&Lock);
+		return Count;
+	}
+
+	int32 GetCapacity() const
+	{
+		return Items.Num();
+	}
+
+	// The number of items dropped because the queue was full
+	int64 GetNumDropped() const
+	{
+		return NumDropped.GetValue();
+	}
+
+private:
+
+	// Called with the lock held. Returns false if the new item must be dropped.
+	// With the BLOCK policy the lock is released while waiting for the consumer.
+	bool MakeRoom()
+	{
+		while (Count == Items.Num())
+		{
+			if (Policy == ETwitchQueueOverflowPolicy::DROP_OLDEST)
+			{
+				Items[Head] = ElementType();
+				Head = (Head + 1) % Items.Num();
+				--Count;
+				NumDropped.Increment();
+			}
+			else if (Policy == ETwitchQueueOverflowPolicy::DROP_NEWEST || bUnblocked)
+			{
+				NumDropped.Increment();
+				return false;
+			}
+			else
+			{
+				Lock.Unlock();
+				SpaceEvent->Wait();
+				Lock.Lock();
+			}
+		}
+		return true;
+	}
+
+	void Push(ElementType&& Item)
+	{
+		Items[(Head + Count) % Items.Num()] = MoveTemp(Item);
+		++Count;
+	}
+
+	mutable FCriticalSection Lock;
+
+	// Ring storage, allocated once
+	TArray<ElementType> Items;
+
+	int32 Head;
+
+	int32 Count;
+
+	ETwitchQueueOverflowPolicy Policy;
+
+	// Signaled when the consumer makes room, for the BLOCK policy
+	FEvent* SpaceEvent;
+
+	FThreadSafeBool bUnblocked;
+
+	FThreadSafeCounter64 NumDropped;
+};
@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/TwitchStructs.h"
+
+/**
+ * Drops commands still cooling down, before they are dispatched.
+ *
+ * Global and per command cooldowns are a ready time each. Per user cooldowns live in a fixed size open addressing
+ * table keyed by user id and command, so memory does not grow with the number of chatters. Entries expire through
+ * a hierarchical timing wheel (3 levels of 256 slots, 10 ms ticks) instead of a timer each: advancing the wheel
+ * only touches the slots that are due. Every check is O(1).
+ * When the table is full, new user cooldowns are not recorded and those commands go through.
+ */
+class TWITCHPLAY_API FTwitchCooldownFilter
+{
+public:
+
+	static constexpr int32 DefaultMaxEntries = 16384;
+
+	explicit FTwitchCooldownFilter(int32 InMaxEntries = DefaultMaxEntries);
+
+	/**
+	* Forgets every cooldown.
+	*
+	* @param InNumCommands - Number of command indices the next checks use
+	*/
+	void Reset(int32 InNumCommands);
+
+	/**
+	* Makes room for more command indices. The running cooldowns are kept.
+	*
+	* @param InNumCommands - Number of command indices the next checks use, never less than before
+	*/
+	void SetNumCommands(int32 InNumCommands);
+
+	/**
+	* Checks a command against the cooldowns and starts them if it goes through.
+	*
+	* @param UserId - The user sending the command. 0 skips the user cooldown
+	* @param CommandIndex - The command, from 0 to the number given to Reset or SetNumCommands
+	* @param Cooldowns - The cooldown durations
+	* @param Now - Current FPlatformTime::Seconds()
+	* @return False if the command is cooling down and must be dropped
+	*/
+	bool TryPass(uint64 UserId, int32 CommandIndex, const FTwitchCommandCooldowns& Cooldowns, double Now);
+
+	// Number of user cooldowns running
+	int32 Num() const
+	{
+		return NumEntries;
+	}
+
+private:
+
+	static constexpr int32 WheelBits = 8;
+	static constexpr int32 WheelSlots = 1 << WheelBits;
+	static constexpr int32 WheelLevels = 3;
+	static constexpr uint32 WheelSlotMask = WheelSlots - 1;
+	static constexpr double TicksPerSecond = 100.0;
+
+	struct FEntry
+	{
+		uint64 Key;
+		uint32 ExpireTick;
+		// Next entry in the same wheel slot, or in the free list
+		int32 Next;
+	};
+
+	uint32 ToTick(double Now) const;
+
+	// Expires the entries due up to NowTick
+	void Advance(uint32 NowTick);
+
+	// Links the entry into the wheel slot matching its expire tick
+	void Schedule(int32 EntryIndex);
+
+	// Schedules again the entries of a higher level slot, now that they are closer to expiring
+	void Cascade(int32 Level, uint32 Slot);
+
+	// Removes an expired entry from the table and frees it
+	void Expire(int32 EntryIndex);
+
+	// Table slot holding the key, or the empty slot it would go to
+	int32 FindSlot(uint64 Key) const;
+
+	uint32 GetHomeSlot(uint64 Key) const;
+
+	TArray<FEntry> Entries;
+
+	// Open addressing table of entry indices, INDEX_NONE for empty slots. Twice as many slots as entries
+	TArray<int32> Table;
+
+	// First entry of each wheel slot, level after level
+	TArray<int32> WheelHeads;
+
+	int32 FreeHead;
+
+	int32 NumEntries;
+
+	uint32 CurrentTick;
+
+	double StartTime;
+
+	// FPlatformTime::Seconds() after which the command can be used again
+	TArray<double> CommandReadyTimes;
+
+	double GlobalReadyTime;
+};
@@ -15,16 +15,84 @@ enum class ETwitchConnectionMessageType : uint8
 	FAILED_TO_AUTHENTICATE,
 	// A general error, doesn't mean the connection was terminated.
 	ERROR,
-	// General message from the server
+	// General message from the server. Only sent if the server messages echo is enabled
 	MESSAGE,
-	// Disconnected from server.
-	DISCONNECTED
+	// Disconnected from server. After a lost connection, only sent once the reconnection attempts are over.
+	DISCONNECTED,
+	// The connection was lost or the server asked to reconnect. A new connection is attempted.
+	RECONNECTING,
+	// Connected again after a reconnection. Joined channels and queued messages are restored.
+	RECONNECTED
+};
+
+UENUM(BlueprintType)
+enum class ETwitchQueueOverflowPolicy : uint8
+{
+	// Drop the oldest queued messages to make room for the new ones
+	DROP_OLDEST,
+	// Drop the new messages, keeping what is already queued
+	DROP_NEWEST,
+	// Stop receiving until there is room. The server will eventually drop the connection if this lasts too long
+	BLOCK
+};
+
+UENUM(BlueprintType)
+enum class ETwitchBotTier : uint8
+{
+	// Regular account
+	REGULAR,
+	// Verified bot, with much higher account wide limits
+	VERIFIED
+};
+
+// Priorities order the chat messages that the rate limits allow to send now. A message waiting for its channel
+// tokens does not hold back lower priority messages to other channels
+UENUM(BlueprintType)
+enum class ETwitchMessagePriority : uint8
+{
+	// Sent before the NORMAL and LOW messages that could go out
+	HIGH,
+	NORMAL,
+	// Sent when no HIGH or NORMAL message can go out
+	LOW
+};
+
+// Chat badges the tag parser knows. Each one is a bit of the badge mask of the chat messages
+UENUM(BlueprintType)
+enum class ETwitchBadge : uint8
+{
+	BROADCASTER,
+	MODERATOR,
+	VIP,
+	// Version is the tier, e.g. 3012 for tier 3 with 12 months
+	SUBSCRIBER,
+	FOUNDER,
+	// Prime Gaming
+	PREMIUM,
+	TURBO,
+	PARTNER,
+	STAFF,
+	ADMIN,
+	GLOBAL_MOD,
+	// Version is the cheered amount, e.g. 1000
+	BITS,
+	BITS_LEADER,
+	SUB_GIFTER,
+	SUB_GIFT_LEADER,
+	ARTIST,
+	NO_AUDIO,
+	NO_VIDEO,
+	MAX UMETA(Hidden)
 };
 
 enum class ETwitchSendMessageType : uint8
 {
 	// User Chat Message
 	CHAT_MESSAGE,
-	// Join new channel message
+	// Join channel message
 	JOIN_MESSAGE,
+	// Leave channel message
+	PART_MESSAGE,
+	// Raw IRC line (PONG, CAP, ...), sent as is
+	RAW_MESSAGE,
 };
\ No newline at end of file
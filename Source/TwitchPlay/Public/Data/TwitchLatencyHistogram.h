@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/TwitchStructs.h"
+
+/**
+ * Fixed bucket latency histogram, in microseconds, in the spirit of HDR histograms.
+ * Values below SubBucketCount get a bucket each. Above that, every power of two range is split in SubBucketCount
+ * buckets, so any value is known within 1 / SubBucketCount (about 6%) up to MaxMicroseconds.
+ * Recording is a couple of shifts and an increment, and memory stays the same however many values are recorded.
+ */
+class TWITCHPLAY_API FTwitchLatencyHistogram
+{
+public:
+
+	static constexpr int32 SubBucketBits = 4;
+	static constexpr int32 SubBucketCount = 1 << SubBucketBits;
+
+	// Larger values are counted in the last bucket, about 12 days
+	static constexpr int32 MaxExponent = 39;
+	static constexpr int64 MaxMicroseconds = (int64(1) << (MaxExponent + 1)) - 1;
+
+	static constexpr int32 NumBuckets = (MaxExponent - SubBucketBits + 2) * SubBucketCount;
+
+	FTwitchLatencyHistogram();
+
+	// Records a latency. Negative values, from clocks out of sync, count as 0
+	void Record(int64 Microseconds);
+
+	void RecordSeconds(const double Seconds)
+	{
+		Record(static_cast<int64>(Seconds * 1000000.0));
+	}
+
+	/**
+	* Gets a percentile of the recorded values.
+	*
+	* @param Percentile - Between 0 and 1
+	* @return The highest value of the bucket the percentile falls in, never more than the max recorded. 0 if empty
+	*/
+	int64 GetPercentile(double Percentile) const;
+
+	// p50, p95, p99 and max, in milliseconds
+	void GetPercentiles(FTwitchLatencyPercentiles& OutPercentiles) const;
+
+	// Forgets every value
+	void Reset();
+
+	int64 GetCount() const
+	{
+		return Count;
+	}
+
+	int64 GetMax() const
+	{
+		return Max;
+	}
+
+private:
+
+	static int32 GetBucket(int64 Microseconds);
+
+	// Highest value counted in a bucket
+	static int64 GetBucketMax(int32 Bucket);
+
+	TArray<int64> Buckets;
+
+	int64 Count;
+
+	int64 Max;
+};
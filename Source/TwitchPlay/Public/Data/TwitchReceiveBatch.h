@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/TwitchStructs.h"
+#include "Data/TwitchTextSlab.h"
+
+/**
+ * Chat message as it goes from the receiving threads to the game thread.
+ * Its text stays UTF-8 in the slab of its batch until the game thread delivers it.
+ */
+struct TWITCHPLAY_API FTwitchReceivedMessage
+{
+	TRefCountPtr<FTwitchTextSlab> Slab;
+
+	FTwitchTextSpan Text;
+
+	// Tag block, without the leading '@'
+	FTwitchTextSpan Tags;
+
+	// Channel, without the leading #
+	FTwitchTextSpan Channel;
+
+	// CityHash64 of the channel name, to count messages per channel without decoding it
+	uint64 ChannelHash = 0;
+
+	FTwitchChatterHandle Chatter;
+
+	FColor UserColor = FColor::White;
+
+	int64 SentTimestamp = 0;
+
+	// FPlatformTime::Seconds() when the socket read holding the message was received, and when its parse was complete
+	double ReceiveTime = 0.0;
+	double ParseTime = 0.0;
+
+	int64 UserId = 0;
+
+	uint64 IdHash = 0;
+
+	uint32 BadgeMask = 0;
+
+	float Bits = 0;
+
+	bool bIsSubbed = false;
+
+	bool bBits = false;
+
+	FAnsiStringView GetText() const
+	{
+		return Slab->View(Text);
+	}
+
+	FAnsiStringView GetChannel() const
+	{
+		return Slab->View(Channel);
+	}
+
+	/**
+	* Fills a chat message for delivery. Its strings keep their allocations when large enough.
+	*
+	* @param OutMessage - The message to fill
+	*/
+	void ToChatMessage(FTwitchChatMessage& OutMessage) const;
+};
+
+// Chat messages parsed from one read of the socket
+struct FTwitchReceiveMessages
+{
+	TRefCountPtr<FTwitchTextSlab> Slab;
+
+	// FPlatformTime::Seconds() when the read was received
+	double ReceiveTime = 0.0;
+
+	TArray<FTwitchReceivedMessage> Messages;
+};
@@ -4,15 +4,9 @@
 
 #include "CoreMinimal.h"
 #include "TwitchEnums.h"
+#include "Parsing/TwitchMessageTags.h"
 #include "TwitchStructs.generated.h"
 
-// Blob of user messages received
-struct FTwitchReceiveMessages
-{
-	TArray<FString> Usernames;
-	TArray<FString> Messages;
-};
-
 struct FTwitchConnection
 {
 	FTwitchConnection(): Type()
@@ -39,6 +33,85 @@ struct FTwitchSendMessage
 	
 	// The channel (can be empty)
 	FString Channel;
+
+	// Chat messages with a higher priority are sent first
+	ETwitchMessagePriority Priority = ETwitchMessagePriority::NORMAL;
+
+	// FPlatformTime::Seconds() when the game thread queued the message
+	double QueueTime = 0.0;
+
+	// Chat messages: the whole PRIVMSG line, UTF-8 with its CRLF, encoded once when queued
+	TArray<uint8> Line;
+};
+
+/**
+* Twitch chat rate limits. Messages are sent in bursts up to these limits, and never faster.
+* See https://dev.twitch.tv/docs/irc/#rate-limits
+*/
+USTRUCT(BlueprintType)
+struct FTwitchRateLimits
+{
+	GENERATED_BODY()
+
+public:
+	// Account tier, sets the account wide message and join limits
+	UPROPERTY(Category = "Rate Limits", EditAnywhere, BlueprintReadWrite)
+	ETwitchBotTier BotTier = ETwitchBotTier::REGULAR;
+
+	// Messages per window in a channel where the bot is not the broadcaster, a moderator or a VIP
+	UPROPERTY(Category = "Rate Limits", EditAnywhere, BlueprintReadWrite)
+	int32 MessagesPerWindow = 20;
+
+	// Messages per window in a channel where the bot is the broadcaster, a moderator or a VIP
+	UPROPERTY(Category = "Rate Limits", EditAnywhere, BlueprintReadWrite)
+	int32 PrivilegedMessagesPerWindow = 100;
+
+	UPROPERTY(Category = "Rate Limits", EditAnywhere, BlueprintReadWrite)
+	float WindowSeconds = 30.0f;
+
+	// Channels where the bot is known to be privileged. Others are detected from the USERSTATE sent by the server
+	UPROPERTY(Category = "Rate Limits", EditAnywhere, BlueprintReadWrite)
+	TArray<FString> PrivilegedChannels;
+
+	// Connections sharing the account wide limits, each one gets an equal part. Set by the connection pool
+	int32 NumConnections = 1;
+
+	// Messages per window across all channels
+	int32 GetAccountMessagesPerWindow() const
+	{
+		const int32 AccountMessages = BotTier == ETwitchBotTier::VERIFIED ? 7500 : PrivilegedMessagesPerWindow;
+		return FMath::Max(AccountMessages / FMath::Max(NumConnections, 1), 1);
+	}
+
+	// Channels joined per 10 seconds
+	int32 GetJoinsPerWindow() const
+	{
+		const int32 AccountJoins = BotTier == ETwitchBotTier::VERIFIED ? 2000 : 20;
+		return FMath::Max(AccountJoins / FMath::Max(NumConnections, 1), 1);
+	}
+};
+
+// Chatter interned in FTwitchChatterRegistry. Resolve it with UTwitchChatterLibrary
+USTRUCT(BlueprintType)
+struct FTwitchChatterHandle
+{
+	GENERATED_BODY()
+
+public:
+	int32 Index = INDEX_NONE;
+
+	// Changes when the registry slot is given to another chatter, so old handles stop resolving
+	int32 Generation = 0;
+
+	bool operator==(const FTwitchChatterHandle& Other) const
+	{
+		return Index == Other.Index && Generation == Other.Generation;
+	}
+
+	bool operator!=(const FTwitchChatterHandle& Other) const
+	{
+		return !(*this == Other);
+	}
 };
 
 USTRUCT(BlueprintType)
@@ -47,8 +120,13 @@ struct FTwitchChatMessage
 	GENERATED_BODY()
 
 public:
+	// Login of the sender, filled from the chatter registry when the message is delivered
 	UPROPERTY(Category = "Message", EditAnywhere, BlueprintReadWrite)
 	FString Username = "";
+
+	// Who sent the message. Login, display name and color are shared by all the messages of the chatter
+	UPROPERTY(Category = "Message", EditAnywhere, BlueprintReadWrite)
+	FTwitchChatterHandle Chatter;
 	
 	UPROPERTY(Category = "Message", EditAnywhere, BlueprintReadWrite)
 	FString Message = "";
@@ -64,4 +142,291 @@ public:
 	
 	UPROPERTY(Category = "Message", EditAnywhere, BlueprintReadWrite)
 	FColor UserColor = FColor::White;
+
+	// Channel the message was sent to, without the leading #
+	UPROPERTY(Category = "Message", EditAnywhere, BlueprintReadWrite)
+	FString Channel = "";
+
+	// Time the server got the message, in milliseconds since the Unix epoch. 0 if unknown
+	UPROPERTY(Category = "Message", EditAnywhere, BlueprintReadWrite)
+	int64 SentTimestamp = 0;
+
+	// Twitch user id of the sender. 0 if unknown
+	UPROPERTY(Category = "Message", EditAnywhere, BlueprintReadWrite)
+	int64 UserId = 0;
+
+	// Hash of the message id, the same message received on two connections has the same hash. 0 if unknown
+	uint64 IdHash = 0;
+
+	// One bit per ETwitchBadge, from the badges and mod tags
+	uint32 BadgeMask = 0;
+
+	// Every tag of the message, decoded on demand
+	FTwitchMessageTags Tags;
+
+	bool HasBadge(const ETwitchBadge Badge) const
+	{
+		return (BadgeMask & FTwitchBadgeSet::GetBit(Badge)) != 0;
+	}
+};
+
+// One emote in a chat message
+USTRUCT(BlueprintType)
+struct FTwitchEmoteSpan
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(Category = "Emote", EditAnywhere, BlueprintReadWrite)
+	FString EmoteId;
+
+	// First character of the emote in the message text
+	UPROPERTY(Category = "Emote", EditAnywhere, BlueprintReadWrite)
+	int32 Start = 0;
+
+	// Last character of the emote in the message text
+	UPROPERTY(Category = "Emote", EditAnywhere, BlueprintReadWrite)
+	int32 End = 0;
+};
+
+// How often an emote was used
+USTRUCT(BlueprintType)
+struct FTwitchEmoteCount
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(Category = "Emote", EditAnywhere, BlueprintReadWrite)
+	FString EmoteId;
+
+	// The emote as typed in chat, e.g. "Kappa"
+	UPROPERTY(Category = "Emote", EditAnywhere, BlueprintReadWrite)
+	FString Name;
+
+	// Uses counted. Can be over by up to MaxError for emotes that started being tracked late
+	UPROPERTY(Category = "Emote", EditAnywhere, BlueprintReadWrite)
+	int64 Count = 0;
+
+	UPROPERTY(Category = "Emote", EditAnywhere, BlueprintReadWrite)
+	int64 MaxError = 0;
+};
+
+USTRUCT(BlueprintType)
+struct FTwitchPollResults
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(Category = "Poll", EditAnywhere, BlueprintReadWrite)
+	TArray<FString> Options;
+
+	// Votes per option, in the same order as Options
+	UPROPERTY(Category = "Poll", EditAnywhere, BlueprintReadWrite)
+	TArray<int32> Votes;
+
+	// Number of users who voted
+	UPROPERTY(Category = "Poll", EditAnywhere, BlueprintReadWrite)
+	int32 TotalVotes = 0;
+
+	// Seconds until the poll closes. 0 if closed or open until closed by hand
+	UPROPERTY(Category = "Poll", EditAnywhere, BlueprintReadWrite)
+	float TimeRemaining = 0.0f;
+
+	UPROPERTY(Category = "Poll", EditAnywhere, BlueprintReadWrite)
+	bool bIsOpen = false;
+};
+
+// Cooldowns applied to chat commands before their callbacks fire. 0 disables a cooldown
+USTRUCT(BlueprintType)
+struct FTwitchCommandCooldowns
+{
+	GENERATED_BODY()
+
+public:
+	// Seconds before the same user can use the same command again
+	UPROPERTY(Category = "Cooldowns", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0"))
+	float UserCooldownSeconds = 0.0f;
+
+	// Seconds before anyone can use the same command again
+	UPROPERTY(Category = "Cooldowns", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0"))
+	float CommandCooldownSeconds = 0.0f;
+
+	// Seconds before anyone can use any command again
+	UPROPERTY(Category = "Cooldowns", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0"))
+	float GlobalCooldownSeconds = 0.0f;
+};
+
+// Percentiles of one latency histogram, in milliseconds
+USTRUCT(BlueprintType)
+struct FTwitchLatencyPercentiles
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(Category = "Latency", EditAnywhere, BlueprintReadWrite)
+	float P50 = 0.0f;
+
+	UPROPERTY(Category = "Latency", EditAnywhere, BlueprintReadWrite)
+	float P95 = 0.0f;
+
+	UPROPERTY(Category = "Latency", EditAnywhere, BlueprintReadWrite)
+	float P99 = 0.0f;
+
+	UPROPERTY(Category = "Latency", EditAnywhere, BlueprintReadWrite)
+	float Max = 0.0f;
+
+	// Messages measured
+	UPROPERTY(Category = "Latency", EditAnywhere, BlueprintReadWrite)
+	int64 Count = 0;
+};
+
+/**
+* Where the time went between a viewer sending a chat message and the game handling it.
+* Twitch and Total use the tmi-sent-ts tag, they are only as good as the sync of the local clock with Twitch.
+*/
+USTRUCT(BlueprintType)
+struct FTwitchChatLatency
+{
+	GENERATED_BODY()
+
+public:
+	// Twitch sent the message -> the socket read holding it. Twitch and the network
+	UPROPERTY(Category = "Latency", EditAnywhere, BlueprintReadWrite)
+	FTwitchLatencyPercentiles Twitch;
+
+	// Socket read -> parse complete. Framing, parsing and tags
+	UPROPERTY(Category = "Latency", EditAnywhere, BlueprintReadWrite)
+	FTwitchLatencyPercentiles Parse;
+
+	// Parse complete -> game thread handler. Mostly waiting for the next frame
+	UPROPERTY(Category = "Latency", EditAnywhere, BlueprintReadWrite)
+	FTwitchLatencyPercentiles Dispatch;
+
+	// Twitch sent the message -> game thread handler
+	UPROPERTY(Category = "Latency", EditAnywhere, BlueprintReadWrite)
+	FTwitchLatencyPercentiles Total;
+};
+
+// Snapshot of the receive and send pipeline counters, summed over all the connections. Cheap to get every frame
+USTRUCT(BlueprintType)
+struct FTwitchPipelineStats
+{
+	GENERATED_BODY()
+
+public:
+	// Bytes read from the sockets since the connection started
+	UPROPERTY(Category = "Pipeline", EditAnywhere, BlueprintReadWrite)
+	int64 BytesReceived = 0;
+
+	// IRC lines parsed, chat messages or not
+	UPROPERTY(Category = "Pipeline", EditAnywhere, BlueprintReadWrite)
+	int64 LinesReceived = 0;
+
+	// Chat messages dropped because the queue was full
+	UPROPERTY(Category = "Pipeline", EditAnywhere, BlueprintReadWrite)
+	int64 MessagesDropped = 0;
+
+	// Chat messages sent
+	UPROPERTY(Category = "Pipeline", EditAnywhere, BlueprintReadWrite)
+	int64 MessagesSent = 0;
+
+	// Chat messages not sent because an identical one went to the same channel less than 30 seconds before
+	UPROPERTY(Category = "Pipeline", EditAnywhere, BlueprintReadWrite)
+	int64 DuplicatesDropped = 0;
+
+	// Chat messages refused because the socket was not keeping up with the bytes already queued
+	UPROPERTY(Category = "Pipeline", EditAnywhere, BlueprintReadWrite)
+	int64 MessagesRejected = 0;
+
+	// Chat messages waiting for the game thread
+	UPROPERTY(Category = "Pipeline", EditAnywhere, BlueprintReadWrite)
+	int32 ReceiveQueueDepth = 0;
+
+	// Chat messages and joins waiting for the rate limits
+	UPROPERTY(Category = "Pipeline", EditAnywhere, BlueprintReadWrite)
+	int32 SendQueueDepth = 0;
+
+	// Chat messages that could be sent right now under the account rate limit
+	UPROPERTY(Category = "Pipeline", EditAnywhere, BlueprintReadWrite)
+	int32 OutboundTokens = 0;
+
+	// Bytes written to the sockets' queues that the sockets did not take yet
+	UPROPERTY(Category = "Pipeline", EditAnywhere, BlueprintReadWrite)
+	int32 PendingSendBytes = 0;
+
+	// Average parse time of a line, framing included
+	UPROPERTY(Category = "Pipeline", EditAnywhere, BlueprintReadWrite)
+	float AverageParseMicroseconds = 0.0f;
+
+	// Average time a chat message waited between being queued and being sent
+	UPROPERTY(Category = "Pipeline", EditAnywhere, BlueprintReadWrite)
+	float AverageSendWaitMilliseconds = 0.0f;
+
+	// Totals the averages come from
+	double ParseSeconds = 0.0;
+	double SendWaitSeconds = 0.0;
+
+	// Sums another connection counters into these. Call UpdateAverages once done
+	void Add(const FTwitchPipelineStats& Other)
+	{
+		BytesReceived += Other.BytesReceived;
+		LinesReceived += Other.LinesReceived;
+		MessagesDropped += Other.MessagesDropped;
+		MessagesSent += Other.MessagesSent;
+		DuplicatesDropped += Other.DuplicatesDropped;
+		MessagesRejected += Other.MessagesRejected;
+		ReceiveQueueDepth += Other.ReceiveQueueDepth;
+		SendQueueDepth += Other.SendQueueDepth;
+		OutboundTokens += Other.OutboundTokens;
+		PendingSendBytes += Other.PendingSendBytes;
+		ParseSeconds += Other.ParseSeconds;
+		SendWaitSeconds += Other.SendWaitSeconds;
+	}
+
+	void UpdateAverages()
+	{
+		AverageParseMicroseconds = LinesReceived > 0 ? static_cast<float>(ParseSeconds * 1000000.0 / LinesReceived) : 0.0f;
+		AverageSendWaitMilliseconds = MessagesSent > 0 ? static_cast<float>(SendWaitSeconds * 1000.0 / MessagesSent) : 0.0f;
+	}
+};
+
+// Settings of the receiver connection
+struct FTwitchReceiverSettings
+{
+	// Chat server address and port
+	FString ServerHost = TEXT("irc.chat.twitch.tv");
+	int32 ServerPort = 6667;
+
+	// Maximum number of chat messages waiting for the game thread
+	int32 MaxQueuedMessages = 10000;
+
+	// What to do with new chat messages when the queue is full
+	ETwitchQueueOverflowPolicy OverflowPolicy = ETwitchQueueOverflowPolicy::DROP_OLDEST;
+
+	// Also report every raw line received from the server as a MESSAGE connection message
+	bool bEchoServerMessages = false;
+
+	// Outbound chat rate limits
+	FTwitchRateLimits RateLimits;
+
+	// Connect again when the connection is lost or the server asks for it
+	bool bAutoReconnect = true;
+
+	// Delay before the first reconnection attempt, doubled on each failed attempt
+	float ReconnectBaseDelaySeconds = 1.0f;
+
+	// Upper bound for the reconnection delay
+	float ReconnectMaxDelaySeconds = 30.0f;
+
+	// Failed reconnection attempts before giving up. 0 for no limit
+	int32 MaxReconnectAttempts = 0;
+
+	// Time resolving the server and connecting to it have before the attempt counts as failed
+	float ConnectTimeoutSeconds = 10.0f;
+
+	// Head start each connection attempt has before the next resolved address is tried alongside it
+	float ConnectAttemptDelaySeconds = 0.25f;
+
+	// Bytes queued for a socket that does not take them before new chat messages are refused
+	int32 MaxPendingSendBytes = 64 * 1024;
 };
\ No newline at end of file
@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+#include "Templates/RefCounting.h"
+
+class FTwitchTextSlabPool;
+
+// Range of text in a slab
+struct FTwitchTextSpan
+{
+	int32 Offset = 0;
+	int32 Len = 0;
+};
+
+/**
+ * Text of all the chat messages parsed from one read of the socket, UTF-8, in a single buffer.
+ * Filled by the receiving thread, then read only. Every message of the batch holds a reference, the last one
+ * released gives the slab back to its pool with its buffer, so a steady chat reuses the same few buffers.
+ */
+class TWITCHPLAY_API FTwitchTextSlab
+{
+public:
+
+	FTwitchTextSlab(const FTwitchTextSlab&) = delete;
+	FTwitchTextSlab& operator=(const FTwitchTextSlab&) = delete;
+
+	void AddRef() const
+	{
+		RefCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void Release() const;
+
+	// Copies the text at the end of the slab. Only before the slab is shared with another thread
+	FTwitchTextSpan Append(const FAnsiStringView& InText);
+
+	FAnsiStringView View(const FTwitchTextSpan& Span) const
+	{
+		return FAnsiStringView(Text.GetData() + Span.Offset, Span.Len);
+	}
+
+private:
+
+	friend class FTwitchTextSlabPool;
+
+	FTwitchTextSlab();
+
+	TArray<ANSICHAR> Text;
+
+	mutable std::atomic<int32> RefCount;
+
+	// Pool the slab goes back to, set while the slab is in use
+	TSharedPtr<FTwitchTextSlabPool, ESPMode::ThreadSafe> Pool;
+};
+
+/**
+ * Free slabs of a receiver. Slabs still referenced when the receiver goes away keep the pool alive until released.
+ */
+class TWITCHPLAY_API FTwitchTextSlabPool : public TSharedFromThis<FTwitchTextSlabPool, ESPMode::ThreadSafe>
+{
+public:
+
+	// Free slabs kept for reuse, beyond that released slabs are deleted
+	static constexpr int32 MaxFreeSlabs = 64;
+
+	// Slabs larger than this are not kept, a burst does not pin its memory forever
+	static constexpr int32 MaxKeptSlabBytes = 1 << 20;
+
+	~FTwitchTextSlabPool();
+
+	// An empty slab, reused when possible
+	TRefCountPtr<FTwitchTextSlab> Acquire();
+
+private:
+
+	friend class FTwitchTextSlab;
+
+	void Recycle(FTwitchTextSlab* Slab);
+
+	TArray<FTwitchTextSlab*> FreeSlabs;
+
+	FCriticalSection Lock;
+};
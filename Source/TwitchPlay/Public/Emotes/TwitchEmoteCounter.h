@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/TwitchStructs.h"
+
+/**
+ * Running count of the emotes used in chat, for top emotes queries.
+ *
+ * Space-Saving algorithm over a fixed number of counters: once all are taken, a new emote replaces the least counted
+ * one and inherits its count as error. Any emote used more than Total / Capacity times is guaranteed to be tracked.
+ * Counters are kept in buckets of equal count, linked in count order (stream summary), so counting an emote is O(1)
+ * and the top N are read from the highest bucket down.
+ * Game thread only.
+ */
+class TWITCHPLAY_API FTwitchEmoteCounter
+{
+public:
+
+	static constexpr int32 DefaultCapacity = 512;
+
+	explicit FTwitchEmoteCounter(int32 InCapacity = DefaultCapacity);
+
+	/**
+	* Counts one use of an emote.
+	*
+	* @param EmoteId - The emote id, UTF-8
+	* @param Name - The emote as typed in chat. Only copied when the emote starts being tracked
+	*/
+	void Add(const FAnsiStringView& EmoteId, const FStringView& Name);
+
+	/**
+	* Gets the most used emotes, most used first.
+	*
+	* @param Count - How many emotes at most
+	* @param OutTop - Reset, then filled with the emotes
+	*/
+	void GetTop(int32 Count, TArray<FTwitchEmoteCount>& OutTop) const;
+
+	// Forgets every count
+	void Reset();
+
+	// Emote uses counted since the last reset
+	int64 GetTotal() const
+	{
+		return Total;
+	}
+
+private:
+
+	struct FCounter
+	{
+		uint64 Key = 0;
+		int64 Error = 0;
+		FString EmoteId;
+		FString Name;
+		int32 Bucket = INDEX_NONE;
+		// Neighbours in the same bucket
+		int32 Prev = INDEX_NONE;
+		int32 Next = INDEX_NONE;
+	};
+
+	struct FBucket
+	{
+		int64 Count = 0;
+		int32 First = INDEX_NONE;
+		// Neighbours with a lower and a higher count
+		int32 Lower = INDEX_NONE;
+		int32 Higher = INDEX_NONE;
+	};
+
+	// Moves the counter to the bucket one count higher
+	void Increment(int32 CounterIndex);
+
+	void LinkCounter(int32 CounterIndex, int32 BucketIndex);
+
+	// Takes the counter out of its bucket, and the bucket out of the list if it is now empty
+	void UnlinkCounter(int32 CounterIndex);
+
+	// A new bucket placed just above Lower, or at the bottom of the list if Lower is INDEX_NONE
+	int32 InsertBucket(int64 Count, int32 Lower);
+
+	int32 Capacity;
+
+	TArray<FCounter> Counters;
+
+	TArray<FBucket> Buckets;
+
+	// Unused buckets, linked through Higher
+	int32 FreeBuckets;
+
+	// Lowest and highest count buckets
+	int32 MinBucket;
+	int32 MaxBucket;
+
+	// Counter of each tracked emote, by hash of its id
+	TMap<uint64, int32> Indices;
+
+	int64 Total;
+};
@@ -12,4 +12,32 @@ public:
 	static void Warning(const FString& String);
 
 	static void Error(const FString& String);
+
+	// Formatted variants. The string is only built if the verbosity is not suppressed
+	template <typename FmtType, typename... Types>
+	static void Infof(const FmtType& Format, Types... Args)
+	{
+		if (!LogTwitchPlay.IsSuppressed(ELogVerbosity::Display))
+		{
+			Info(FString::Printf(Format, Args...));
+		}
+	}
+
+	template <typename FmtType, typename... Types>
+	static void Warningf(const FmtType& Format, Types... Args)
+	{
+		if (!LogTwitchPlay.IsSuppressed(ELogVerbosity::Warning))
+		{
+			Warning(FString::Printf(Format, Args...));
+		}
+	}
+
+	template <typename FmtType, typename... Types>
+	static void Errorf(const FmtType& Format, Types... Args)
+	{
+		if (!LogTwitchPlay.IsSuppressed(ELogVerbosity::Error))
+		{
+			Error(FString::Printf(Format, Args...));
+		}
+	}
 };
\ No newline at end of file
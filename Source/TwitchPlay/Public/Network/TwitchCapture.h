@@ -0,0 +1,145 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IFileHandle;
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * Capture file (.tpcap) of the raw IRC byte stream, as it came out of the socket.
+ *
+ * Layout, little endian:
+ * - Header: "TPCAP" and a zero byte, uint16 version, int64 UTC time of the capture start in microseconds since 1970.
+ * - Then one record per socket read: int64 microseconds since the capture start, uint32 size, the bytes received.
+ *
+ * Reads are kept as they were, so a replay frames and parses the stream exactly like the live connection did.
+ */
+namespace TwitchCapture
+{
+	static constexpr ANSICHAR Magic[6] = { 'T', 'P', 'C', 'A', 'P', '\0' };
+
+	static constexpr uint16 Version = 1;
+
+	static constexpr int32 HeaderSize = sizeof(Magic) + sizeof(uint16) + sizeof(int64);
+
+	static constexpr int32 RecordHeaderSize = sizeof(int64) + sizeof(uint32);
+}
+
+/**
+ * Appends socket reads to a capture file.
+ * Records are buffered and written in large blocks, so the receiving thread seldom waits on the disk.
+ * Not thread safe, the receiver guards it.
+ */
+class TWITCHPLAY_API FTwitchCaptureWriter
+{
+public:
+
+	static constexpr int32 FlushSize = 256 * 1024;
+
+	FTwitchCaptureWriter();
+	~FTwitchCaptureWriter();
+
+	/**
+	* Creates the capture file, replacing any file with the same name.
+	*
+	* @param Filename - Path of the file
+	* @return False if the file could not be created
+	*/
+	bool Open(const FString& Filename);
+
+	/**
+	* Adds one socket read.
+	*
+	* @param Data - The bytes received
+	* @param Size - The number of bytes received
+	*/
+	void Write(const uint8* Data, int32 Size);
+
+	// Writes what is still buffered and closes the file
+	void Close();
+
+	bool IsOpen() const
+	{
+		return File.IsValid();
+	}
+
+	// Bytes of stream captured so far, without the record headers
+	int64 GetNumBytes() const
+	{
+		return NumBytes;
+	}
+
+private:
+
+	void Flush();
+
+	TUniquePtr<IFileHandle> File;
+
+	TArray<uint8> Buffer;
+
+	// Platform time of the capture start, the records are relative to it
+	double StartSeconds;
+
+	int64 NumBytes;
+};
+
+/**
+ * Reads the records of a capture file in order.
+ * The file is memory mapped when the platform allows it, and loaded whole otherwise.
+ */
+class TWITCHPLAY_API FTwitchCaptureReader
+{
+public:
+
+	FTwitchCaptureReader();
+	~FTwitchCaptureReader();
+
+	/**
+	* Opens a capture file and checks its header.
+	*
+	* @param Filename - Path of the file
+	* @param OutError - Why it failed
+	* @return False if the file can't be read or is not a capture
+	*/
+	bool Open(const FString& Filename, FString& OutError);
+
+	/**
+	* Gets the next socket read. A record cut short by the end of the file ends the capture.
+	*
+	* @param OutTimeMicros - Microseconds between the capture start and this read
+	* @param OutData - The bytes received, valid as long as the reader
+	* @param OutSize - The number of bytes received
+	* @return False at the end of the capture
+	*/
+	bool Next(int64& OutTimeMicros, const uint8*& OutData, int32& OutSize);
+
+	// Back to the first record
+	void Rewind()
+	{
+		ReadPos = TwitchCapture::HeaderSize;
+	}
+
+	// UTC time of the capture start, in microseconds since 1970
+	int64 GetStartUnixMicros() const
+	{
+		return StartUnixMicros;
+	}
+
+private:
+
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+
+	// The whole file, when it could not be mapped
+	TArray<uint8> Loaded;
+
+	const uint8* Data;
+	int64 Size;
+
+	int64 ReadPos;
+
+	int64 StartUnixMicros;
+};
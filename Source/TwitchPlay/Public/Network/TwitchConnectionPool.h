@@ -0,0 +1,172 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/TwitchEnums.h"
+#include "Data/TwitchStructs.h"
+#include "Runnables/TwitchMessageReceiver.h"
+
+/**
+ * Spreads the joined channels across several receiver connections (shards), each with its own threads and socket.
+ * The chat messages of all the shards are merged into a single stream ordered by server time, once per frame.
+ * A shard that falls behind the others hands its busiest channel over to the least loaded shard.
+ * During the hand over the channel is joined on both shards, the messages received twice are dropped by their id.
+ * Game thread only, the shards do the network work on their own threads.
+ */
+class TWITCHPLAY_API FTwitchConnectionPool
+{
+public:
+
+	// Seconds between two checks of the shards lag
+	static constexpr double RebalanceIntervalSeconds = 5.0;
+
+	// Lag difference between the slowest and the fastest shard that triggers a channel move
+	static constexpr double RebalanceLagThresholdSeconds = 1.0;
+
+	// Seconds a moved channel stays joined on its old shard, so no message is lost while the new shard joins it
+	static constexpr double HandOverSeconds = 5.0;
+
+	// Message ids remembered to drop duplicates
+	static constexpr int32 MaxRecentIds = 8192;
+
+	FTwitchConnectionPool();
+	~FTwitchConnectionPool();
+
+	/**
+	* Creates the shards and starts connecting them.
+	*
+	* @param oAuth - Oauth token to use
+	* @param username - Username to login with
+	* @param channel - The channel to join upon connection (optional)
+	* @param timeBetweenMessages - Optional minimum seconds between two chat messages
+	* @param numConnections - Number of shards, each one is a connection with its own threads
+	* @param settings - Settings of each shard. The account wide rate limits are split between the shards
+	*/
+	void StartConnection(const FString& oAuth, const FString& username, const FString& channel, const float timeBetweenMessages, const int32 numConnections, const FTwitchReceiverSettings& settings = FTwitchReceiverSettings());
+
+	/**
+	* Plays a capture file on a single shard instead of connecting. See FTwitchMessageReceiver::StartReplay.
+	*
+	* @param filename - The capture file
+	* @param speed - Replay speed factor. 0 or less plays as fast as possible
+	* @param settings - Settings of the shard
+	*/
+	void StartReplay(const FString& filename, const float speed, const FTwitchReceiverSettings& settings = FTwitchReceiverSettings());
+
+	void StopConnection(bool bWaitTillComplete);
+
+	/**
+	* Starts recording what each shard receives. With several shards each one gets its own file, suffixed with the shard index.
+	*
+	* @param filename - The capture file
+	* @return False if a file could not be created
+	*/
+	bool StartCapture(const FString& filename);
+
+	void StopCapture();
+
+	bool IsCapturing() const;
+
+	// Moves all the chat messages received by all the shards since the last call into OutMessages, in server time order
+	void PullMessages(TArray<FTwitchReceivedMessage>& OutMessages);
+
+	// Chat messages go through the shard that joined their channel. False if that shard refused the message
+	bool SendMessage(const ETwitchSendMessageType type, const FString& message, const FString& channel, const ETwitchMessagePriority priority = ETwitchMessagePriority::NORMAL) const;
+
+	bool PullConnectionMessage(ETwitchConnectionMessageType& OutStatus, FString& OutMessage) const;
+
+	// Each channel goes to the shard with the fewest channels
+	void JoinChannels(const TArray<FString>& channels);
+
+	void LeaveChannels(const TArray<FString>& channels);
+
+	// The channels joined, or to join upon connection, in join order
+	const TArray<FString>& GetJoinedChannels() const
+	{
+		return Channels;
+	}
+
+	// Sets the poll the chat messages of all the shards vote in, null for none
+	void SetPoll(const TSharedPtr<FTwitchPoll, ESPMode::ThreadSafe>& InPoll);
+
+	// True once all the shards are connected
+	bool IsConnected() const;
+
+	int64 GetNumDroppedMessages() const;
+
+	// Chat messages waiting in the receive queues of all the shards
+	int32 GetReceiveQueueDepth() const;
+
+	// The longest time a shard took to get its last lost connection back. 0 if none was lost
+	double GetLastRecoverySeconds() const;
+
+	// The pipeline counters of all the shards, summed
+	FTwitchPipelineStats GetPipelineStats() const;
+
+	void GetConnectionInfo(FString& OutOAuth, FString& OutUsername, FString& OutChannel) const;
+
+	int32 GetNumConnections() const
+	{
+		return Shards.Num();
+	}
+
+private:
+
+	struct FShard
+	{
+		TUniquePtr<FTwitchMessageReceiver> Receiver;
+
+		// Messages pulled this frame, in arrival order
+		TArray<FTwitchReceivedMessage> Messages;
+
+		// Channels owned by this shard
+		int32 NumChannels = 0;
+
+		// Smoothed seconds between the server time of a message and the time we pulled it
+		double LagSeconds = 0.0;
+
+		// Messages per channel since the last rebalance check, keyed by the hash of the channel name
+		TMap<uint64, int32> ChannelMessageCounts;
+	};
+
+	// A channel joined on two shards while it moves from one to the other
+	struct FHandOver
+	{
+		FString Channel;
+		int32 FromShard;
+		double LeaveTime;
+	};
+
+	// Index of the shard with the fewest channels
+	int32 FindLeastLoadedShard() const;
+
+	// Moves the busiest channel of the slowest shard to the fastest one, if the lag difference is large enough
+	void Rebalance(double Now);
+
+	// Leaves the moved channels on their old shard once the hand over time is over
+	void FinishHandOvers(double Now);
+
+	// True if the message id was seen recently. Remembers it otherwise
+	bool IsDuplicate(uint64 IdHash);
+
+	TArray<FShard> Shards;
+
+	// Channels in join order. The first one is the default channel for chat messages
+	TArray<FString> Channels;
+
+	// Shard owning each channel
+	TMap<FString, int32> ChannelShards;
+
+	TArray<FHandOver> HandOvers;
+
+	// Ids of the last messages delivered, with RecentIdOrder as the eviction ring
+	TSet<uint64> RecentIds;
+	TArray<uint64> RecentIdOrder;
+	int32 RecentIdHead;
+
+	double NextRebalanceTime;
+
+	FString OAuth;
+	FString Username;
+};
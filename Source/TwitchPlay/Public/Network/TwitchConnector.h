@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FEvent;
+class FInternetAddr;
+class FSocket;
+class ISocketSubsystem;
+
+/**
+ * Opens the connection to the chat server, in the spirit of Happy Eyeballs (RFC 8305).
+ * The host is resolved on a worker thread. Every address it resolves to, IPv4 and IPv6 ones alternating, then gets a
+ * non blocking connection attempt, a new one starting each AttemptDelaySeconds while the previous ones are still pending.
+ * The first attempt to connect wins and the others are closed, all of it within TimeoutSeconds.
+ * Not thread safe, the receiving thread runs it.
+ */
+class TWITCHPLAY_API FTwitchConnector
+{
+public:
+
+	// How often the pending attempts are checked when nothing wakes us up
+	static constexpr uint32 PollMilliseconds = 5;
+
+	/**
+	* @param InHost - Host name or address of the server
+	* @param InPort - Port of the server
+	* @param InTimeoutSeconds - Time the resolution and the connection have, together
+	* @param InAttemptDelaySeconds - Time an attempt has before the next address is tried alongside it
+	*/
+	FTwitchConnector(const FString& InHost, int32 InPort, float InTimeoutSeconds, float InAttemptDelaySeconds);
+	~FTwitchConnector();
+
+	/**
+	* Resolves the host and races the connection attempts.
+	*
+	* @param WakeEvent - Waited on between checks, triggering it makes ShouldStop be checked right away
+	* @param ShouldStop - Gives up when it returns true
+	* @param OutError - Why it failed
+	* @return The connected socket, non blocking, for the caller to destroy. Null if every attempt failed or the time ran out
+	*/
+	FSocket* Connect(FEvent* WakeEvent, TFunctionRef<bool()> ShouldStop, FString& OutError);
+
+private:
+
+	/**
+	* Resolves the host on a worker thread. An answer arriving after we gave up is dropped.
+	*
+	* @param Deadline - FPlatformTime::Seconds() to give up at
+	* @param ShouldStop - Gives up when it returns true
+	* @param OutAddresses - Addresses to try, in order, with the port set
+	* @param OutError - Why it failed
+	* @return False if the host could not be resolved in time
+	*/
+	bool Resolve(double Deadline, TFunctionRef<bool()> ShouldStop, TArray<TSharedRef<FInternetAddr>>& OutAddresses, FString& OutError);
+
+	// Starts a non blocking connection to an address. False if it failed right away
+	bool StartAttempt(const TSharedRef<FInternetAddr>& Address);
+
+	void CloseAttempt(int32 Index);
+
+	ISocketSubsystem* SocketSubsystem;
+
+	FString Host;
+
+	int32 Port;
+
+	double TimeoutSeconds;
+
+	double AttemptDelaySeconds;
+
+	// Sockets still connecting
+	TArray<FSocket*> Attempts;
+};
@@ -0,0 +1,234 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_TWITCHPLAY_MOCK_SERVER
+
+#include <atomic>
+#include "HAL/Runnable.h"
+#include "Parsing/TwitchLineFramer.h"
+
+class FSocket;
+
+// What the mock server sends, and how badly it behaves
+struct FTwitchMockServerSettings
+{
+	// Port to listen on, on the loopback address. 0 picks a free one
+	int32 Port = 6667;
+
+	// Chat messages per second in each joined channel
+	float MessagesPerSecond = 10.0f;
+
+	// Distinct chatters the messages come from
+	int32 NumChatters = 5000;
+
+	// Chance of a chat message holding an emote, and of it being a command
+	float EmoteChance = 0.2f;
+	float CommandChance = 0.05f;
+
+	// Seconds between the server PINGs. 0 for none
+	float PingIntervalSeconds = 60.0f;
+
+	// Chance of each write being cut at a random place, the rest going out in a later packet
+	float FragmentChance = 0.0f;
+
+	// Bytes per second sent to each client, to look like a slow link. 0 for no limit
+	int32 MaxBytesPerSecond = 0;
+
+	// Extra messages sent at once every BurstIntervalSeconds. 0 for no bursts
+	int32 BurstSize = 0;
+	float BurstIntervalSeconds = 10.0f;
+
+	// Seconds after the login the server goes silent without closing the connection. 0 for never
+	float HalfOpenAfterSeconds = 0.0f;
+
+	// Seconds after the login the server sends RECONNECT and closes the connection. 0 for never
+	float ReconnectAfterSeconds = 0.0f;
+
+	// Answer the login with an authentication failure
+	bool bRejectAuth = false;
+
+	// Seed of the generated traffic, the same seed sends the same messages
+	int32 Seed = 0;
+
+	/**
+	* Reads the settings from console arguments like "Port=6667 Rate=500 Fragment=0.5".
+	*
+	* @param Args - The arguments. Missing ones keep their default
+	*/
+	static FTwitchMockServerSettings Parse(const TCHAR* Args);
+};
+
+/**
+ * Loopback Twitch IRC server, for testing the whole socket path offline.
+ * Answers the login, CAP, JOIN, PART and PING like Twitch does, and sends tagged chat messages in every joined
+ * channel at the configured rate. Faults (fragmented lines, slow link, bursts, half open connection, RECONNECT)
+ * are set in the settings or triggered while running.
+ * A single thread serves all the clients with non blocking sockets. Not built in shipping builds.
+ * Also driven from the console, see the TwitchPlay.MockServer commands.
+ */
+class TWITCHPLAY_API FTwitchMockIrcServer : public FRunnable
+{
+public:
+
+	// Generation pauses while a client has more than this waiting to be sent
+	static constexpr int32 MaxPendingBytes = 4 * 1024 * 1024;
+
+	FTwitchMockIrcServer();
+	virtual ~FTwitchMockIrcServer() override;
+
+	/**
+	* Starts listening and serving clients on its own thread.
+	*
+	* @param InSettings - Traffic and faults
+	* @param OutError - Why it failed
+	* @return False if the port could not be bound
+	*/
+	bool Start(const FTwitchMockServerSettings& InSettings, FString& OutError);
+
+	// Closes all the connections and waits for the thread
+	void Shutdown();
+
+	// FRunnable interface.
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+	// Sends extra chat messages to every client right away
+	void TriggerBurst(int32 NumMessages);
+
+	// Sends RECONNECT to every client and closes their connections
+	void TriggerReconnect();
+
+	// Every client connection goes silent without being closed
+	void TriggerHalfOpen();
+
+	// The port listened on, once started
+	int32 GetPort() const
+	{
+		return Port;
+	}
+
+	int32 GetNumClients() const
+	{
+		return NumClients;
+	}
+
+	// Chat messages sent to the clients
+	int64 GetNumMessagesSent() const
+	{
+		return NumMessagesSent;
+	}
+
+	int64 GetNumBytesSent() const
+	{
+		return NumBytesSent;
+	}
+
+	// Chat messages sent by the clients
+	int64 GetNumMessagesReceived() const
+	{
+		return NumMessagesReceived;
+	}
+
+private:
+
+	struct FClient
+	{
+		FSocket* Socket = nullptr;
+
+		FTwitchLineFramer Framer;
+
+		// Bytes waiting to be sent, from PendingOffset on
+		TArray<uint8> Pending;
+		int32 PendingOffset = 0;
+
+		// Login, once NICK was received
+		TArray<ANSICHAR> Nick;
+
+		// Joined channels, with their room id
+		TArray<TPair<FString, int32>> Channels;
+
+		double LoginTime = 0.0;
+		double LastUpdateTime = 0.0;
+		double NextPingTime = 0.0;
+		double NextBurstTime = 0.0;
+
+		// Chat messages owed, the fraction carries over to the next update
+		double MessageBudget = 0.0;
+
+		// Bytes that can be sent right now under MaxBytesPerSecond
+		double ByteBudget = 0.0;
+
+		bool bLoggedIn = false;
+		bool bHalfOpen = false;
+		bool bReconnectSent = false;
+
+		// Closed once everything pending is sent
+		bool bCloseWhenSent = false;
+	};
+
+	void AcceptClients(double Now);
+
+	/**
+	* Reads and answers what the client sent.
+	*
+	* @return False if the client closed the connection
+	*/
+	bool ReadClient(FClient& Client, double Now);
+
+	void HandleLine(FClient& Client, const FAnsiStringView& Line, double Now);
+
+	// Generates the chat messages owed to the client, and the faults due
+	void UpdateClient(FClient& Client, double Now);
+
+	/**
+	* Sends as much of the pending bytes as the socket, the faults and the byte budget allow.
+	*
+	* @return False if the connection failed
+	*/
+	bool FlushClient(FClient& Client, double Now);
+
+	// Appends a tagged PRIVMSG from a random chatter to a random joined channel
+	void AppendChatMessage(FClient& Client);
+
+	static void AppendLine(FClient& Client, const FAnsiStringView& Line);
+
+	void CloseClient(FClient& Client);
+
+	FTwitchMockServerSettings Settings;
+
+	FSocket* Listener;
+
+	FRunnableThread* Thread;
+
+	TArray<TUniquePtr<FClient>> Clients;
+
+	// Traffic generation. Only used by the server thread
+	FRandomStream Random;
+
+	uint64 NextMessageId;
+
+	int32 Port;
+
+	std::atomic<bool> bStopping;
+
+	// Faults requested by another thread, applied by the server thread
+	std::atomic<int32> PendingBurst;
+	std::atomic<bool> bReconnectRequested;
+	std::atomic<bool> bHalfOpenRequested;
+
+	std::atomic<int32> NumClients;
+	std::atomic<int64> NumMessagesSent;
+	std::atomic<int64> NumBytesSent;
+	std::atomic<int64> NumMessagesReceived;
+};
+
+namespace TwitchMockServer
+{
+	// Stops the server started from the console, if any. Called when the module shuts down
+	TWITCHPLAY_API void ShutdownConsoleServer();
+}
+
+#endif // WITH_TWITCHPLAY_MOCK_SERVER
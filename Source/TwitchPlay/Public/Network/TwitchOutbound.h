@@ -0,0 +1,145 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Helpers of the outbound path. Lines are encoded to UTF-8 once, by the thread queuing them,
+ * and the sending thread only copies bytes.
+ */
+namespace TwitchOutbound
+{
+	// Twitch drops chat messages longer than this, counted in bytes of UTF-8 text
+	static constexpr int32 MaxMessageBytes = 500;
+
+	// Twitch rejects a chat message identical to one sent in the same channel less than this ago
+	static constexpr double DuplicateWindowSeconds = 30.0;
+
+	// Put in front of a chunk of a split message that would start with '/' or '.', so Twitch does not run it as a command. A zero width space
+	static constexpr ANSICHAR CommandEscape[] = "\xE2\x80\x8B";
+
+	// A chat message, or a part of one too long to go out as a single message
+	struct FChatChunk
+	{
+		// The command repeated on every chunk, the escape, or empty
+		FAnsiStringView Prefix;
+
+		FAnsiStringView Text;
+	};
+
+	using FChatChunks = TArray<FChatChunk, TInlineAllocator<4>>;
+
+	// Whether Twitch runs the text as a command
+	inline bool IsCommand(const FAnsiStringView& Text)
+	{
+		return Text.Len() > 0 && (Text[0] == '/' || Text[0] == '.');
+	}
+
+	/**
+	* Finds a leading "/w <user> " or "/me ", the commands that apply to the rest of the text and are repeated on every chunk.
+	*
+	* @param Text - UTF-8 message text
+	* @return The length of the command with its trailing space, 0 if the text does not start with one
+	*/
+	TWITCHPLAY_API int32 FindRepeatedCommand(const FAnsiStringView& Text);
+
+	/**
+	* Finds where to cut the first chunk of a text too long for a single chat message.
+	* The cut is on a code point boundary, on the last space of the chunk if there is one in its second half.
+	*
+	* @param Text - UTF-8 text
+	* @param MaxBytes - The chunk size limit
+	* @return The length of the first chunk, Text.Len() if it fits
+	*/
+	TWITCHPLAY_API int32 FindSplit(const FAnsiStringView& Text, int32 MaxBytes);
+
+	/**
+	* Splits a chat message in chunks of at most MaxBytes, prefix included, cut with FindSplit.
+	* A leading /w or /me is repeated on every chunk, so a long whisper stays a whisper. Chunks that would start with '/' or '.'
+	* get the command escape. Other commands are never split, their arguments would go out as chat.
+	*
+	* @param Text - UTF-8 message text
+	* @param MaxBytes - The chunk size limit
+	* @param OutChunks - The chunks, views into Text and CommandEscape
+	* @return False if the text is a command too long to be sent
+	*/
+	TWITCHPLAY_API bool SplitChatMessage(const FAnsiStringView& Text, int32 MaxBytes, FChatChunks& OutChunks);
+
+	// Appends a raw IRC line, UTF-8 encoded, followed by CRLF
+	TWITCHPLAY_API void AppendLine(const FString& Line, TArray<uint8>& OutBuffer);
+
+	/**
+	* Appends a PRIVMSG line with its CRLF.
+	*
+	* @param Channel - UTF-8 channel name, normalized, without the leading #
+	* @param Chunk - UTF-8 message text, already split to size
+	* @param OutBuffer - The buffer the line is appended to
+	*/
+	TWITCHPLAY_API void AppendChatLine(const FAnsiStringView& Channel, const FChatChunk& Chunk, TArray<uint8>& OutBuffer);
+}
+
+/**
+ * Free list of the buffers holding encoded chat lines, so queuing a chat message does not allocate once warm.
+ * Taken from by the game thread, given back by the sending thread once the line is copied out.
+ */
+class TWITCHPLAY_API FTwitchSendBufferPool
+{
+public:
+
+	// Buffers kept at most. More are freed when given back
+	static constexpr int32 MaxPooled = 256;
+
+	// Larger buffers, from long messages, are freed instead of kept
+	static constexpr int32 MaxPooledCapacity = 1024;
+
+	// An empty buffer, with some capacity if one was given back
+	TArray<uint8> Acquire();
+
+	void Release(TArray<uint8>&& Buffer);
+
+private:
+
+	FCriticalSection Lock;
+
+	TArray<TArray<uint8>> FreeBuffers;
+};
+
+/**
+ * Finds chat lines identical to one written to the same channel within Twitch's duplicate window,
+ * which the server would reject anyway. Lines are remembered when they are written, not when they are queued,
+ * as the rate limits may hold them back for a long time. Only used by the sending thread.
+ */
+class TWITCHPLAY_API FTwitchDuplicateFilter
+{
+public:
+
+	FTwitchDuplicateFilter();
+
+	/**
+	* Checks a line against the ones written in the window.
+	*
+	* @param Line - The whole encoded line, channel included
+	* @param Now - Current FPlatformTime::Seconds()
+	* @return True if Twitch would reject the line
+	*/
+	bool IsDuplicate(const TArray<uint8>& Line, double Now) const;
+
+	/**
+	* Remembers a line about to be written.
+	*
+	* @param Line - The whole encoded line, channel included
+	* @param Now - Current FPlatformTime::Seconds()
+	*/
+	void Record(const TArray<uint8>& Line, double Now);
+
+	void Reset();
+
+private:
+
+	// Line hash -> last time it was written
+	TMap<uint64, double> LastSeen;
+
+	// Old entries are forgotten once per window
+	double NextPruneTime;
+};
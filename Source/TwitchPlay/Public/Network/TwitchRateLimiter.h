@@ -0,0 +1,149 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "Data/TwitchStructs.h"
+
+/**
+ * Token bucket holding up to Capacity tokens, where every token spent comes back exactly Window seconds later.
+ * That allows bursts of the full capacity while never going over Capacity sends in any Window long period,
+ * which is how the Twitch server counts. Times are FPlatformTime::Seconds() values.
+ */
+class TWITCHPLAY_API FTwitchTokenBucket
+{
+public:
+
+	explicit FTwitchTokenBucket(int32 InCapacity = 20, double InWindowSeconds = 30.0);
+
+	// Changes the capacity, keeping track of the most recent sends
+	void SetCapacity(int32 NewCapacity);
+
+	// Spends a token if one is available
+	bool TryConsume(double Now);
+
+	// Seconds until a token is available, 0 if one is available now
+	double GetTimeUntilAvailable(double Now) const;
+
+	// The number of tokens available now
+	int32 GetAvailable(double Now) const;
+
+private:
+
+	// Forgets the sends that left the window
+	void Refill(double Now);
+
+	// Ring of the times tokens were spent, oldest first
+	TArray<double> SpendTimes;
+
+	int32 Head;
+
+	int32 Count;
+
+	double WindowSeconds;
+};
+
+/**
+ * Orders the outbound chat messages by priority and sends them as fast as the rate limits allow.
+ * Every channel has its own bucket (privileged channels get a bigger one) and all channels share the account bucket.
+ * A channel waiting for tokens never holds back messages to other channels. Channels take turns within a priority.
+ * Only used by the sending thread.
+ */
+class TWITCHPLAY_API FTwitchSendScheduler
+{
+public:
+
+	FTwitchSendScheduler();
+
+	void Configure(const FTwitchRateLimits& InLimits, double InMinTimeBetweenMessages);
+
+	/**
+	* Queues a chat message.
+	*
+	* @param Message - The message to send
+	* @param Channel - The channel the message goes to, used to pick the bucket
+	*/
+	void Push(FTwitchSendMessage&& Message, const FString& Channel);
+
+	// Queues a channel to join, unless it is already queued. Joins are limited by the join rate instead of the chat rate, and batched in a single JOIN line
+	void PushJoin(const FString& Channel);
+
+	/**
+	* Removes a channel from the pending joins.
+	*
+	* @param Channel - The channel that is not to be joined anymore
+	* @return Whether the channel was still waiting to be joined
+	*/
+	bool CancelJoin(const FString& Channel);
+
+	/**
+	* Gets the next message that can be sent now, if any. Tokens are spent for the returned message.
+	*
+	* @param Now - Current FPlatformTime::Seconds()
+	* @param OutMessage - The message to send. Joins come as a single JOIN_MESSAGE listing the channels, as in "#a,#b,#c"
+	* @param OutWaitSeconds - If no message can be sent, how long until one can. Unchanged if nothing is queued
+	* @return Whether a message can be sent now
+	*/
+	bool Pop(double Now, FTwitchSendMessage& OutMessage, double& OutWaitSeconds);
+
+	// Switches a channel between the normal and the privileged (broadcaster, moderator, VIP) limits
+	void SetChannelPrivileged(const FString& Channel, bool bPrivileged);
+
+	// Whether the bot has the privileged limits in a channel, given by its normalized name
+	bool IsChannelPrivileged(const FString& Channel) const;
+
+	bool IsEmpty() const
+	{
+		return NumPending == 0;
+	}
+
+	// Chat messages and channels to join waiting for the rate limits
+	int32 GetNumPending() const
+	{
+		return NumPending;
+	}
+
+	// Chat messages the account rate limit allows right now
+	int32 GetAccountTokens(const double Now) const
+	{
+		return AccountBucket.GetAvailable(Now);
+	}
+
+private:
+
+	static constexpr int32 NumPriorities = 3;
+
+	struct FChannelState
+	{
+		FTwitchTokenBucket Bucket;
+		bool bPrivileged = false;
+		TQueue<FTwitchSendMessage> Pending[NumPriorities];
+	};
+
+	FChannelState& FindOrAddChannel(const FString& Channel);
+
+	FTwitchRateLimits Limits;
+
+	// Channels, in turn order. Never removed, a bot only talks in a few channels
+	TArray<TUniquePtr<FChannelState>> Channels;
+
+	TMap<FString, int32> ChannelIndices;
+
+	// The channel that sent last, the next turn starts after it
+	int32 LastChannel;
+
+	FTwitchTokenBucket AccountBucket;
+
+	FTwitchTokenBucket JoinBucket;
+
+	// Channels waiting to be joined, in order
+	TArray<FString> PendingJoins;
+
+	// Optional extra spacing between chat messages
+	double MinTimeBetweenMessages;
+
+	double NextMessageTime;
+
+	int32 NumPending;
+};
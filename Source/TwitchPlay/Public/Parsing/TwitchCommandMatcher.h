@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Finds a registered command in a chat message, in the form DELIMITER_Command_DELIMITER.
+ *
+ * The command names are compiled into a trie stored in a flat array, which is immutable until the next Build.
+ * Matching walks the trie from the first delimiter found in the message, one character at a time, and stops
+ * at the first character no command continues with. Messages without a registered command are rejected
+ * without allocating, usually after looking at a single character.
+ */
+class TWITCHPLAY_API FTwitchCommandMatcher
+{
+public:
+
+	FTwitchCommandMatcher();
+
+	/**
+	* Compiles a new set of commands, replacing the previous one.
+	*
+	* @param Names - Command names, aliases included
+	* @param CommandIndices - For each name, the value Match returns for it. Aliases share the index of their command
+	* @param InDelimiter - The command encapsulation characters
+	* @param bInCaseSensitive - If false the names and the messages are compared lowercase
+	*/
+	void Build(const TArray<FString>& Names, const TArray<int32>& CommandIndices, const FString& InDelimiter, bool bInCaseSensitive);
+
+	/**
+	* Finds the first command of a message. Only the first delimited string of the message is considered.
+	*
+	* @param Message - The chat message
+	* @return The index given to Build for the command found, INDEX_NONE if there is none
+	*/
+	int32 Match(const FStringView& Message) const;
+
+	bool IsEmpty() const
+	{
+		return Nodes.Num() <= 1;
+	}
+
+private:
+
+	// Trie node. Children are linked through NextSibling, all nodes live in the Nodes array
+	struct FNode
+	{
+		TCHAR Char;
+		int32 FirstChild;
+		int32 NextSibling;
+		int32 CommandIndex;
+	};
+
+	TCHAR Fold(const TCHAR Char) const
+	{
+		return bCaseSensitive ? Char : FChar::ToLower(Char);
+	}
+
+	int32 FindChild(int32 Node, TCHAR Char) const;
+
+	bool IsDelimiterAt(const FStringView& Message, int32 Position) const;
+
+	// Node 0 is the root
+	TArray<FNode> Nodes;
+
+	FString Delimiter;
+
+	bool bCaseSensitive;
+};
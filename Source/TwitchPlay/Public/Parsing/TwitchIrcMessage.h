@@ -0,0 +1,177 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/TwitchEnums.h"
+
+// Tags we know about. Used to dispatch on tag keys without comparing against every name
+enum class ETwitchIrcTag : uint8
+{
+	Unknown,
+	BadgeInfo,
+	Badges,
+	Bits,
+	Color,
+	DisplayName,
+	Emotes,
+	FirstMsg,
+	Flags,
+	Id,
+	Mod,
+	RoomId,
+	Subscriber,
+	TmiSentTs,
+	Turbo,
+	UserId,
+	UserType,
+	Vip,
+	ReturningChatter,
+	ClientNonce,
+	ReplyParentMsgId,
+	ReplyParentUserId,
+	ReplyParentUserLogin,
+	ReplyParentDisplayName,
+	ReplyParentMsgBody,
+	ReplyThreadParentMsgId,
+	ReplyThreadParentUserLogin,
+	Count
+};
+
+// Badges of a chat message, from the badges tag
+struct FTwitchBadgeSet
+{
+	// One bit per ETwitchBadge
+	uint32 Mask = 0;
+
+	// Version of each badge in Mask, 0 if not a number
+	uint32 Versions[static_cast<int32>(ETwitchBadge::MAX)] = {};
+
+	static constexpr uint32 GetBit(const ETwitchBadge Badge)
+	{
+		return 1u << static_cast<uint32>(Badge);
+	}
+
+	bool Has(const ETwitchBadge Badge) const
+	{
+		return (Mask & GetBit(Badge)) != 0;
+	}
+
+	uint32 GetVersion(const ETwitchBadge Badge) const
+	{
+		return Versions[static_cast<int32>(Badge)];
+	}
+};
+
+// One emote in a chat message, from the emotes tag
+struct FTwitchEmoteRange
+{
+	// Emote id, a view into the tag value
+	FAnsiStringView Id;
+
+	// First and last character of the emote in the message
+	int32 Start = 0;
+	int32 End = 0;
+};
+
+/**
+ * A single IRCv3 line split into its parts: [@tags] [:prefix] command [params] [:trailing]
+ * All the parts are views into the line (UTF-8 bytes), nothing is copied or allocated.
+ * See https://ircv3.net/specs/extensions/message-tags and https://dev.twitch.tv/docs/irc/tags
+ *
+ * Its throughput is measured by the tokenize phase of the TwitchPlay.Benchmark console command, see TwitchBenchmark.h.
+ */
+struct TWITCHPLAY_API FTwitchIrcMessage
+{
+	// Tag block, without the leading '@'. Use FTwitchIrcTagIterator to walk it
+	FAnsiStringView Tags;
+
+	// Message source, without the leading ':'. Usually "nick!user@host" or "tmi.twitch.tv"
+	FAnsiStringView Prefix;
+
+	// Command or numeric reply, e.g. "PRIVMSG", "PING", "001"
+	FAnsiStringView Command;
+
+	// Middle parameters, still separated by spaces
+	FAnsiStringView Params;
+
+	// Trailing parameter, without the leading ':'
+	FAnsiStringView Trailing;
+
+	/**
+	* Splits a line into its parts in a single pass.
+	*
+	* @param Line - The line, without its CRLF terminator
+	* @param OutMessage - The parts found. Views into Line
+	* @return False if the line has no command
+	*/
+	static bool Parse(const FAnsiStringView& Line, FTwitchIrcMessage& OutMessage);
+
+	// The nick part of the prefix, before the '!'
+	FAnsiStringView GetNick() const;
+
+	// The first middle parameter, usually the channel
+	FAnsiStringView GetFirstParam() const;
+
+	// True if the command is exactly Name
+	bool IsCommand(const FAnsiStringView& Name) const
+	{
+		return Command.Len() == Name.Len() && FMemory::Memcmp(Command.GetData(), Name.GetData(), Name.Len()) == 0;
+	}
+};
+
+/**
+ * Walks the tags of a tag block, one key/value pair at a time, without allocating.
+ * Values are returned raw, with the IRCv3 escapes (\s, \:, ...) still in place.
+ */
+class TWITCHPLAY_API FTwitchIrcTagIterator
+{
+public:
+
+	explicit FTwitchIrcTagIterator(const FAnsiStringView& InTags)
+		: Tags(InTags)
+		, Position(0)
+	{
+	}
+
+	/**
+	* Gets the next tag.
+	*
+	* @param OutKey - The tag name
+	* @param OutValue - The raw tag value, empty if the tag has no value
+	* @return False when there are no tags left
+	*/
+	bool Next(FAnsiStringView& OutKey, FAnsiStringView& OutValue);
+
+private:
+
+	FAnsiStringView Tags;
+
+	int32 Position;
+};
+
+namespace TwitchIrc
+{
+	// Finds out which known tag a key is. Dispatches on the key length first, so at most a couple of compares are made
+	TWITCHPLAY_API ETwitchIrcTag ClassifyTag(const FAnsiStringView& Key);
+
+	// Parses an unsigned decimal number. Returns false if the view is empty or contains anything but digits
+	TWITCHPLAY_API bool ParseUInt64(const FAnsiStringView& Value, uint64& OutValue);
+
+	// Parses a "#RRGGBB" color. Returns false if the value is not in that form
+	TWITCHPLAY_API bool ParseColor(const FAnsiStringView& Value, FColor& OutColor);
+
+	// Parses a badges (or badge-info) tag value, "name/version" pairs separated by commas. Unknown badges are skipped
+	TWITCHPLAY_API void ParseBadges(const FAnsiStringView& Value, FTwitchBadgeSet& OutBadges);
+
+	/**
+	* Parses an emotes tag value, e.g. "25:0-4,12-16/1902:6-10". Ranges are appended, the array is not reset.
+	*
+	* @param Value - The raw tag value
+	* @param OutRanges - The emotes found, with Start and End in code points of the message as Twitch sends them
+	*/
+	TWITCHPLAY_API void ParseEmotes(const FAnsiStringView& Value, TArray<FTwitchEmoteRange>& OutRanges);
+
+	// Decodes a UTF-8 tag value, turning the IRCv3 escapes (\s, \:, \\, \r, \n) back into what they stand for
+	TWITCHPLAY_API void UnescapeTagValue(const FAnsiStringView& Value, FString& OutValue);
+}
@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Splits the raw IRC byte stream into lines.
+ *
+ * Data is received straight into a fixed buffer that is allocated once. Complete lines are handed out as views
+ * into that buffer, without the CRLF terminator. A line cut across two reads stays in the buffer and is completed
+ * by the next read: only that incomplete tail is moved back to the front of the buffer before receiving again.
+ * Lines longer than the maximum length are dropped as a whole.
+ *
+ * Usage: GetWriteBuffer -> Recv into it -> CommitWrite -> PopLine until it returns false.
+ * Line views are only valid until the next call to GetWriteBuffer.
+ */
+class TWITCHPLAY_API FTwitchLineFramer
+{
+public:
+
+	// IRCv3 allows 8191 bytes of tags plus 512 bytes of message
+	static constexpr int32 DefaultMaxLineLength = 16 * 1024;
+
+	static constexpr int32 DefaultCapacity = 64 * 1024;
+
+	explicit FTwitchLineFramer(int32 InCapacity = DefaultCapacity, int32 InMaxLineLength = DefaultMaxLineLength);
+
+	/**
+	* Gets the free space where new data can be received.
+	* Moves any incomplete line to the front of the buffer first, which invalidates the views returned by PopLine.
+	*
+	* @param OutSize - The number of bytes that can be written
+	* @return The start of the free space
+	*/
+	uint8* GetWriteBuffer(int32& OutSize);
+
+	/**
+	* Marks bytes written to the buffer returned by GetWriteBuffer as received.
+	*
+	* @param NumBytes - The number of bytes written
+	*/
+	void CommitWrite(int32 NumBytes);
+
+	/**
+	* Gets the next complete line, without its CRLF terminator. Empty lines are skipped.
+	*
+	* @param OutLine - View into the receive buffer, valid until the next GetWriteBuffer call
+	* @return False if there is no complete line left
+	*/
+	bool PopLine(FAnsiStringView& OutLine);
+
+	// Drops all the buffered data
+	void Reset();
+
+	// The number of lines dropped because they were longer than the maximum line length
+	int32 GetNumOversizedLines() const
+	{
+		return NumOversizedLines;
+	}
+
+private:
+
+	TArray<uint8> Buffer;
+
+	// Start of the first line not handed out yet
+	int32 ReadPos;
+
+	// Everything between ReadPos and ScanPos is known not to contain a line feed
+	int32 ScanPos;
+
+	// End of the received data
+	int32 WritePos;
+
+	int32 MaxLineLength;
+
+	// True while skipping the rest of an oversized line
+	bool bDiscarding;
+
+	int32 NumOversizedLines;
+};
@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/TwitchStructs.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "TwitchMessageLibrary.generated.h"
+
+/**
+ * Blueprint access to the tags of the chat messages. Tags are decoded when asked for, not when received.
+ */
+UCLASS()
+class TWITCHPLAY_API UTwitchMessageLibrary : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+
+	/**
+	* Whether the sender has a badge in the channel of the message.
+	*
+	* @param Message - The chat message.
+	* @param Badge - The badge.
+	*/
+	UFUNCTION(BlueprintPure, Category = "Twitch|Message Tags")
+	static bool HasBadge(const FTwitchChatMessage& Message, ETwitchBadge Badge);
+
+	/**
+	* Version of a badge of the sender, e.g. the subscriber tier or the cheered amount. 0 if the sender does not have it.
+	*
+	* @param Message - The chat message.
+	* @param Badge - The badge.
+	*/
+	UFUNCTION(BlueprintPure, Category = "Twitch|Message Tags")
+	static int32 GetBadgeVersion(const FTwitchChatMessage& Message, ETwitchBadge Badge);
+
+	/**
+	* Whether the sender is a moderator of the channel of the message.
+	*
+	* @param Message - The chat message.
+	*/
+	UFUNCTION(BlueprintPure, Category = "Twitch|Message Tags")
+	static bool IsModerator(const FTwitchChatMessage& Message);
+
+	/**
+	* Whether this is the first message of the sender in the channel.
+	*
+	* @param Message - The chat message.
+	*/
+	UFUNCTION(BlueprintPure, Category = "Twitch|Message Tags")
+	static bool IsFirstMessage(const FTwitchChatMessage& Message);
+
+	/**
+	* Unique id of the message, used to reply to it or delete it.
+	*
+	* @param Message - The chat message.
+	*/
+	UFUNCTION(BlueprintPure, Category = "Twitch|Message Tags")
+	static FString GetMessageId(const FTwitchChatMessage& Message);
+
+	/**
+	* Id of the channel the message was sent to. 0 if unknown.
+	*
+	* @param Message - The chat message.
+	*/
+	UFUNCTION(BlueprintPure, Category = "Twitch|Message Tags")
+	static int64 GetRoomId(const FTwitchChatMessage& Message);
+
+	/**
+	* The message this one replies to, if any.
+	*
+	* @param Message - The chat message.
+	* @param OutMessageId - Id of the message replied to.
+	* @param OutUserLogin - Login of the sender of the message replied to.
+	* @param OutDisplayName - Display name of the sender of the message replied to.
+	* @param OutMessageBody - Text of the message replied to.
+	*
+	* @return False if the message is not a reply.
+	*/
+	UFUNCTION(BlueprintPure, Category = "Twitch|Message Tags")
+	static bool GetReplyParent(const FTwitchChatMessage& Message, FString& OutMessageId, FString& OutUserLogin, FString& OutDisplayName, FString& OutMessageBody);
+
+	/**
+	* Emotes in the message, in the order they appear.
+	*
+	* @param Message - The chat message.
+	*/
+	UFUNCTION(BlueprintPure, Category = "Twitch|Message Tags")
+	static TArray<FTwitchEmoteSpan> GetMessageEmotes(const FTwitchChatMessage& Message);
+
+	/**
+	* Any tag of the message, by name.
+	*
+	* @param Message - The chat message.
+	* @param Key - The tag name, e.g. "msg-id".
+	* @param OutValue - The tag value, unescaped.
+	*
+	* @return False if the message does not have the tag.
+	*/
+	UFUNCTION(BlueprintPure, Category = "Twitch|Message Tags")
+	static bool GetMessageTag(const FTwitchChatMessage& Message, const FString& Key, FString& OutValue);
+};
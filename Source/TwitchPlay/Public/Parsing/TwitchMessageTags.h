@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/TwitchTextSlab.h"
+#include "Parsing/TwitchIrcMessage.h"
+
+/**
+ * All the IRCv3 tags of a received chat message, kept as the raw tag block and decoded on demand.
+ * The first lookup walks the block once and remembers where each known tag is, the following ones go straight to it.
+ * Holds a reference to the text slab the message came in, so a copy stays valid after the frame it was delivered.
+ * Not thread safe, meant for the game thread.
+ */
+class TWITCHPLAY_API FTwitchMessageTags
+{
+public:
+
+	FTwitchMessageTags();
+
+	/**
+	* Points at the tag block of another message. Nothing is decoded until asked for.
+	*
+	* @param InSlab - Slab holding the tag block
+	* @param InTags - The tag block, without the leading '@'
+	*/
+	void Reset(const TRefCountPtr<FTwitchTextSlab>& InSlab, const FTwitchTextSpan& InTags);
+
+	// The whole tag block, UTF-8 and still escaped. Empty if the message had no tags
+	FAnsiStringView GetRaw() const;
+
+	/**
+	* Finds a known tag.
+	*
+	* @param Tag - The tag
+	* @param OutValue - The raw value, still escaped
+	* @return False if the message does not have the tag
+	*/
+	bool GetRawValue(ETwitchIrcTag Tag, FAnsiStringView& OutValue) const;
+
+	/**
+	* Finds any tag by name, known or not. Walks the tag block.
+	*
+	* @param Key - The tag name, e.g. "msg-id"
+	* @param OutValue - The raw value, still escaped
+	* @return False if the message does not have the tag
+	*/
+	bool FindRawValue(const FAnsiStringView& Key, FAnsiStringView& OutValue) const;
+
+	// Unescaped value of a known tag. Returns false if the message does not have it
+	bool GetString(ETwitchIrcTag Tag, FString& OutValue) const;
+
+	// Value of a known numeric tag. Returns false if the message does not have it or it is not a number
+	bool GetUInt64(ETwitchIrcTag Tag, uint64& OutValue) const;
+
+	// True if the known tag is "1"
+	bool GetBool(ETwitchIrcTag Tag) const;
+
+	// Badges and their versions, decoded on the first call
+	const FTwitchBadgeSet& GetBadges() const;
+
+	/**
+	* Decodes the emotes of the message.
+	*
+	* @param Text - The message text, as delivered
+	* @param OutRanges - Reset, then filled with the emotes in the order they appear. Start and End are indices in Text
+	*/
+	void GetEmotes(const FString& Text, TArray<FTwitchEmoteRange>& OutRanges) const;
+
+private:
+
+	// Finds where each known tag is
+	void IndexTags() const;
+
+	TRefCountPtr<FTwitchTextSlab> Slab;
+
+	FTwitchTextSpan Tags;
+
+	// Value of each known tag in the slab. An INDEX_NONE offset for the tags the message does not have
+	mutable FTwitchTextSpan Values[static_cast<int32>(ETwitchIrcTag::Count)];
+
+	mutable FTwitchBadgeSet Badges;
+
+	mutable bool bIndexed;
+
+	mutable bool bBadgesDecoded;
+};
@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * UTF-8 to TCHAR conversion for the text received from Twitch.
+ * Pure ASCII runs are validated and widened 32 bytes at a time with SSE2/NEON, which covers most chat messages.
+ * Other characters go through a scalar validating decoder, one code point at a time; invalid sequences become U+FFFD.
+ * Mostly non-ASCII text (CJK, Cyrillic) therefore runs at scalar speed. Vectorizing 2 and 3 byte sequences needs byte
+ * shuffles SSE2 does not have, and is not done.
+ */
+namespace TwitchUtf8
+{
+	/**
+	* Decodes UTF-8 text into an existing string, reusing its allocation when it is large enough.
+	*
+	* @param Utf8 - UTF-8 bytes to decode
+	* @param OutString - Receives the decoded text
+	*/
+	TWITCHPLAY_API void Decode(const FAnsiStringView& Utf8, FString& OutString);
+
+	// Decodes UTF-8 text into a new string
+	inline FString ToString(const FAnsiStringView& Utf8)
+	{
+		FString Result;
+		Decode(Utf8, Result);
+		return Result;
+	}
+}
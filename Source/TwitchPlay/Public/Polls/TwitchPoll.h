@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/TwitchStructs.h"
+
+/**
+ * Chat poll with a fixed set of options and a time window. One vote per user, a user voting again changes their vote.
+ *
+ * Votes are counted on the receiving threads, straight from the received UTF-8 message, so a vote never goes
+ * through Blueprint. A chat message is a vote when its first word is one of the options, ignoring case.
+ * The voters are kept in an open addressing table of user ids that grows by doubling, the counts in a dense array.
+ * The game thread takes a copy of the results at most once per frame, only when they changed.
+ */
+class TWITCHPLAY_API FTwitchPoll
+{
+public:
+
+	/**
+	* @param InOptions - What chat can vote for. Each option is a single word
+	* @param DurationSeconds - How long the poll is open. 0 or less to keep it open until closed
+	* @param bInAllowVoteChange - Whether voting again moves the vote to the new option
+	*/
+	FTwitchPoll(const TArray<FString>& InOptions, float DurationSeconds, bool bInAllowVoteChange);
+
+	/**
+	* Counts a vote if the message is one. Called from the receiving threads.
+	*
+	* @param UserId - The voter, from the user-id tag. 0 is ignored
+	* @param Message - The chat message, UTF-8
+	* @param Now - Current FPlatformTime::Seconds()
+	* @return Whether the message was a counted vote
+	*/
+	bool Vote(uint64 UserId, const FAnsiStringView& Message, double Now);
+
+	// Stops counting votes
+	void Close();
+
+	bool IsOpen(double Now) const;
+
+	/**
+	* Copies the results if they changed since the last call.
+	*
+	* @param Now - Current FPlatformTime::Seconds()
+	* @param OutResults - The results
+	* @return False if nothing changed
+	*/
+	bool ConsumeResults(double Now, FTwitchPollResults& OutResults);
+
+	// Copies the results, changed or not
+	void GetResults(double Now, FTwitchPollResults& OutResults) const;
+
+private:
+
+	// Index of the option the first word of the message is, INDEX_NONE if it is not one
+	int32 FindOption(const FAnsiStringView& Message) const;
+
+	// Slot of the user in the voters table, either holding the user or empty
+	int32 FindVoterSlot(uint64 UserId) const;
+
+	void GrowVoters();
+
+	TArray<FString> Options;
+
+	// Options lowercase and UTF-8 encoded, as they are compared against the messages
+	TArray<TArray<ANSICHAR>> OptionKeys;
+
+	TArray<int32> Counts;
+
+	// Voters table, power of two sized with linear probing. A 0 id is an empty slot
+	TArray<uint64> VoterIds;
+	TArray<uint8> VoterOptions;
+	int32 NumVoters;
+
+	double EndTime;
+
+	bool bAllowVoteChange;
+
+	bool bClosed;
+
+	// Set when a vote is counted, cleared when the results are consumed
+	bool bChanged;
+
+	// Votes come from all the receiving threads
+	mutable FCriticalSection Lock;
+};
@@ -3,31 +3,91 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include <atomic>
+#include "Data/TwitchBoundedQueue.h"
 #include "Data/TwitchEnums.h"
+#include "Data/TwitchReceiveBatch.h"
 #include "Data/TwitchStructs.h"
+#include "Network/TwitchCapture.h"
+#include "Network/TwitchOutbound.h"
+#include "Network/TwitchRateLimiter.h"
+#include "Parsing/TwitchLineFramer.h"
+#include "Polls/TwitchPoll.h"
 
 /**
  * Twitch messages receiver runnable
+ * Everything received is queued for the game thread, which pulls it once per frame. No callback runs on the worker threads.
  */
 class FTwitchMessageReceiver : public FRunnable
 {
 public:	
 
-	TFunction<void(const FTwitchChatMessage& Messages)> ReceiveMessages;
-	TFunction<void(const FTwitchConnection& Connections)> ReceiveConnections;
-
-	using FTwitchReceiveMessagesQueue = TQueue<FTwitchReceiveMessages, EQueueMode::Spsc>;
+	using FTwitchReceiveMessagesQueue = TTwitchBoundedQueue<FTwitchReceivedMessage>;
 	using FTwitchSendMessagesQueue = TQueue<FTwitchSendMessage, EQueueMode::Spsc>;
-	using FTwitchConnectionQueue = TQueue<FTwitchConnection, EQueueMode::Spsc>;
+
+	// Both the receiving and the sending thread report connection messages
+	using FTwitchConnectionQueue = TTwitchBoundedQueue<FTwitchConnection>;
+
+	// Connection messages are few, unless the server messages echo is on
+	static constexpr int32 MaxQueuedConnectionMessages = 1024;
+
+	// Keeps a batched PART line well within the 512 bytes IRC line limit
+	static constexpr int32 MaxChannelListLength = 480;
+
+	// Longest the sending thread waits for the socket to have room before it checks its queues again
+	static constexpr uint32 WritableRetryMilliseconds = 5;
 
 protected:
 
 private:
+
+	enum class ETwitchAuthResult : uint8
+	{
+		AUTHENTICATED,
+		// The server answered with something else than the welcome message, usually a bad token
+		REJECTED,
+		// No answer, or the connection closed
+		FAILED
+	};
+
+	enum class ETwitchSessionEnd : uint8
+	{
+		STOPPED,
+		LOST,
+		// The server sent RECONNECT
+		RECONNECT_REQUESTED
+	};
+
+	// Runs the sending loop on its own thread, so the receiving thread can block on the socket
+	class FTwitchSendWorker : public FRunnable
+	{
+	public:
+		explicit FTwitchSendWorker(FTwitchMessageReceiver& InOwner) : Owner(InOwner) {}
+		virtual uint32 Run() override { return Owner.RunSender(); }
+
+	private:
+		FTwitchMessageReceiver& Owner;
+	};
 	
 	// Sending and receiving queues
 	TUniquePtr<FTwitchSendMessagesQueue> SendingQueue;
 	TUniquePtr<FTwitchReceiveMessagesQueue> ReceivingQueue;
 
+	// Slabs holding the text of the received messages until the game thread delivers them
+	TSharedRef<FTwitchTextSlabPool, ESPMode::ThreadSafe> SlabPool;
+
+	// Batch being parsed. Only used by the receiving thread, reused for every read
+	FTwitchReceiveMessages ReceiveBatch;
+
+	// Raw IRC lines (PONG, CAP, ...) queued by the receiving thread. Not subject to the rate limits
+	TUniquePtr<FTwitchSendMessagesQueue> ControlQueue;
+
+	// Channels where the bot privileges changed, found by the receiving thread in USERSTATE messages
+	TQueue<TPair<FString, bool>, EQueueMode::Spsc> ChannelPrivilegeQueue;
+
+	// Last privileges seen per channel. Only used by the receiving thread
+	TMap<FString, bool> ChannelPrivileges;
+
 	// Connection status queue
 	TUniquePtr<FTwitchConnectionQueue> ConnectionQueue;
 
@@ -35,48 +95,208 @@ private:
 
 	FRunnableThread* MessagesThread;
 
+	FTwitchSendWorker SendWorker;
+
+	FRunnableThread* SenderThread;
+
+	// Wakes the sending thread when a message is queued or the connection is stopping
+	FEvent* SendEvent;
+
+	// Wakes the receiving thread while it waits to reconnect
+	FEvent* WakeEvent;
+
+	// Guards ConnectionSocket against being destroyed while another thread wakes it up
+	mutable FCriticalSection SocketLock;
+
 	FThreadSafeBool bShouldExit;
 
 	FThreadSafeBool bIsConnected;
 
+	// Set by the receiving thread after a reconnection, the sending thread then joins the channels again
+	FThreadSafeBool bRestoreChannels;
+
+	// Seconds it took to get the last lost connection back
+	std::atomic<double> LastRecoverySeconds;
+
 	// Authentication token. Need to get it from official Twitch API
 	FString OAuth;
 
 	// Username. Must be in lowercase
 	FString Username;
 
-	// Channel to join upon successful connection	
-	FString Channel;
+	// Channels joined, or to join upon successful connection. The first one is the default channel for chat messages
+	TArray<FString> Channels;
 
-	// True while we are waiting for the auth reply from the server
-	bool bWaitingForAuth;
+	// Guards Channels, changed by the game thread and read by the receiving thread
+	mutable FCriticalSection ChannelsLock;
 
-	// The number of times auth has slept
-	int32 NumAuthWaits;
+	// True while we wait for the answer to our keep alive PING. Only used by the receiving thread
+	bool bPingPending;
 
-	// A time accumulator while the thread is running. Precision isn't great, but accurate enough for general timing.
-	float AccumulationTime;
+	// The server sent RECONNECT. Only used by the receiving thread
+	bool bReconnectRequested;
 
 	// The set time between messages
 	float TimeBetweenMessages;
 
-	// The next time to send a message
-	float NextSendMessageTime;
+	// Sends the queued messages as fast as the rate limits allow. Only used by the sending thread
+	FTwitchSendScheduler SendScheduler;
+
+	// Channels to leave, batched each time the sending thread wakes up. Only used by the sending thread
+	TArray<FString> PartChannels;
+
+	// Buffers of the encoded chat lines, taken by the game thread and given back by the sending thread
+	TUniquePtr<FTwitchSendBufferPool> SendBufferPool;
+
+	// Chat lines written in the duplicate window, Twitch would reject them again. Only used by the sending thread
+	FTwitchDuplicateFilter DuplicateFilter;
+
+	// Lines ready to go out, written to the socket together once per wake up. Only used by the sending thread
+	TArray<uint8> OutboundBuffer;
+
+	// Bytes waiting for the socket to take them, in order. The socket is non blocking, a write takes what fits
+	TArray<uint8> PendingSendBytes;
+
+	// Bytes at the start of PendingSendBytes already sent
+	int32 PendingSendOffset;
+
+	// Guards PendingSendBytes and PendingSendOffset, filled and flushed by both worker threads. Taken before SocketLock
+	FCriticalSection PendingSendLock;
+
+	// Splits the received data into lines. Only used by the receiving thread
+	FTwitchLineFramer LineFramer;
+
+	// Queue sizes, raw lines echo, rate limits and reconnection
+	FTwitchReceiverSettings Settings;
+
+	// Poll the received chat messages vote in, if any
+	TSharedPtr<FTwitchPoll, ESPMode::ThreadSafe> Poll;
+
+	// Guards Poll, set by the game thread
+	mutable FCriticalSection PollLock;
+
+	// Jitter of the reconnection delays. Only used by the receiving thread
+	FRandomStream ReconnectRandom;
+
+	// Records every socket read while set
+	TUniquePtr<FTwitchCaptureWriter> CaptureWriter;
+
+	// Guards CaptureWriter, started and stopped by the game thread
+	mutable FCriticalSection CaptureLock;
+
+	// Capture played instead of connecting, if not empty
+	FString ReplayFilename;
+
+	// Replay speed factor. 0 or less replays as fast as possible
+	float ReplaySpeed;
+
+	// Lines of the read being parsed, views into the line framer. Only used by the receiving thread
+	TArray<FAnsiStringView> FramedLines;
+
+	// Pipeline counters. Each one is written by a single worker thread and read by the game thread
+	std::atomic<int64> NumBytesReceived;
+	std::atomic<int64> NumLinesReceived;
+	std::atomic<double> ParseSeconds;
+	std::atomic<int64> NumMessagesSent;
+	std::atomic<int64> NumDuplicatesDropped;
+	std::atomic<double> SendWaitSeconds;
+	std::atomic<int32> NumSendPending;
+	std::atomic<int32> NumOutboundTokens;
+
+	// Bytes not sent yet, read by the game thread to refuse chat while the socket is behind
+	std::atomic<int32> NumPendingSendBytes;
+
+	// Written by the game thread
+	mutable std::atomic<int64> NumMessagesRejected;
 
 public:
 
 	FTwitchMessageReceiver();
 	virtual ~FTwitchMessageReceiver() override;
 
-	void StartConnection(const FString& oAuth, const FString& username, const FString& channel, const float timeBetweenMessages);
+	void StartConnection(const FString& oAuth, const FString& username, const FString& channel, const float timeBetweenMessages, const FTwitchReceiverSettings& settings = FTwitchReceiverSettings());
+
+	/**
+	* Plays a capture file instead of connecting. The recorded reads go through the same framing and parsing as live
+	* ones, paced by their recorded times. Nothing is sent during a replay.
+	*
+	* @param filename - The capture file
+	* @param speed - Replay speed factor, 2 plays twice as fast. 0 or less plays as fast as the messages are parsed
+	* @param settings - Queue sizes and raw lines echo, the network settings are not used
+	*/
+	void StartReplay(const FString& filename, const float speed, const FTwitchReceiverSettings& settings = FTwitchReceiverSettings());
+
+	/**
+	* Sets up the queues without connecting or starting any thread, so ProcessReceivedBytes and PullMessages can be
+	* called one after the other from a single thread. Used by the benchmarks.
+	*
+	* @param settings - Queue sizes and raw lines echo, the network settings are not used
+	*/
+	void StartOffline(const FTwitchReceiverSettings& settings = FTwitchReceiverSettings());
+
+	/**
+	* Starts recording every socket read to a capture file. Game thread only
+	*
+	* @param filename - The capture file, replaced if it exists
+	* @return False if the file could not be created
+	*/
+	bool StartCapture(const FString& filename);
+
+	// Stops recording and closes the capture file. Done by the receiving thread too once the connection is stopped
+	void StopCapture();
+
+	bool IsCapturing() const;
+
+	/**
+	* Frames and parses received bytes as if they had just been read from the socket. Receiving thread only, or any single thread after StartOffline
+	*
+	* @param Data - The bytes received
+	* @param Size - The number of bytes received
+	*/
+	void ProcessReceivedBytes(const uint8* Data, int32 Size);
 
 	// FRunnable interface.
 	virtual uint32 Run() override;
 	virtual void Stop() override;
 	virtual void Exit() override;
 
-	void PullMessages(TArray<FString>& OutUsernames, TArray<FString>& OutMessages) const;
-	void SendMessage(const ETwitchSendMessageType type, const FString& message, const FString& channel) const;
+	// Moves all the chat messages received since the last call into OutMessages. Game thread only
+	void PullMessages(TArray<FTwitchReceivedMessage>& OutMessages) const;
+
+	/**
+	* Queues a message for the sending thread. Game thread only
+	* Chat messages are encoded to UTF-8 right away, and split on code point boundaries when over 500 bytes.
+	* A split /w or /me is repeated on every part, other commands over 500 bytes are refused.
+	* A chat message identical to one sent to the same channel in the last 30 seconds is dropped with an error, Twitch would reject it.
+	* Chat messages are refused while more than Settings.MaxPendingSendBytes wait for the socket.
+	*
+	* @param type - The message type
+	* @param message - The text, or the raw IRC line
+	* @param channel - The channel, with or without the leading #. The default channel if empty
+	* @param priority - Chat messages with a higher priority are sent first
+	* @return False if the message was refused
+	*/
+	bool SendMessage(const ETwitchSendMessageType type, const FString& message, const FString& channel, const ETwitchMessagePriority priority = ETwitchMessagePriority::NORMAL) const;
+
+	/**
+	* Adds channels to the joined set. The JOINs are batched and paced to the join rate limit. Game thread only
+	*
+	* @param channels - Channel names, with or without the leading #
+	*/
+	void JoinChannels(const TArray<FString>& channels);
+
+	/**
+	* Removes channels from the joined set, leaving them. Game thread only
+	*
+	* @param channels - Channel names, with or without the leading #
+	*/
+	void LeaveChannels(const TArray<FString>& channels);
+
+	// The channels joined, or to join upon connection
+	TArray<FString> GetJoinedChannels() const;
+
+	// Sets the poll the chat messages vote in, null for none. The votes are counted on the receiving thread
+	void SetPoll(const TSharedPtr<FTwitchPoll, ESPMode::ThreadSafe>& InPoll);
 	bool PullConnectionMessage(ETwitchConnectionMessageType& OutStatus, FString& OutMessage) const;
 
 	void StopConnection(bool bWaitTillComplete);
@@ -86,33 +306,157 @@ public:
 		return bIsConnected;
 	}
 
+	// Seconds between losing the connection and being connected again, for the last reconnection. 0 if none
+	double GetLastRecoverySeconds() const
+	{
+		return LastRecoverySeconds;
+	}
+
+	// The number of chat messages dropped because the game thread did not pull them in time
+	int64 GetNumDroppedMessages() const
+	{
+		return ReceivingQueue.IsValid() ? ReceivingQueue->GetNumDropped() : 0;
+	}
+
+	// The number of chat messages waiting for the game thread to pull them
+	int32 GetReceiveQueueDepth() const
+	{
+		return ReceivingQueue.IsValid() ? ReceivingQueue->Num() : 0;
+	}
+
+	/**
+	* Adds the pipeline counters of this connection to a snapshot. Game thread only
+	*
+	* @param OutStats - The snapshot the counters are added to. Its averages are not updated
+	*/
+	void AddPipelineStats(FTwitchPipelineStats& OutStats) const;
+
 	void GetConnectionInfo(FString& OutOAuth, FString& OutUsername, FString& OutChannel) const
 	{
 		OutOAuth = OAuth;
 		OutUsername = Username;
-		OutChannel = Channel;
+		OutChannel = GetDefaultChannel();
 	}
 
+	// Lowercase channel name without the leading #, as used by the receiver
+	static FString NormalizeChannel(const FString& channel);
+
 protected:
 
 private:
 
-	void SleepReceiver(float seconds);
+	uint32 RunSender();
 
-	FString ReceiveFromConnection() const;
+	/**
+	* Connects the socket to the server and sends the PASS and NICK messages.
+	* All the addresses the server resolves to are raced, within Settings.ConnectTimeoutSeconds. A stop request gives up right away.
+	*
+	* @param OutError - Why it failed
+	* @return Whether the socket is connected
+	*/
+	bool Connect(FString& OutError);
 
 	/**
-	* Parses the message received from Twitch IRC chat in order to only get the content of the message.
-	* Since a single "message" could actually include multiple lines an array of strings is returned.
+	* Waits for the server answer to PASS and NICK.
 	*
-	* @param Message - Message to parse
+	* @param OutMessage - The welcome line, or why it failed
 	*/
-	void ParseMessage(const FString& Message) const;
+	ETwitchAuthResult Authenticate(FString& OutMessage);
 
 	/**
-	* Send a message on the connected socket
-	* @param message - The message to send
-	* @param channel - The channel (or user) to send this message to
+	* Receives on the authenticated connection until it is lost or we are stopping.
+	*
+	* @param bResumed - True for a reconnection, the joined channels are restored
 	*/
-	bool SendIRCMessage(const FString& message, const FString channel = TEXT("")) const;
+	ETwitchSessionEnd RunSession(bool bResumed);
+
+	// Plays the replay file until its end or we are stopping
+	uint32 RunReplay();
+
+	// Seconds to wait before the next reconnection attempt
+	double GetReconnectDelay(int32 NumFailedAttempts);
+
+	// The channel chat messages without a channel go to. Empty if no channel is joined
+	FString GetDefaultChannel() const;
+
+	/**
+	* Queues a command taking a comma separated channel list to the outbound buffer, split in as many lines as needed.
+	*
+	* @param Command - The command, like PART
+	* @param ChannelList - Channels to list, without the leading #
+	*/
+	void SendChannelListCommand(const TCHAR* Command, const TArray<FString>& ChannelList);
+
+	// Wakes up both threads so they can notice a stop request without waiting for socket activity
+	void WakeThreads();
+
+	// Closes and destroys the connection socket, if any
+	void DestroySocket();
+
+	// Handles a single message from the sending queue once the rate limits allow it, appending it to the outbound buffer
+	void ProcessSendMessage(FTwitchSendMessage& SendMessage);
+
+	// Whether Twitch would reject a chat message as a duplicate of one written to its channel
+	bool IsDuplicateChat(const FTwitchSendMessage& SendMessage, double Now) const;
+
+	// Drops a duplicate chat message, counting it and reporting it to the game thread
+	void DropDuplicateChat(FTwitchSendMessage& SendMessage);
+
+	// Moves the outbound buffer to the pending bytes and writes what the socket takes
+	void FlushOutbound();
+
+	// Looks for the bot privileges in a USERSTATE message, they decide which rate limit applies to the channel
+	void ParseUserState(const struct FTwitchIrcMessage& IrcMessage);
+
+	/**
+	* Receives the pending data on the socket into the line framer.
+	* 
+	* @return False if the socket was closed by the other end
+	*/
+	bool ReceiveFromConnection();
+
+	// Parses all the complete lines received so far and queues the resulting chat messages
+	void ParseReceivedLines();
+
+	/**
+	* Parses a single line received from Twitch IRC chat in order to only get the content of the message.
+	*
+	* @param MessageLine - Line to parse (UTF-8), without its CRLF terminator
+	* @param TwitchMessages - Batch the parsed chat message is added to
+	* @param ActivePoll - Poll the chat message votes in, if any
+	*/
+	void ParseMessage(const FAnsiStringView& MessageLine, FTwitchReceiveMessages& TwitchMessages, FTwitchPoll* ActivePoll);
+
+	/**
+	* Queues a raw IRC line ahead of anything queued later and writes what the socket takes right away, never waiting for it.
+	* For the login and the keep alive, chat goes through the sending thread
+	* @param message - The line to send, without its CRLF
+	*/
+	bool SendIRCMessage(const FString& message);
+
+	/**
+	* Appends bytes to the ones waiting for the socket.
+	*
+	* @param Data - The bytes to send
+	* @param Size - The number of bytes
+	*/
+	void QueueBytes(const uint8* Data, int32 Size);
+
+	/**
+	* Writes the pending bytes to the socket until it would block. The rest stays queued for the next flush.
+	*
+	* @return False if not connected or the connection failed
+	*/
+	bool FlushPendingBytes();
+
+	/**
+	* Blocks the sending thread until the socket has room for more bytes.
+	*
+	* @param TimeoutMilliseconds - Longest wait, kept short as the send event is not watched meanwhile
+	* @return False on timeout or if there is no socket
+	*/
+	bool WaitUntilWritable(uint32 TimeoutMilliseconds);
+
+	// Forgets the pending bytes, they were meant for a connection that is gone
+	void ResetPendingBytes();
 };
\ No newline at end of file
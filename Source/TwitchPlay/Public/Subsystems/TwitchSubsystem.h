@@ -3,7 +3,13 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "Runnables/TwitchMessageReceiver.h"
+#include "Containers/Ticker.h"
+#include "Data/TwitchCooldownFilter.h"
+#include "Data/TwitchLatencyHistogram.h"
+#include "Emotes/TwitchEmoteCounter.h"
+#include "Network/TwitchConnectionPool.h"
+#include "Parsing/TwitchCommandMatcher.h"
+#include "Polls/TwitchPoll.h"
 #include "Subsystems/GameInstanceSubsystem.h"
 #include "TwitchSubsystem.generated.h"
 
@@ -14,6 +20,7 @@
 */
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FTwitchMessageReceived, const FTwitchChatMessage&, Message);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FTwitchConnectionMessage, const ETwitchConnectionMessageType, Type, const FString&, Message);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FTwitchPollUpdated, const FTwitchPollResults&, Results);
 
 
 /**
@@ -25,6 +32,69 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FTwitchConnectionMessage, const ETw
 */
 DECLARE_DYNAMIC_DELEGATE_ThreeParams(FOnCommandReceived, const FString&, CommandName, const TArray<FString>&, CommandOptions, const FString&, SenderUsername);
 
+// Commands registered for a single channel
+USTRUCT()
+struct FTwitchChannelCommands
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TMap<FString, FOnCommandReceived> BoundEvents;
+};
+
+/**
+ * Command handling of the delivered chat messages, shared by UTwitchSubsystem and the benchmarks.
+ * Finds the command of a message, prefers the registration of the message channel over the global one, checks the
+ * cooldowns, splits the options and fires the callback. The registrations stay with the owner, they are compiled
+ * again on the first message after Invalidate. Game thread only.
+ */
+class TWITCHPLAY_API FTwitchCommandDispatcher
+{
+public:
+
+	FTwitchCommandDispatcher(const TMap<FString, FOnCommandReceived>& InBoundEvents, const TMap<FString, FTwitchChannelCommands>& InChannelBoundEvents, const TMap<FString, FString>& InCommandAliases);
+
+	// The registered commands, their aliases or the way they are written changed
+	void Invalidate()
+	{
+		bMatcherDirty = true;
+	}
+
+	/**
+	* Fires the command of a chat message, if it is registered and not cooling down.
+	*
+	* @param Message - The delivered message
+	* @param CommandDelimiter - Command encapsulation characters
+	* @param OptionsDelimiter - Options encapsulation characters
+	* @param bCaseSensitive - If false, commands and aliases match regardless of case
+	* @param Cooldowns - The cooldown durations
+	* @return True if the message had a registered command that was not cooling down
+	*/
+	bool Dispatch(const FTwitchChatMessage& Message, const FString& CommandDelimiter, const FString& OptionsDelimiter, bool bCaseSensitive, const FTwitchCommandCooldowns& Cooldowns);
+
+private:
+
+	// Compiles the registered commands and aliases into CommandMatcher
+	void RebuildMatcher(const FString& CommandDelimiter, bool bCaseSensitive);
+
+	const TMap<FString, FOnCommandReceived>& BoundEvents;
+
+	const TMap<FString, FTwitchChannelCommands>& ChannelBoundEvents;
+
+	const TMap<FString, FString>& CommandAliases;
+
+	// Finds the registered commands in the chat messages
+	FTwitchCommandMatcher CommandMatcher;
+
+	// Command names, indexed by the values CommandMatcher returns. A name keeps its index once given one, even when unregistered
+	TArray<FString> MatcherCommandNames;
+
+	bool bMatcherDirty;
+
+	// Cooldowns of the commands CommandMatcher finds, indexed the same way. Kept when the matcher is rebuilt
+	FTwitchCooldownFilter CooldownFilter;
+};
+
 /**
  * 
  */
@@ -33,6 +103,9 @@ class TWITCHPLAY_API UTwitchSubsystem : public UGameInstanceSubsystem
 {
 	GENERATED_BODY()
 
+	// Splits the command options with GetDelimitedString
+	friend class FTwitchCommandDispatcher;
+
 public:
 
 	// Event called each time a message is received
@@ -45,12 +118,74 @@ public:
 	UPROPERTY(BlueprintAssignable, Category = "Twitch|Message Events")
 	FTwitchConnectionMessage OnConnectionMessage;
 
-	// The seconds delay between sending chat messages. This is set to a safe time by default, but if your bot has elevated
-	// permissions you might be able to set this to a shorter time.
+	// Event called at most once per frame while a poll is open, when votes were counted since the last frame
+	UPROPERTY(BlueprintAssignable, Category = "Twitch|Poll Events")
+	FTwitchPollUpdated OnPollUpdated;
+
+	// Event called once when a poll closes, with the final results
+	UPROPERTY(BlueprintAssignable, Category = "Twitch|Poll Events")
+	FTwitchPollUpdated OnPollEnded;
+
+	// Optional minimum seconds between two chat messages, on top of the rate limits. 0 sends as fast as the limits allow
 	UPROPERTY(EditAnywhere, Category = "Twitch|Setup")
 	float TimeBetweenChatMessages;
 
+	// Twitch chat rate limits for the bot account. Messages over the limit wait in the sending queue
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Twitch|Setup")
+	FTwitchRateLimits RateLimits;
+
+	// Maximum number of received chat messages waiting to be delivered. Keeps memory flat if messages pile up faster than they are delivered
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Twitch|Setup")
+	int32 MaxQueuedMessages = 10000;
+
+	// What to do with new chat messages when MaxQueuedMessages is reached
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Twitch|Setup")
+	ETwitchQueueOverflowPolicy QueueOverflowPolicy = ETwitchQueueOverflowPolicy::DROP_OLDEST;
+
+	// Broadcast every raw line received from the server as a MESSAGE connection message
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Twitch|Setup")
+	bool bEchoServerMessages = false;
+
+	// Connect again when the connection is lost or Twitch asks for it. Joined channels and queued messages are kept
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Twitch|Setup")
+	bool bAutoReconnect = true;
+
+	// Upper bound for the delay between two reconnection attempts. The delay starts at a second and doubles on each failed attempt
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Twitch|Setup", meta = (EditCondition = "bAutoReconnect", ClampMin = "1"))
+	float ReconnectMaxDelaySeconds = 30.0f;
+
+	// Failed reconnection attempts before giving up and sending DISCONNECTED. 0 for no limit
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Twitch|Setup", meta = (EditCondition = "bAutoReconnect", ClampMin = "0"))
+	int32 MaxReconnectAttempts = 0;
+
+	// Chat server to connect to. Only worth changing to test against a local server, see TwitchPlay.MockServer.Start
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Twitch|Setup")
+	FString ServerHost = TEXT("irc.chat.twitch.tv");
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Twitch|Setup", meta = (ClampMin = "1", ClampMax = "65535"))
+	int32 ServerPort = 6667;
+
+	// Time resolving the server and connecting to it have, per attempt. Every address the server resolves to is tried
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Twitch|Setup", meta = (ClampMin = "0.5"))
+	float ConnectTimeoutSeconds = 10.0f;
+
+	// Head start each connection attempt has before the next address the server resolves to is tried alongside it
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Twitch|Setup", meta = (ClampMin = "0"))
+	float ConnectAttemptDelaySeconds = 0.25f;
+
+	// Bytes waiting for a socket that does not take them before new chat messages are refused. Commands are always queued
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Twitch|Setup", meta = (ClampMin = "1024"))
+	int32 MaxPendingSendBytes = 64 * 1024;
+
+	// Connections the joined channels are spread across, each with its own threads. Only worth it for hundreds of channels
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Twitch|Setup", meta = (ClampMin = "1", ClampMax = "32"))
+	int32 NumConnections = 1;
+
 	
+	// Count the emotes used in chat, see GetTopEmotes
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Twitch|Setup")
+	bool bCountEmotes = true;
+
 /////////////////// Commands	
 	
 	// Character to use for command encapsulation. Commands will be read in the form CHAR_Command_CHAR (no spaces or underscores!)
@@ -64,6 +199,14 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Twitch|Commands Setup")
 	FString OptionsEncapsulationChar = "#";
 
+	// If true, commands and aliases only match with the case they were registered with. Off, "!Jump!" fires the "jump" command
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Twitch|Commands Setup")
+	bool bCaseSensitiveCommands = false;
+
+	// Commands still cooling down are dropped before their callbacks fire
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Twitch|Commands Setup")
+	FTwitchCommandCooldowns CommandCooldowns;
+
 protected:
 
 	/**
@@ -77,13 +220,56 @@ protected:
 	UPROPERTY()
 	TMap<FString, FOnCommandReceived> BoundEvents;
 
+	/**
+	* Map of the command events bound for a specific channel, by channel name.
+	* A command registered for the channel of the message takes precedence over the same command in BoundEvents.
+	*/
+	UPROPERTY()
+	TMap<FString, FTwitchChannelCommands> ChannelBoundEvents;
+
+	// Other names of the registered commands, alias -> command
+	UPROPERTY()
+	TMap<FString, FString> CommandAliases;
+
 	
 
-	// Message receiver runnable
-	TUniquePtr<FTwitchMessageReceiver> TwitchMessageReceiver;
+	// Message receiver connections
+	TUniquePtr<FTwitchConnectionPool> ConnectionPool;
 
 private:
 
+	// Delivers what the receiver got since the last frame
+	FTSTicker::FDelegateHandle TickHandle;
+
+	// Reused every frame to pull the received chat messages
+	TArray<FTwitchReceivedMessage> ReceivedMessages;
+
+	// Every received message is delivered through this one, its strings keep their allocations
+	FTwitchChatMessage DeliveredMessage;
+
+	FTwitchEmoteCounter EmoteCounter;
+
+	// Reused for the emotes of each message
+	TArray<FTwitchEmoteRange> EmoteRanges;
+
+	// Chat latency, see GetChatLatency
+	FTwitchLatencyHistogram TwitchLatency;
+	FTwitchLatencyHistogram ParseLatency;
+	FTwitchLatencyHistogram DispatchLatency;
+	FTwitchLatencyHistogram TotalLatency;
+
+	// A capture is replayed, its tmi-sent-ts are from the time it was recorded
+	bool bReplaying = false;
+
+	// The current or last poll
+	TSharedPtr<FTwitchPoll, ESPMode::ThreadSafe> Poll;
+
+	// True until OnPollEnded is sent for Poll
+	bool bPollRunning = false;
+
+	// Reused every frame to publish the poll results
+	FTwitchPollResults PollResults;
+
 public:
 	
 	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
@@ -104,10 +290,11 @@ public:
 	 * Send a message on the connected socket
 	 * @param Message - The message
 	 * @param Channel - The channel (or user channel) to send this message to
-	 * @return Whether the message was sent to the worker thread. Check your connection callback for errors.
+	 * @param Priority - Higher priority messages are sent first when the rate limits hold messages back
+	 * @return Whether the message was sent to the worker thread, false while the connection is too far behind to take more. Check your connection callback for errors.
 	 */
 	UFUNCTION(BlueprintCallable, Category = "Twitch|Messages")
-	bool SendChatMessage(const FString& Message, const FString Channel = "");
+	bool SendChatMessage(const FString& Message, const FString Channel = "", const ETwitchMessagePriority Priority = ETwitchMessagePriority::NORMAL);
 
 	/**
 	* Send a whisper message to a specific user on a channel on the connected socket
@@ -117,17 +304,37 @@ public:
 	* @param Username - The user to whisper to
 	* @param Message - The message
 	* @param Channel - The channel (or user channel) to send this message to
-	* @return Whether the message was sent to the worker thread. Check your connection callback for errors.
+	* @param Priority - Higher priority messages are sent first when the rate limits hold messages back
+	* @return Whether the message was sent to the worker thread, false while the connection is too far behind to take more. Check your connection callback for errors.
 	*/
 	UFUNCTION(BlueprintCallable, Category = "Twitch|Messages")
-	bool SendWhisper(const FString& Username, const FString& Message, const FString Channel = "");
+	bool SendWhisper(const FString& Username, const FString& Message, const FString Channel = "", const ETwitchMessagePriority Priority = ETwitchMessagePriority::NORMAL);
 
 	/**
-	 * If connected, join a new channel. If already in a channel, will leave it before joining the new one.
+	 * If connected, join a new channel. Channels already joined stay joined, messages from all of them are received.
+	 * Joins are batched and paced to the Twitch join rate limit.
 	 */
 	UFUNCTION(BlueprintCallable, Category = "Twitch|Setup")
 	void JoinChannel(const FString& Channel);
 
+	/**
+	 * If connected, join several channels at once. See JoinChannel.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Twitch|Setup")
+	void JoinChannels(const TArray<FString>& Channels);
+
+	/**
+	 * If connected, leave a joined channel.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Twitch|Setup")
+	void LeaveChannel(const FString& Channel);
+
+	/**
+	 * The channels joined, or being joined. The first one is where chat messages without a channel go.
+	 */
+	UFUNCTION(BlueprintPure, Category = "Twitch|Info")
+	TArray<FString> GetJoinedChannels() const;
+
 	/**
 	 * If connected, disconnects
 	 */
@@ -148,12 +355,125 @@ public:
 	bool IsPendingConnection() const;
 
 	/**
-	 * Get the current connection info
+	 * Get the current connection info. OutChannel is the first joined channel
 	 * returns false if not connected
 	 */
 	UFUNCTION(BlueprintPure, Category = "Twitch|Info")
     bool GetConnectionInfo(FString& OutOAuth, FString& OutUsername, FString& OutChannel) const;
 
+	/**
+	 * The number of received chat messages dropped because the queue was full (see MaxQueuedMessages)
+	 */
+	UFUNCTION(BlueprintPure, Category = "Twitch|Info")
+	int64 GetDroppedMessageCount() const;
+
+	/**
+	 * Seconds between losing the connection and being connected again, for the last reconnection. 0 if the connection was never lost
+	 */
+	UFUNCTION(BlueprintPure, Category = "Twitch|Info")
+	float GetLastReconnectSeconds() const;
+
+	/**
+	 * Receive and send pipeline counters summed over all the connections, for ops overlays.
+	 * Also shown by "stat TwitchPlay", and traced on the TwitchPlay Unreal Insights channel
+	 */
+	UFUNCTION(BlueprintPure, Category = "Twitch|Info")
+	FTwitchPipelineStats GetPipelineStats() const;
+
+/////////////////// Capture
+
+	/**
+	* Plays a capture file instead of connecting, for offline and load testing. Messages, commands and polls work as
+	* if the recorded traffic was received live. Nothing is sent to Twitch.
+	*
+	* @param CaptureFile - The capture file, see StartCapture
+	* @param Speed - Replay speed factor, 2 plays twice as fast. 0 plays as fast as the messages can be parsed
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Twitch|Capture")
+	void StartReplay(const FString& CaptureFile, float Speed = 1.0f);
+
+	/**
+	* Records the raw data received from Twitch to a file, until StopCapture or Disconnect.
+	* With several connections each one gets its own file, suffixed with the connection index.
+	*
+	* @param CaptureFile - The capture file, replaced if it exists
+	*
+	* @return False if not connected or the file could not be created
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Twitch|Capture")
+	bool StartCapture(const FString& CaptureFile);
+
+	UFUNCTION(BlueprintCallable, Category = "Twitch|Capture")
+	void StopCapture();
+
+	UFUNCTION(BlueprintPure, Category = "Twitch|Capture")
+	bool IsCapturing() const;
+
+/////////////////// Polls
+
+	/**
+	* Starts a chat poll, replacing any poll still open. A chat message is a vote when its first word is an option, ignoring case.
+	* Each user has a single vote. Votes are counted natively, results come through OnPollUpdated and OnPollEnded.
+	*
+	* @param Options - What chat can vote for. Each option is a single word, like "1", "2" or "left", "right".
+	* @param DurationSeconds - How long the poll is open. 0 to keep it open until EndPoll is called.
+	* @param bAllowVoteChange - Whether voting again moves the user vote to the new option.
+	*
+	* @return Whether the poll started. It needs at least one option.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Twitch|Poll")
+	bool StartPoll(const TArray<FString>& Options, float DurationSeconds, bool bAllowVoteChange = true);
+
+	/**
+	* Closes the poll before its time is over. OnPollEnded is called on the next frame.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Twitch|Poll")
+	void EndPoll();
+
+	UFUNCTION(BlueprintPure, Category = "Twitch|Poll")
+	bool IsPollOpen() const;
+
+	/**
+	* The results of the current or last poll.
+	*
+	* @return False if no poll was started.
+	*/
+	UFUNCTION(BlueprintPure, Category = "Twitch|Poll")
+	bool GetPollResults(FTwitchPollResults& OutResults) const;
+
+
+/////////////////// Emotes
+
+	/**
+	* Gets the emotes used the most in chat since the connection started or the counts were reset.
+	* Counts are approximate once many different emotes were used, see FTwitchEmoteCount::MaxError.
+	*
+	* @param Count - How many emotes at most.
+	*
+	* @return The emotes, most used first.
+	*/
+	UFUNCTION(BlueprintPure, Category = "Twitch|Emotes")
+	TArray<FTwitchEmoteCount> GetTopEmotes(int32 Count = 10) const;
+
+	UFUNCTION(BlueprintCallable, Category = "Twitch|Emotes")
+	void ResetEmoteCounts();
+
+
+/////////////////// Latency
+
+	/**
+	* Gets where the time went between viewers sending chat messages and the game handling them, since the
+	* connection started or the latency was reset: Twitch, our parsing, and the wait for the game thread.
+	* Twitch and Total are not measured when replaying a capture.
+	*
+	* @return p50, p95, p99 and max of each part, in milliseconds.
+	*/
+	UFUNCTION(BlueprintPure, Category = "Twitch|Info")
+	FTwitchChatLatency GetChatLatency() const;
+
+	UFUNCTION(BlueprintCallable, Category = "Twitch|Info")
+	void ResetChatLatency();
+
 
 /////////////////// Commands
 
@@ -166,6 +486,33 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Twitch|Commands")
 	void SetupEncapsulationChars(const FString& CommandChar, const FString& OptionsChar);
 
+	/**
+	* Sets whether commands and aliases match regardless of case.
+	*
+	* @param bCaseSensitive - False to ignore the case of the commands in chat.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Twitch|Commands")
+	void SetCommandsCaseSensitive(bool bCaseSensitive);
+
+	/**
+	* Adds another name for a command. The command callback receives the command name, not the alias.
+	*
+	* @param Alias - The other name, as typed in chat.
+	* @param CommandName - The command it fires. It can be registered before or after the alias.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Twitch|Commands")
+	void RegisterCommandAlias(const FString& Alias, const FString& CommandName);
+
+	/**
+	* Removes a command alias.
+	*
+	* @param Alias - The alias to remove.
+	*
+	* @return Whether the alias was registered.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Twitch|Commands")
+	bool UnregisterCommandAlias(const FString& Alias);
+
 	/**
 	* Registers a command to receive an event whenever that command is called via chat.
 	* Only one function associated with a single object can be registered per command (as a delegate pointer!).
@@ -175,29 +522,36 @@ public:
 	*
 	* @param CommandName - The command to register (CASE SENSITIVE).
 	* @param Callback - The function to fire when the event rises.
+	* @param Channel - Only fire for messages from this channel. Empty for all channels.
 	*
 	* @return Whether the registration was successfully completed.
 	*/
 	UFUNCTION(BlueprintCallable, Category = "Twitch|Commands")
-	bool RegisterCommand(const FString& CommandName, const FOnCommandReceived& Callback);
+	bool RegisterCommand(const FString& CommandName, const FOnCommandReceived& Callback, const FString& Channel = "");
 
 	/**
 	* Unregisters a command to stop receiving events whenever that command is called via chat.
 	* Keep in mind that since each command can only be bound to a single function (and single object) unregistering that command will remove any function from any object.
 	*
 	* @param CommandName - The command to unregister (CASE SENSITIVE).
+	* @param Channel - The channel the command was registered for. Empty for a command registered for all channels.
 	*
 	* @return Whether the unregistration was successfully completed.
 	*/
 	UFUNCTION(BlueprintCallable, Category = "Twitch|Commands")
-	bool UnregisterCommand(const FString& CommandName);
+	bool UnregisterCommand(const FString& CommandName, const FString& Channel = "");
 
 	UFUNCTION(BlueprintCallable, Category = "Twitch|Commands")
 	void UnregisterAllCommands();
 
+	// Names of the commands registered for all channels
 	UFUNCTION(BlueprintPure, Category = "Twitch|Commands")
 	TArray<FString> GetAllCommandNames() const;
 
+	// Names of the commands registered for a single channel
+	UFUNCTION(BlueprintPure, Category = "Twitch|Commands")
+	TArray<FString> GetChannelCommandNames(const FString& Channel) const;
+
 protected:
 
 	/**
@@ -211,16 +565,29 @@ protected:
 	UFUNCTION()
 	void MessageReceivedHandler(const FTwitchChatMessage& Message);
 
-	static FString GetDelimitedString(const FString & InString, const FString & Delimiter);
-
 	/**
-	* Parses the message and returns any command associated with the message.
+	* Finds the first string enclosed by a delimiter, as in "!jump!" or "#1,2#".
 	*
-	* @param Message - The message to parse.
+	* @param InString - The string to search
+	* @param Delimiter - The encapsulation characters
 	*
-	* @return The command found, if any. Returns "" if no command was found.
+	* @return The enclosed string, empty if there is none.
 	*/
-	FString GetCommandString(const FString& Message) const;
+	static FString GetDelimitedString(const FString& InString, const FString& Delimiter);
+
+	/**
+	* Pulls everything the receiver thread queued since the last frame and broadcasts it, all on the game thread.
+	*
+	* @param DeltaTime - Time since the last tick
+	* @return True to keep ticking
+	*/
+	bool Tick(float DeltaTime);
+
+	// Receiver settings from the subsystem properties
+	FTwitchReceiverSettings MakeReceiverSettings() const;
+
+	// Detaches the poll from the receivers and sends OnPollEnded
+	void FinishPoll(double Now);
 
 	/**
 	* Parses the message and returns any command options associated with the message.
@@ -232,5 +599,7 @@ protected:
 	void GetCommandOptionsStrings(const FString& Message, TArray<FString>& OutOptions) const;
 
 private:
-	
+
+	// Fires the registered commands found in the chat messages
+	FTwitchCommandDispatcher CommandDispatcher { BoundEvents, ChannelBoundEvents, CommandAliases };
 };
@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+
+// "stat TwitchPlay" in the console
+DECLARE_STATS_GROUP(TEXT("TwitchPlay"), STATGROUP_TwitchPlay, STATCAT_Advanced);
+
+// Receiving thread
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Receive"), STAT_TwitchPlay_Receive, STATGROUP_TwitchPlay, TWITCHPLAY_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Frame"), STAT_TwitchPlay_Frame, STATGROUP_TwitchPlay, TWITCHPLAY_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Parse"), STAT_TwitchPlay_Parse, STATGROUP_TwitchPlay, TWITCHPLAY_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Bytes Received"), STAT_TwitchPlay_BytesReceived, STATGROUP_TwitchPlay, TWITCHPLAY_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Lines Received"), STAT_TwitchPlay_LinesReceived, STATGROUP_TwitchPlay, TWITCHPLAY_API);
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("Parse Time Per Line (us)"), STAT_TwitchPlay_ParseMicrosPerLine, STATGROUP_TwitchPlay, TWITCHPLAY_API);
+
+// Game thread
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Dispatch"), STAT_TwitchPlay_Dispatch, STATGROUP_TwitchPlay, TWITCHPLAY_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Messages Delivered"), STAT_TwitchPlay_MessagesDelivered, STATGROUP_TwitchPlay, TWITCHPLAY_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Receive Queue Depth"), STAT_TwitchPlay_ReceiveQueueDepth, STATGROUP_TwitchPlay, TWITCHPLAY_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Messages Dropped"), STAT_TwitchPlay_MessagesDropped, STATGROUP_TwitchPlay, TWITCHPLAY_API);
+
+// Sending thread
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Send"), STAT_TwitchPlay_Send, STATGROUP_TwitchPlay, TWITCHPLAY_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Send Queue Depth"), STAT_TwitchPlay_SendQueueDepth, STATGROUP_TwitchPlay, TWITCHPLAY_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Outbound Tokens"), STAT_TwitchPlay_OutboundTokens, STATGROUP_TwitchPlay, TWITCHPLAY_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Pending Send Bytes"), STAT_TwitchPlay_PendingSendBytes, STATGROUP_TwitchPlay, TWITCHPLAY_API);
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("Send Queue Wait (ms)"), STAT_TwitchPlay_SendWaitMilliseconds, STATGROUP_TwitchPlay, TWITCHPLAY_API);
+
+// Unreal Insights channel of the TwitchPlay events, enabled with -trace=cpu,TwitchPlay
+UE_TRACE_CHANNEL_EXTERN(TwitchPlayChannel, TWITCHPLAY_API);
+
+// Scoped stat and Insights event, named "TwitchPlay.<Name>" in the trace
+#define TWITCHPLAY_SCOPE(Name, Stat) \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL_STR("TwitchPlay." Name, TwitchPlayChannel); \
+	SCOPE_CYCLE_COUNTER(Stat)
@@ -10,6 +10,9 @@ public class TwitchPlay: ModuleRules
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 		bEnforceIWYU = true;
 		bUseUnity = false;
+
+		// Loopback mock Twitch IRC server and its console commands, for offline testing
+		PublicDefinitions.Add("WITH_TWITCHPLAY_MOCK_SERVER=" + (Target.Configuration != UnrealTargetConfiguration.Shipping ? "1" : "0"));
 		
 
 		PublicDependencyModuleNames.AddRange(